@@ -0,0 +1,174 @@
+#include <glib.h>
+#include <json-glib/json-glib.h>
+#include <string.h>
+#include "challenge.h"
+#include "sha256.h"
+
+// Offline benchmark for the Cap challenge solver. The golden vectors are
+// checked first so a faster but wrong solver never reports numbers, then
+// each stage is timed for a matrix of salt lengths and difficulties.
+//
+// Usage: bench_challenge [path/to/challenge_vectors.json]
+
+#define DEFAULT_VECTORS "testdata/challenge_vectors.json"
+#define PRNG_CALLS 200000
+#define SCAN_NONCES 4000000
+#define SOLVE_COUNT 4
+
+static const int salt_lengths[] = { 16, 32, 64, 128 };
+static const int difficulties[] = { 2, 4, 6 };
+
+static gdouble seconds_since(gint64 started) {
+    return MAX(g_get_monotonic_time() - started, 1) / (gdouble)G_USEC_PER_SEC;
+}
+
+// Solves a challenge and returns the number of nonces a sequential search
+// would have hashed, or 0 on failure
+static guint64 solve_and_count(const gchar *challenge_json, const gchar *token, JsonArray *expected, gboolean *matches) {
+    gchar *solutions_json = solve_challenge(challenge_json, token);
+    guint64 hashes = 0;
+
+    if (matches) *matches = FALSE;
+    if (!solutions_json) return 0;
+
+    JsonParser *parser = json_parser_new();
+    if (json_parser_load_from_data(parser, solutions_json, -1, NULL)) {
+        JsonArray *solutions = json_node_get_array(json_parser_get_root(parser));
+        guint length = json_array_get_length(solutions);
+
+        if (matches) *matches = expected && json_array_get_length(expected) == length;
+        for (guint i = 0; i < length; i++) {
+            gint64 nonce = json_array_get_int_element(solutions, i);
+            hashes += (guint64)nonce + 1;
+            if (matches && *matches && json_array_get_int_element(expected, i) != nonce) {
+                *matches = FALSE;
+            }
+        }
+    }
+
+    g_object_unref(parser);
+    g_free(solutions_json);
+    return hashes;
+}
+
+static gboolean verify_vectors(const gchar *path) {
+    JsonParser *parser = json_parser_new();
+    GError *error = NULL;
+    gboolean all_ok = TRUE;
+
+    if (!json_parser_load_from_file(parser, path, &error)) {
+        g_printerr("Cannot load %s: %s\n", path, error->message);
+        g_error_free(error);
+        g_object_unref(parser);
+        return FALSE;
+    }
+
+    JsonArray *vectors = json_node_get_array(json_parser_get_root(parser));
+    g_print("Golden vectors (%s)\n", path);
+    for (guint i = 0; i < json_array_get_length(vectors); i++) {
+        JsonObject *vector = json_array_get_object_element(vectors, i);
+        const gchar *token = json_object_get_string_member(vector, "token");
+        gchar *challenge_json = json_to_string(json_object_get_member(vector, "challenge"), FALSE);
+        gboolean matches;
+
+        solve_and_count(challenge_json, token, json_object_get_array_member(vector, "solutions"), &matches);
+        g_print("  %-16s %-28s %s\n", token, challenge_json, matches ? "ok" : "MISMATCH");
+        all_ok = all_ok && matches;
+
+        g_free(challenge_json);
+    }
+
+    g_object_unref(parser);
+    return all_ok;
+}
+
+static void bench_prng(void) {
+    g_print("\ncap_prng_gen\n");
+    for (guint i = 0; i < G_N_ELEMENTS(salt_lengths); i++) {
+        gint64 started = g_get_monotonic_time();
+        for (int n = 0; n < PRNG_CALLS; n++) {
+            gchar seed[32];
+            g_snprintf(seed, sizeof(seed), "bench-token%d", n);
+            g_free(cap_prng_gen(seed, salt_lengths[i]));
+        }
+        g_print("  s=%-4d %8.0f ns/call\n", salt_lengths[i], seconds_since(started) * 1e9 / PRNG_CALLS);
+    }
+}
+
+static void bench_pow_scan(void) {
+    guint n_kernels;
+    const struct Sha256Kernel *kernels = sha256_get_supported_kernels(&n_kernels);
+
+    g_print("\nchallenge_pow_scan, single thread, kernel %s (supported:", sha256_get_kernel()->name);
+    for (guint i = 0; i < n_kernels; i++) {
+        g_print(" %s", kernels[i].name);
+    }
+    g_print(")\n");
+
+    // 32 zero bytes never match, so the whole range is scanned
+    const gchar *target_hex = "0000000000000000000000000000000000000000000000000000000000000000";
+    for (guint i = 0; i < G_N_ELEMENTS(salt_lengths); i++) {
+        gchar *salt = cap_prng_gen("bench-salt", salt_lengths[i]);
+        guint64 nonce;
+
+        gint64 started = g_get_monotonic_time();
+        challenge_pow_scan(salt, target_hex, 0, SCAN_NONCES, &nonce);
+        g_print("  s=%-4d %8.2f Mhash/s\n", salt_lengths[i], SCAN_NONCES / seconds_since(started) / 1e6);
+
+        g_free(salt);
+    }
+}
+
+static void bench_solve(void) {
+    guint n_cpus = MAX(g_get_num_processors(), 1);
+    GArray *thread_counts = g_array_new(FALSE, FALSE, sizeof(guint));
+
+    for (guint t = 1; t < n_cpus; t *= 2) {
+        g_array_append_val(thread_counts, t);
+    }
+    g_array_append_val(thread_counts, n_cpus);
+
+    g_print("\nsolve_challenge, c=%d\n", SOLVE_COUNT);
+    g_print("  %-6s %-4s %-8s %12s %14s %9s\n", "s", "d", "threads", "ms", "Mhash/s", "speedup");
+
+    for (guint si = 0; si < G_N_ELEMENTS(salt_lengths); si++) {
+        for (guint di = 0; di < G_N_ELEMENTS(difficulties); di++) {
+            gchar *challenge_json = g_strdup_printf("{\"c\": %d, \"s\": %d, \"d\": %d}",
+                                                    SOLVE_COUNT, salt_lengths[si], difficulties[di]);
+            gdouble single_thread = 0;
+
+            for (guint ti = 0; ti < thread_counts->len; ti++) {
+                guint threads = g_array_index(thread_counts, guint, ti);
+                challenge_set_thread_count(threads);
+
+                gint64 started = g_get_monotonic_time();
+                guint64 hashes = solve_and_count(challenge_json, "bench-token", NULL, NULL);
+                gdouble elapsed = seconds_since(started);
+                if (ti == 0) single_thread = elapsed;
+
+                g_print("  %-6d %-4d %-8u %12.1f %14.2f %8.2fx\n", salt_lengths[si], difficulties[di],
+                        threads, elapsed * 1000, hashes / elapsed / 1e6, single_thread / elapsed);
+            }
+
+            g_free(challenge_json);
+        }
+    }
+
+    challenge_set_thread_count(0);
+    g_array_free(thread_counts, TRUE);
+}
+
+int main(int argc, char **argv) {
+    const gchar *vectors = argc > 1 ? argv[1] : DEFAULT_VECTORS;
+
+    if (!verify_vectors(vectors)) {
+        g_printerr("Solver does not reproduce the golden vectors, not benchmarking.\n");
+        return 1;
+    }
+
+    bench_prng();
+    bench_pow_scan();
+    bench_solve();
+
+    return 0;
+}
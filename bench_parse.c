@@ -0,0 +1,203 @@
+#include <glib.h>
+#include <string.h>
+#include "json_utils.h"
+
+// Offline benchmark for the result containers of the parsers. The parsers
+// used to build every list with g_list_append(), which walks the whole list
+// on each call, and the views walked the nodes back; they now fill a
+// GPtrArray and the views index into it. Both are timed here on the same
+// items, then the parsers themselves on generated responses.
+//
+// Usage: bench_parse
+
+#define ROUNDS 20
+
+static const guint item_counts[] = { 1000, 10000 };
+
+// Keeps the walks from being optimised away
+static volatile gint64 sink;
+
+static gdouble seconds_since(gint64 started) {
+    return MAX(g_get_monotonic_time() - started, 1) / (gdouble)G_USEC_PER_SEC;
+}
+
+static gint64 walk_list(GList *list) {
+    gint64 sum = 0;
+    for (GList *l = list; l != NULL; l = l->next) {
+        sum += ((struct Tweet *)l->data)->like_count;
+    }
+    return sum;
+}
+
+static gint64 walk_list_reverse(GList *list) {
+    gint64 sum = 0;
+    for (GList *l = g_list_last(list); l != NULL; l = l->prev) {
+        sum += ((struct Tweet *)l->data)->like_count;
+    }
+    return sum;
+}
+
+static gint64 walk_array(GPtrArray *array) {
+    gint64 sum = 0;
+    for (guint i = 0; i < array->len; i++) {
+        sum += ((struct Tweet *)g_ptr_array_index(array, i))->like_count;
+    }
+    return sum;
+}
+
+static gint64 walk_array_reverse(GPtrArray *array) {
+    gint64 sum = 0;
+    for (guint i = array->len; i > 0; i--) {
+        sum += ((struct Tweet *)g_ptr_array_index(array, i - 1))->like_count;
+    }
+    return sum;
+}
+
+struct ContainerTimes {
+    gdouble build;
+    gdouble walk;
+    gdouble walk_reverse;
+};
+
+static void print_times(guint n, const gchar *name, const struct ContainerTimes *times) {
+    g_print("  %-7u %-22s %12.1f %12.1f %12.1f\n", n, name,
+            times->build * 1e6, times->walk * 1e6, times->walk_reverse * 1e6);
+}
+
+static void bench_containers(void) {
+    g_print("Containers, best of %d rounds\n", ROUNDS);
+    g_print("  %-7s %-22s %12s %12s %12s\n", "items", "container", "build us", "walk us", "reverse us");
+
+    for (guint ci = 0; ci < G_N_ELEMENTS(item_counts); ci++) {
+        guint n = item_counts[ci];
+        struct Tweet *tweets = g_new0(struct Tweet, n);
+        for (guint i = 0; i < n; i++) {
+            tweets[i].like_count = (int)i;
+        }
+
+        struct ContainerTimes list = { G_MAXDOUBLE, G_MAXDOUBLE, G_MAXDOUBLE };
+        struct ContainerTimes array = list;
+        struct ContainerTimes sized = list;
+
+        for (int round = 0; round < ROUNDS; round++) {
+            // As the parsers used to build their lists
+            gint64 started = g_get_monotonic_time();
+            GList *l = NULL;
+            for (guint i = 0; i < n; i++) {
+                l = g_list_append(l, &tweets[i]);
+            }
+            list.build = MIN(list.build, seconds_since(started));
+            started = g_get_monotonic_time();
+            sink += walk_list(l);
+            list.walk = MIN(list.walk, seconds_since(started));
+            started = g_get_monotonic_time();
+            sink += walk_list_reverse(l);
+            list.walk_reverse = MIN(list.walk_reverse, seconds_since(started));
+            g_list_free(l);
+
+            // Length unknown up front, as in the streaming tweet decoder
+            started = g_get_monotonic_time();
+            GPtrArray *a = g_ptr_array_new();
+            for (guint i = 0; i < n; i++) {
+                g_ptr_array_add(a, &tweets[i]);
+            }
+            array.build = MIN(array.build, seconds_since(started));
+            started = g_get_monotonic_time();
+            sink += walk_array(a);
+            array.walk = MIN(array.walk, seconds_since(started));
+            started = g_get_monotonic_time();
+            sink += walk_array_reverse(a);
+            array.walk_reverse = MIN(array.walk_reverse, seconds_since(started));
+            g_ptr_array_unref(a);
+
+            // Sized from the JSON array, as in the json-glib parsers
+            started = g_get_monotonic_time();
+            a = g_ptr_array_new_full(n, NULL);
+            for (guint i = 0; i < n; i++) {
+                g_ptr_array_add(a, &tweets[i]);
+            }
+            sized.build = MIN(sized.build, seconds_since(started));
+            started = g_get_monotonic_time();
+            sink += walk_array(a);
+            sized.walk = MIN(sized.walk, seconds_since(started));
+            started = g_get_monotonic_time();
+            sink += walk_array_reverse(a);
+            sized.walk_reverse = MIN(sized.walk_reverse, seconds_since(started));
+            g_ptr_array_unref(a);
+        }
+
+        print_times(n, "GList, g_list_append", &list);
+        print_times(n, "GPtrArray", &array);
+        print_times(n, "GPtrArray, sized", &sized);
+        g_free(tweets);
+    }
+}
+
+static gchar* make_tweets_json(guint n) {
+    GString *json = g_string_new("{\"posts\": [");
+    for (guint i = 0; i < n; i++) {
+        g_string_append_printf(json,
+            "%s{\"id\": \"post-%u\", \"content\": \"Post number %u with some text\", "
+            "\"author\": {\"name\": \"User %u\", \"username\": \"user%u\", \"avatar\": \"/api/uploads/%u.png\"}, "
+            "\"likes\": %u, \"retweets\": 2, \"replies\": 1, \"liked_by_user\": false}",
+            i ? ", " : "", i, i, i % 50, i % 50, i % 50, i);
+    }
+    g_string_append(json, "]}");
+    return g_string_free(json, FALSE);
+}
+
+static gchar* make_users_json(guint n) {
+    GString *json = g_string_new("{\"users\": [");
+    for (guint i = 0; i < n; i++) {
+        g_string_append_printf(json,
+            "%s{\"username\": \"user%u\", \"name\": \"User %u\", \"bio\": \"Bio of user %u\", "
+            "\"avatar\": \"/api/uploads/%u.png\", \"follower_count\": %u}",
+            i ? ", " : "", i, i, i, i, i);
+    }
+    g_string_append(json, "]}");
+    return g_string_free(json, FALSE);
+}
+
+static gboolean bench_parsers(void) {
+    g_print("\nParsers, best of %d rounds\n", ROUNDS);
+    g_print("  %-7s %-22s %12s %12s\n", "items", "parser", "ms", "ns/item");
+
+    for (guint ci = 0; ci < G_N_ELEMENTS(item_counts); ci++) {
+        guint n = item_counts[ci];
+        gchar *tweets_json = make_tweets_json(n);
+        gchar *users_json = make_users_json(n);
+        gdouble tweets_time = G_MAXDOUBLE;
+        gdouble users_time = G_MAXDOUBLE;
+        gboolean ok = TRUE;
+
+        for (int round = 0; round < ROUNDS && ok; round++) {
+            gint64 started = g_get_monotonic_time();
+            struct TweetPage *page = parse_tweets(tweets_json);
+            tweets_time = MIN(tweets_time, seconds_since(started));
+            ok = page && page->tweets->len == n;
+            tweet_page_unref(page);
+
+            started = g_get_monotonic_time();
+            GPtrArray *users = parse_users(users_json);
+            users_time = MIN(users_time, seconds_since(started));
+            ok = ok && users && users->len == n;
+            free_users(users);
+        }
+
+        g_free(tweets_json);
+        g_free(users_json);
+        if (!ok) {
+            g_printerr("Parsers did not return %u items, not benchmarking.\n", n);
+            return FALSE;
+        }
+
+        g_print("  %-7u %-22s %12.2f %12.0f\n", n, "parse_tweets", tweets_time * 1000, tweets_time * 1e9 / n);
+        g_print("  %-7u %-22s %12.2f %12.0f\n", n, "parse_users", users_time * 1000, users_time * 1e9 / n);
+    }
+    return TRUE;
+}
+
+int main(void) {
+    bench_containers();
+    return bench_parsers() ? 0 : 1;
+}
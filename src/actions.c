@@ -7,25 +7,113 @@
 #include "types.h"
 #include "globals.h"
 #include "network.h"
+#include "memory_pool.h"
+#include "network_async.h"
+#include "executor.h"
+#include "outbox.h"
+#include "posting.h"
 #include "json_utils.h"
 #include "session.h"
 #include "ui_utils.h"
 #include "ui_components.h"
 #include "views.h"
 
-// Request tracking to prevent double-unref and race conditions
-static GMutex load_tweets_mutex;
+// Request tracking so results of superseded requests are discarded.
+// Completion callbacks run on the main loop, so no locking is needed.
 static guint active_tweets_request_id = 0;
-
-static GMutex load_notifications_mutex;
 static guint active_notifications_request_id = 0;
-
-static GMutex load_conversations_mutex;
 static guint active_conversations_request_id = 0;
-
-static GMutex load_messages_mutex;
 static guint active_messages_request_id = 0;
 
+// Each request generation also gets a cancellable, so starting a new one
+// aborts the transfer of the previous one instead of letting it finish.
+static GCancellable *tweets_cancellable = NULL;
+static GCancellable *notifications_cancellable = NULL;
+static GCancellable *conversations_cancellable = NULL;
+static GCancellable *messages_cancellable = NULL;
+
+// Cancels the current generation in @slot and returns a token for the next one
+static GCancellable* renew_cancellable(GCancellable **slot)
+{
+    if (*slot) {
+        g_cancellable_cancel(*slot);
+        g_object_unref(*slot);
+    }
+    *slot = g_cancellable_new();
+    return *slot;
+}
+
+// Loaders parse responses on the executor's CPU lane: a page of tweets takes
+// long enough to parse that doing it on the main loop stalls scrolling.
+// The parser fills in async_data, the main loop then builds the widgets.
+typedef void (*ResponseParser)(struct AsyncData *async_data, const gchar *json);
+typedef void (*ParsedCallback)(struct AsyncData *async_data);
+
+struct ParseJob {
+    struct AsyncData *async_data;
+    gchar *json;
+    ResponseParser parse;
+    ParsedCallback parsed;
+};
+
+static void run_parse_job(gpointer data)
+{
+    struct ParseJob *job = (struct ParseJob *)data;
+    job->parse(job->async_data, job->json);
+}
+
+static void finish_parse_job(gpointer data)
+{
+    struct ParseJob *job = (struct ParseJob *)data;
+    job->parsed(job->async_data);
+    g_free(job->json);
+    g_free(job);
+}
+
+// Parses @chunk with @parse in the background and hands @async_data to
+// @parsed on the main loop. Without a chunk (failed or cancelled request)
+// @parsed runs right away with success unset.
+static void parse_in_background(struct MemoryStruct *chunk, struct AsyncData *async_data,
+                                ResponseParser parse, ParsedCallback parsed)
+{
+    if (!chunk) {
+        async_data->success = FALSE;
+        parsed(async_data);
+        return;
+    }
+
+    struct ParseJob *job = g_new(struct ParseJob, 1);
+    job->async_data = async_data;
+    // The chunk belongs to the transfer, which other callers may share
+    job->json = g_strndup(chunk->memory, chunk->size);
+    job->parse = parse;
+    job->parsed = parsed;
+    executor_submit_full(EXECUTOR_LANE_CPU, run_parse_job, finish_parse_job, job);
+}
+
+// Loaders treat a page without posts like a failed one
+static gboolean page_has_tweets(struct TweetPage *page)
+{
+    return page && page->tweets->len > 0;
+}
+
+static gboolean array_has_items(GPtrArray *array)
+{
+    return array && array->len > 0;
+}
+
+static void parse_tweets_response(struct AsyncData *async_data, const gchar *json)
+{
+    async_data->page = parse_tweets(json);
+    async_data->success = page_has_tweets(async_data->page);
+}
+
+static void parse_replies_response(struct AsyncData *async_data, const gchar *json)
+{
+    async_data->page = parse_profile_replies(json);
+    async_data->success = page_has_tweets(async_data->page);
+}
+
 void update_login_ui()
 {
     if (g_current_username) {
@@ -49,6 +137,8 @@ void update_login_ui()
 
 void perform_logout()
 {
+    // Queued writes belong to the user logging out
+    outbox_clear();
     clear_session();
     g_free(g_auth_token);
     g_auth_token = NULL;
@@ -87,13 +177,14 @@ gboolean perform_login(const gchar *username, const gchar *password)
             struct MemoryStruct me_chunk;
             if (fetch_url(AUTH_ME_URL, &me_chunk, NULL, "GET")) {
                 parse_user_me_response(me_chunk.memory, &g_is_admin);
-                free(me_chunk.memory);
+                memory_struct_release(&me_chunk);
             }
 
             save_session(g_auth_token, g_current_username, g_is_admin);
+            outbox_resume();
             success = TRUE;
         }
-        free(chunk.memory);
+        memory_struct_release(&chunk);
     }
 
     g_free(post_data);
@@ -168,21 +259,6 @@ void on_login_clicked(GtkWidget *widget, gpointer window)
     gtk_widget_show(dialog);
 }
 
-static gboolean perform_post_tweet(const gchar *content, const gchar *reply_to_id)
-{
-    struct MemoryStruct chunk;
-    gboolean success = FALSE;
-    gchar *post_data = construct_tweet_payload(content, reply_to_id);
-
-    if (fetch_url(POST_TWEET_URL, &chunk, post_data, "POST")) {
-        success = TRUE;
-        free(chunk.memory);
-    }
-    
-    g_free(post_data);
-    return success;
-}
-
 void on_compose_response(GtkDialog *dialog, gint response_id, gpointer user_data)
 {
     if (response_id == GTK_RESPONSE_ACCEPT) {
@@ -193,17 +269,7 @@ void on_compose_response(GtkDialog *dialog, gint response_id, gpointer user_data
         gchar *content = gtk_text_buffer_get_text(buffer, &start, &end, FALSE);
 
         if (content && strlen(content) > 0) {
-             if (perform_post_tweet(content, NULL)) {
-                start_loading_tweets(GTK_LIST_BOX(g_main_list_box));
-             } else {
-                GtkWidget *error_dialog = gtk_message_dialog_new(GTK_WINDOW(dialog),
-                                         GTK_DIALOG_DESTROY_WITH_PARENT,
-                                         GTK_MESSAGE_ERROR,
-                                         GTK_BUTTONS_CLOSE,
-                                         "Failed to post tweet.");
-                gtk_dialog_run(GTK_DIALOG(error_dialog));
-                gtk_widget_destroy(error_dialog);
-             }
+            posting_send_tweet(content, NULL, NULL, GTK_LIST_BOX(g_main_list_box), 0);
         }
         g_free(content);
     }
@@ -232,29 +298,22 @@ void on_compose_clicked(GtkWidget *widget, gpointer window)
     g_signal_connect(dialog, "response", G_CALLBACK(on_compose_response), text_view);
 }
 
-static gboolean on_tweets_loaded(gpointer data)
+static void on_tweets_parsed(struct AsyncData *async_data)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    
-    // Check if this is still the active request
-    g_mutex_lock(&load_tweets_mutex);
-    gboolean is_active = (async_data->request_id == active_tweets_request_id);
-    g_mutex_unlock(&load_tweets_mutex);
-    
-    if (!is_active) {
-        // This request was superseded, discard it
-        if (async_data->tweets) {
-            free_tweets(async_data->tweets);
-        }
+    // Check if this is still the active request; a newer one may also have
+    // started while the response was being parsed
+    if (async_data->request_id != active_tweets_request_id) {
+        tweet_page_unref(async_data->page);
+        g_free(async_data->username);
         g_free(async_data->before_id);
         g_free(async_data);
-        return G_SOURCE_REMOVE;
+        return;
     }
-    
+
     // Clear loading state on the list box
     g_object_set_data(G_OBJECT(async_data->list_box), "loading_more", GINT_TO_POINTER(FALSE));
 
-    if (async_data->success && async_data->tweets) {
+    if (async_data->success) {
         if (async_data->is_append) {
             // Remove the "loading more" indicator if it exists
             GList *children = gtk_container_get_children(GTK_CONTAINER(async_data->list_box));
@@ -267,22 +326,20 @@ static gboolean on_tweets_loaded(gpointer data)
             }
             g_list_free(children);
 
-            append_tweets_to_list(async_data->list_box, async_data->tweets);
+            append_tweets_to_list(async_data->list_box, async_data->page->tweets);
         } else {
-            populate_tweet_list(async_data->list_box, async_data->tweets);
+            populate_tweet_list(async_data->list_box, async_data->page->tweets);
         }
 
         // Update last_id for infinite scrolling
-        GList *last = g_list_last(async_data->tweets);
-        if (last) {
-            struct Tweet *last_tweet = (struct Tweet *)last->data;
+        GPtrArray *tweets = async_data->page->tweets;
+        if (tweets->len > 0) {
+            struct Tweet *last_tweet = g_ptr_array_index(tweets, tweets->len - 1);
             g_object_set_data_full(G_OBJECT(async_data->list_box), "last_id", g_strdup(last_tweet->id), g_free);
         } else {
             // No more tweets, clear last_id to stop infinite scroll attempts
             g_object_set_data(G_OBJECT(async_data->list_box), "last_id", NULL);
         }
-
-        free_tweets(async_data->tweets);
     } else {
         if (!async_data->is_append) {
             GList *children = gtk_container_get_children(GTK_CONTAINER(async_data->list_box));
@@ -307,15 +364,31 @@ static gboolean on_tweets_loaded(gpointer data)
         }
     }
 
+    tweet_page_unref(async_data->page);
+    g_free(async_data->username);
     g_free(async_data->before_id);
     g_free(async_data);
-    return G_SOURCE_REMOVE;
 }
 
-static gpointer fetch_tweets_thread(gpointer data)
+static void on_tweets_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
+    (void)response_code;
     struct AsyncData *async_data = (struct AsyncData *)data;
-    struct MemoryStruct chunk;
+
+    // A superseded request is discarded without parsing
+    if (async_data->request_id != active_tweets_request_id) {
+        on_tweets_parsed(async_data);
+        return;
+    }
+
+    const gchar *feed_type = g_object_get_data(G_OBJECT(async_data->list_box), "feed_type");
+    parse_in_background(chunk, async_data,
+                        g_strcmp0(feed_type, "profile_replies") == 0 ? parse_replies_response : parse_tweets_response,
+                        on_tweets_parsed);
+}
+
+static void fetch_tweets(struct AsyncData *async_data)
+{
     gchar *url = NULL;
 
     const gchar *feed_type = g_object_get_data(G_OBJECT(async_data->list_box), "feed_type");
@@ -340,30 +413,20 @@ static gpointer fetch_tweets_thread(gpointer data)
         }
     }
 
-    if (fetch_url(url, &chunk, NULL, "GET")) {
-        if (g_strcmp0(feed_type, "profile_replies") == 0) {
-            async_data->tweets = parse_profile_replies(chunk.memory);
-        } else {
-            async_data->tweets = parse_tweets(chunk.memory);
-        }
-        async_data->success = (async_data->tweets != NULL);
-        free(chunk.memory);
-    } else {
-        async_data->success = FALSE;
+    // Pagination belongs to the current generation and is cancelled with it
+    if (!tweets_cancellable) {
+        tweets_cancellable = g_cancellable_new();
     }
-
+    fetch_url_async_full(url, NULL, "GET", REQUEST_PRIORITY_FEED, tweets_cancellable,
+                         on_tweets_loaded, async_data);
     g_free(url);
-    g_idle_add(on_tweets_loaded, async_data);
-    return NULL;
 }
 
 void start_loading_tweets(GtkListBox *list_box)
 {
-    g_mutex_lock(&load_tweets_mutex);
     // Increment request ID to invalidate any pending requests
-    active_tweets_request_id++;
-    guint current_request_id = active_tweets_request_id;
-    g_mutex_unlock(&load_tweets_mutex);
+    guint current_request_id = ++active_tweets_request_id;
+    renew_cancellable(&tweets_cancellable);
     
     // Clear the list and show loading indicator
     GList *children = gtk_container_get_children(GTK_CONTAINER(list_box));
@@ -387,14 +450,12 @@ void start_loading_tweets(GtkListBox *list_box)
         data->username = g_strdup(g_object_get_data(G_OBJECT(list_box), "current_profile_user"));
     }
 
-    g_thread_new("tweet-loader", fetch_tweets_thread, data);
+    fetch_tweets(data);
 }
 
 void load_more_tweets(GtkListBox *list_box, const gchar *before_id)
 {
-    g_mutex_lock(&load_tweets_mutex);
     guint current_request_id = active_tweets_request_id;
-    g_mutex_unlock(&load_tweets_mutex);
 
     // Show loading more indicator
     GtkWidget *loading_label = gtk_label_new("Loading more...");
@@ -411,7 +472,7 @@ void load_more_tweets(GtkListBox *list_box, const gchar *before_id)
         data->username = g_strdup(g_object_get_data(G_OBJECT(list_box), "current_profile_user"));
     }
     
-    g_thread_new("tweet-loader", fetch_tweets_thread, data);
+    fetch_tweets(data);
 }
 
 void on_scroll_edge_reached(GtkScrolledWindow *scrolled_window, GtkPositionType pos, gpointer user_data)
@@ -451,10 +512,14 @@ void on_scroll_edge_reached(GtkScrolledWindow *scrolled_window, GtkPositionType
     load_more_tweets(GTK_LIST_BOX(list_box), last_id);
 }
 
-static gboolean on_profile_loaded(gpointer data)
+static void parse_profile_response(struct AsyncData *async_data, const gchar *json)
+{
+    async_data->page = parse_profile_page(json, &async_data->profile);
+    async_data->success = (async_data->profile != NULL);
+}
+
+static void on_profile_parsed(struct AsyncData *async_data)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    
     if (async_data->success && async_data->profile) {
         gchar *stats_str = g_strdup_printf("%d Followers · %d Following · %d Posts", 
                                           async_data->profile->follower_count,
@@ -468,151 +533,116 @@ static gboolean on_profile_loaded(gpointer data)
 
         gtk_image_set_from_icon_name(GTK_IMAGE(g_profile_avatar_image), "avatar-default", GTK_ICON_SIZE_DND);
         if (async_data->profile->avatar) {
-            load_avatar(g_profile_avatar_image, async_data->profile->avatar, 80);
+            load_image(g_profile_avatar_image, async_data->profile->avatar, 80);
         }
 
-        if (async_data->tweets) {
-            populate_tweet_list(GTK_LIST_BOX(g_profile_tweets_list), async_data->tweets);
+        if (page_has_tweets(async_data->page)) {
+            populate_tweet_list(GTK_LIST_BOX(g_profile_tweets_list), async_data->page->tweets);
 
-            GList *last = g_list_last(async_data->tweets);
-            if (last) {
-                struct Tweet *last_tweet = (struct Tweet *)last->data;
+            GPtrArray *tweets = async_data->page->tweets;
+            if (tweets->len > 0) {
+                struct Tweet *last_tweet = g_ptr_array_index(tweets, tweets->len - 1);
                 g_object_set_data_full(G_OBJECT(g_profile_tweets_list), "last_id", g_strdup(last_tweet->id), g_free);
             } else {
                 g_object_set_data(G_OBJECT(g_profile_tweets_list), "last_id", NULL);
             }
-
-            free_tweets(async_data->tweets);
         }
     } else {
         gtk_label_set_text(GTK_LABEL(g_profile_name_label), "Error loading profile");
     }
+    tweet_page_unref(async_data->page);
 
     if (async_data->profile) {
-        g_free(async_data->profile->name);
-        g_free(async_data->profile->username);
-        g_free(async_data->profile->bio);
-        g_free(async_data->profile->avatar);
-        g_free(async_data->profile);
+        free_user(async_data->profile);
     }
     g_free(async_data->username);
     g_free(async_data);
-    return G_SOURCE_REMOVE;
 }
 
-static gboolean on_profile_replies_loaded(gpointer data)
+static void on_profile_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    if (async_data->success && async_data->tweets) {
-        populate_tweet_list(GTK_LIST_BOX(g_profile_replies_list), async_data->tweets);
+    (void)response_code;
+    parse_in_background(chunk, (struct AsyncData *)data, parse_profile_response, on_profile_parsed);
+}
+
+static void on_profile_replies_parsed(struct AsyncData *async_data)
+{
+    if (async_data->success) {
+        populate_tweet_list(GTK_LIST_BOX(g_profile_replies_list), async_data->page->tweets);
 
-        GList *last = g_list_last(async_data->tweets);
-        if (last) {
-            struct Tweet *last_tweet = (struct Tweet *)last->data;
+        GPtrArray *tweets = async_data->page->tweets;
+        if (tweets->len > 0) {
+            struct Tweet *last_tweet = g_ptr_array_index(tweets, tweets->len - 1);
             g_object_set_data_full(G_OBJECT(g_profile_replies_list), "last_id", g_strdup(last_tweet->id), g_free);
         } else {
             g_object_set_data(G_OBJECT(g_profile_replies_list), "last_id", NULL);
         }
-
-        free_tweets(async_data->tweets);
     }
+    tweet_page_unref(async_data->page);
     g_free(async_data);
-    return G_SOURCE_REMOVE;
 }
 
-static gpointer fetch_profile_thread(gpointer data)
+static void on_profile_replies_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    struct MemoryStruct chunk;
-    gchar *url = g_strdup_printf("%s/profile/%s", API_BASE_URL, async_data->username);
-
-    if (fetch_url(url, &chunk, NULL, "GET")) {
-        async_data->profile = parse_profile(chunk.memory);
-        async_data->tweets = parse_tweets(chunk.memory);
-        async_data->success = (async_data->profile != NULL);
-        free(chunk.memory);
-    } else {
-        async_data->success = FALSE;
-    }
-    g_free(url);
-
-    g_idle_add(on_profile_loaded, async_data);
-    return NULL;
+    (void)response_code;
+    parse_in_background(chunk, (struct AsyncData *)data, parse_replies_response, on_profile_replies_parsed);
 }
 
-static gpointer fetch_profile_replies_thread(gpointer data)
+static void parse_tweet_details_response(struct AsyncData *async_data, const gchar *json)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    struct MemoryStruct chunk;
-    gchar *url = g_strdup_printf("%s/profile/%s/replies", API_BASE_URL, async_data->username);
-
-    if (fetch_url(url, &chunk, NULL, "GET")) {
-        async_data->tweets = parse_profile_replies(chunk.memory);
-        async_data->success = (async_data->tweets != NULL);
-        free(chunk.memory);
-    } else {
-        async_data->success = FALSE;
-    }
-    g_free(url);
-    g_free(async_data->username);
-
-    g_idle_add(on_profile_replies_loaded, async_data);
-    return NULL;
+    async_data->page = parse_tweet_details(json);
+    async_data->success = page_has_tweets(async_data->page);
 }
 
-static gboolean on_tweet_loaded(gpointer data)
+static void on_tweet_parsed(struct AsyncData *async_data)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    
-    if (async_data->success && async_data->tweets) {
+    if (async_data->success) {
         GList *children = gtk_container_get_children(GTK_CONTAINER(g_conversation_list));
         for(GList *iter = children; iter != NULL; iter = g_list_next(iter))
             gtk_widget_destroy(GTK_WIDGET(iter->data));
         g_list_free(children);
 
         // Find OP username (the author of the very first tweet in the thread)
+        GPtrArray *tweets = async_data->page->tweets;
         const gchar *op_username = NULL;
-        if (async_data->tweets) {
-            struct Tweet *first_t = (struct Tweet *)async_data->tweets->data;
+        if (tweets->len > 0) {
+            struct Tweet *first_t = g_ptr_array_index(tweets, 0);
             op_username = first_t->author_username;
         }
 
         gboolean main_tweet_reached = FALSE;
-        for (GList *l = async_data->tweets; l != NULL; l = l->next) {
-            struct Tweet *t = (struct Tweet *)l->data;
+        for (guint i = 0; i < tweets->len; i++) {
+            struct Tweet *t = g_ptr_array_index(tweets, i);
             
             if (g_strcmp0(t->id, async_data->query) == 0) {
                 // This is the main tweet
-                if (!main_tweet_reached && l != async_data->tweets) {
+                if (!main_tweet_reached && i > 0) {
                      // Add a separator before the main tweet if there were parents
                      gtk_list_box_insert(GTK_LIST_BOX(g_conversation_list), gtk_separator_new(GTK_ORIENTATION_HORIZONTAL), -1);
                 }
                 main_tweet_reached = TRUE;
-            } else if (main_tweet_reached && l != async_data->tweets) {
-                GList *prev_l = g_list_previous(l);
-                if (prev_l) {
-                    struct Tweet *prev_t = (struct Tweet *)prev_l->data;
-                    if (g_strcmp0(prev_t->id, async_data->query) == 0) {
-                        // Just after the main tweet, add a "Replies" header
-                        GtkWidget *header = gtk_label_new("Replies");
-                        gtk_widget_set_margin_top(header, 10);
-                        gtk_widget_set_margin_bottom(header, 5);
-                        gtk_widget_set_halign(header, GTK_ALIGN_START);
-                        gtk_widget_set_margin_start(header, 10);
-                        PangoAttrList *attrs = pango_attr_list_new();
-                        pango_attr_list_insert(attrs, pango_attr_weight_new(PANGO_WEIGHT_BOLD));
-                        gtk_label_set_attributes(GTK_LABEL(header), attrs);
-                        pango_attr_list_unref(attrs);
-                        
-                        gtk_widget_show(header);
-                        gtk_list_box_insert(GTK_LIST_BOX(g_conversation_list), header, -1);
-                    }
+            } else if (main_tweet_reached && i > 0) {
+                struct Tweet *prev_t = g_ptr_array_index(tweets, i - 1);
+                if (g_strcmp0(prev_t->id, async_data->query) == 0) {
+                    // Just after the main tweet, add a "Replies" header
+                    GtkWidget *header = gtk_label_new("Replies");
+                    gtk_widget_set_margin_top(header, 10);
+                    gtk_widget_set_margin_bottom(header, 5);
+                    gtk_widget_set_halign(header, GTK_ALIGN_START);
+                    gtk_widget_set_margin_start(header, 10);
+                    PangoAttrList *attrs = pango_attr_list_new();
+                    pango_attr_list_insert(attrs, pango_attr_weight_new(PANGO_WEIGHT_BOLD));
+                    gtk_label_set_attributes(GTK_LABEL(header), attrs);
+                    pango_attr_list_unref(attrs);
+                    
+                    gtk_widget_show(header);
+                    gtk_list_box_insert(GTK_LIST_BOX(g_conversation_list), header, -1);
                 }
             }
 
             // Don't show OP tag on the root tweet or the main focused tweet
             const gchar *current_op = op_username;
-            if (l == async_data->tweets || g_strcmp0(t->id, async_data->query) == 0) {
+            if (i == 0 || g_strcmp0(t->id, async_data->query) == 0) {
                 current_op = NULL;
             }
 
@@ -627,8 +657,6 @@ static gboolean on_tweet_loaded(gpointer data)
             gtk_widget_show_all(tweet_widget);
             gtk_list_box_insert(GTK_LIST_BOX(g_conversation_list), tweet_widget, -1);
         }
-
-        free_tweets(async_data->tweets);
     } else {
         GList *children = gtk_container_get_children(GTK_CONTAINER(g_conversation_list));
         for(GList *iter = children; iter != NULL; iter = g_list_next(iter))
@@ -640,28 +668,15 @@ static gboolean on_tweet_loaded(gpointer data)
         gtk_list_box_insert(GTK_LIST_BOX(g_conversation_list), error_label, -1);
     }
 
+    tweet_page_unref(async_data->page);
     g_free(async_data->query); // used as tweet_id here
     g_free(async_data);
-    return G_SOURCE_REMOVE;
 }
 
-static gpointer fetch_tweet_thread(gpointer data)
+static void on_tweet_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    struct MemoryStruct chunk;
-    gchar *url = g_strdup_printf(TWEET_DETAILS_URL, async_data->query);
-
-    if (fetch_url(url, &chunk, NULL, "GET")) {
-        async_data->tweets = parse_tweet_details(chunk.memory);
-        async_data->success = (async_data->tweets != NULL);
-        free(chunk.memory);
-    } else {
-        async_data->success = FALSE;
-    }
-    g_free(url);
-
-    g_idle_add(on_tweet_loaded, async_data);
-    return NULL;
+    (void)response_code;
+    parse_in_background(chunk, (struct AsyncData *)data, parse_tweet_details_response, on_tweet_parsed);
 }
 
 void show_tweet(const gchar *tweet_id)
@@ -680,7 +695,9 @@ void show_tweet(const gchar *tweet_id)
 
     struct AsyncData *data = g_new0(struct AsyncData, 1);
     data->query = g_strdup(tweet_id); // Reusing query field
-    g_thread_new("tweet-detail-loader", fetch_tweet_thread, data);
+    gchar *url = g_strdup_printf(TWEET_DETAILS_URL, tweet_id);
+    fetch_url_async(url, NULL, "GET", on_tweet_loaded, data);
+    g_free(url);
 }
 
 void show_profile(const gchar *username)
@@ -703,11 +720,14 @@ void show_profile(const gchar *username)
 
     struct AsyncData *data = g_new0(struct AsyncData, 1);
     data->username = g_strdup(username);
-    g_thread_new("profile-loader", fetch_profile_thread, data);
+    gchar *url = g_strdup_printf("%s/profile/%s", API_BASE_URL, username);
+    fetch_url_async(url, NULL, "GET", on_profile_loaded, data);
+    g_free(url);
 
     struct AsyncData *reply_data = g_new0(struct AsyncData, 1);
-    reply_data->username = g_strdup(username);
-    g_thread_new("profile-reply-loader", fetch_profile_replies_thread, reply_data);
+    gchar *replies_url = g_strdup_printf("%s/profile/%s/replies", API_BASE_URL, username);
+    fetch_url_async(replies_url, NULL, "GET", on_profile_replies_loaded, reply_data);
+    g_free(replies_url);
 }
 
 void on_back_clicked(GtkWidget *widget, gpointer user_data)
@@ -744,25 +764,22 @@ void on_refresh_clicked(GtkWidget *widget, gpointer user_data)
     }
 }
 
-static gboolean on_notifications_loaded(gpointer data)
+static void parse_notifications_response(struct AsyncData *async_data, const gchar *json)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    
-    g_mutex_lock(&load_notifications_mutex);
-    gboolean is_active = (async_data->request_id == active_notifications_request_id);
-    g_mutex_unlock(&load_notifications_mutex);
-    
-    if (!is_active) {
-        if (async_data->notifications) {
-            free_notifications(async_data->notifications);
-        }
+    async_data->notifications = parse_notifications(json);
+    async_data->success = TRUE;
+}
+
+static void on_notifications_parsed(struct AsyncData *async_data)
+{
+    if (async_data->request_id != active_notifications_request_id) {
+        free_notifications(async_data->notifications);
         g_free(async_data);
-        return G_SOURCE_REMOVE;
+        return;
     }
 
-    if (async_data->success && async_data->notifications) {
+    if (async_data->success && array_has_items(async_data->notifications)) {
         populate_notification_list(async_data->list_box, async_data->notifications);
-        free_notifications(async_data->notifications);
     } else {
         GList *children = gtk_container_get_children(GTK_CONTAINER(async_data->list_box));
         for(GList *iter = children; iter != NULL; iter = g_list_next(iter))
@@ -774,35 +791,27 @@ static gboolean on_notifications_loaded(gpointer data)
         gtk_list_box_insert(async_data->list_box, error_label, -1);
     }
 
+    free_notifications(async_data->notifications);
     g_free(async_data);
-    return G_SOURCE_REMOVE;
 }
 
-static gpointer fetch_notifications_thread(gpointer data)
+static void on_notifications_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
+    (void)response_code;
     struct AsyncData *async_data = (struct AsyncData *)data;
-    struct MemoryStruct chunk;
 
-    if (fetch_url(NOTIFICATIONS_URL, &chunk, NULL, "GET")) {
-        async_data->notifications = parse_notifications(chunk.memory);
-        async_data->success = TRUE;
-        free(chunk.memory);
-    } else {
-        async_data->success = FALSE;
+    if (async_data->request_id != active_notifications_request_id) {
+        on_notifications_parsed(async_data);
+        return;
     }
-
-    g_idle_add(on_notifications_loaded, async_data);
-    return NULL;
+    parse_in_background(chunk, async_data, parse_notifications_response, on_notifications_parsed);
 }
 
 void start_loading_notifications(GtkListBox *list_box)
 {
     if (!g_auth_token) return;
 
-    g_mutex_lock(&load_notifications_mutex);
-    active_notifications_request_id++;
-    guint current_request_id = active_notifications_request_id;
-    g_mutex_unlock(&load_notifications_mutex);
+    guint current_request_id = ++active_notifications_request_id;
     
     GList *children = gtk_container_get_children(GTK_CONTAINER(list_box));
     for(GList *iter = children; iter != NULL; iter = g_list_next(iter))
@@ -817,7 +826,8 @@ void start_loading_notifications(GtkListBox *list_box)
     data->list_box = list_box;
     data->request_id = current_request_id;
     
-    g_thread_new("notification-loader", fetch_notifications_thread, data);
+    fetch_url_async_full(NOTIFICATIONS_URL, NULL, "GET", REQUEST_PRIORITY_FEED,
+                         renew_cancellable(&notifications_cancellable), on_notifications_loaded, data);
 }
 
 void on_notifications_clicked(GtkWidget *widget, gpointer user_data)
@@ -843,6 +853,15 @@ void on_notifications_clicked(GtkWidget *widget, gpointer user_data)
     start_loading_notifications(GTK_LIST_BOX(g_notifications_list));
 }
 
+static void on_marked_all_read(struct MemoryStruct *chunk, long response_code, gpointer data)
+{
+    (void)response_code;
+    (void)data;
+    if (chunk) {
+        start_loading_notifications(GTK_LIST_BOX(g_notifications_list));
+    }
+}
+
 void on_mark_all_read_clicked(GtkWidget *widget, gpointer user_data)
 {
     (void)widget;
@@ -850,32 +869,26 @@ void on_mark_all_read_clicked(GtkWidget *widget, gpointer user_data)
     
     if (!g_auth_token) return;
 
-    struct MemoryStruct chunk;
-    if (fetch_url(NOTIFICATIONS_MARK_ALL_READ_URL, &chunk, "", "PATCH")) {
-        free(chunk.memory);
-        start_loading_notifications(GTK_LIST_BOX(g_notifications_list));
-    }
+    fetch_url_async_full(NOTIFICATIONS_MARK_ALL_READ_URL, "", "PATCH", REQUEST_PRIORITY_INTERACTIVE, NULL,
+                         on_marked_all_read, NULL);
 }
 
-static gboolean on_conversations_loaded(gpointer data)
+static void parse_conversations_response(struct AsyncData *async_data, const gchar *json)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    
-    g_mutex_lock(&load_conversations_mutex);
-    gboolean is_active = (async_data->request_id == active_conversations_request_id);
-    g_mutex_unlock(&load_conversations_mutex);
-    
-    if (!is_active) {
-        if (async_data->conversations) {
-            free_conversations(async_data->conversations);
-        }
+    async_data->conversations = parse_conversations(json);
+    async_data->success = TRUE;
+}
+
+static void on_conversations_parsed(struct AsyncData *async_data)
+{
+    if (async_data->request_id != active_conversations_request_id) {
+        free_conversations(async_data->conversations);
         g_free(async_data);
-        return G_SOURCE_REMOVE;
+        return;
     }
 
-    if (async_data->success && async_data->conversations) {
+    if (async_data->success && array_has_items(async_data->conversations)) {
         populate_conversation_list(async_data->list_box, async_data->conversations);
-        free_conversations(async_data->conversations);
     } else {
         GList *children = gtk_container_get_children(GTK_CONTAINER(async_data->list_box));
         for(GList *iter = children; iter != NULL; iter = g_list_next(iter))
@@ -887,35 +900,27 @@ static gboolean on_conversations_loaded(gpointer data)
         gtk_list_box_insert(async_data->list_box, error_label, -1);
     }
 
+    free_conversations(async_data->conversations);
     g_free(async_data);
-    return G_SOURCE_REMOVE;
 }
 
-static gpointer fetch_conversations_thread(gpointer data)
+static void on_conversations_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
+    (void)response_code;
     struct AsyncData *async_data = (struct AsyncData *)data;
-    struct MemoryStruct chunk;
 
-    if (fetch_url(DM_CONVERSATIONS_URL, &chunk, NULL, "GET")) {
-        async_data->conversations = parse_conversations(chunk.memory);
-        async_data->success = TRUE;
-        free(chunk.memory);
-    } else {
-        async_data->success = FALSE;
+    if (async_data->request_id != active_conversations_request_id) {
+        on_conversations_parsed(async_data);
+        return;
     }
-
-    g_idle_add(on_conversations_loaded, async_data);
-    return NULL;
+    parse_in_background(chunk, async_data, parse_conversations_response, on_conversations_parsed);
 }
 
 void start_loading_conversations(GtkListBox *list_box)
 {
     if (!g_auth_token) return;
 
-    g_mutex_lock(&load_conversations_mutex);
-    active_conversations_request_id++;
-    guint current_request_id = active_conversations_request_id;
-    g_mutex_unlock(&load_conversations_mutex);
+    guint current_request_id = ++active_conversations_request_id;
     
     GList *children = gtk_container_get_children(GTK_CONTAINER(list_box));
     for(GList *iter = children; iter != NULL; iter = g_list_next(iter))
@@ -930,29 +935,27 @@ void start_loading_conversations(GtkListBox *list_box)
     data->list_box = list_box;
     data->request_id = current_request_id;
     
-    g_thread_new("conversation-loader", fetch_conversations_thread, data);
+    fetch_url_async_full(DM_CONVERSATIONS_URL, NULL, "GET", REQUEST_PRIORITY_FEED,
+                         renew_cancellable(&conversations_cancellable), on_conversations_loaded, data);
 }
 
-static gboolean on_messages_loaded(gpointer data)
+static void parse_messages_response(struct AsyncData *async_data, const gchar *json)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    
-    g_mutex_lock(&load_messages_mutex);
-    gboolean is_active = (async_data->request_id == active_messages_request_id);
-    g_mutex_unlock(&load_messages_mutex);
-    
-    if (!is_active) {
-        if (async_data->messages) {
-            free_messages(async_data->messages);
-        }
+    async_data->messages = parse_messages(json);
+    async_data->success = TRUE;
+}
+
+static void on_messages_parsed(struct AsyncData *async_data)
+{
+    if (async_data->request_id != active_messages_request_id) {
+        free_messages(async_data->messages);
         g_free(async_data->conversation_id);
         g_free(async_data);
-        return G_SOURCE_REMOVE;
+        return;
     }
 
-    if (async_data->success && async_data->messages) {
+    if (async_data->success && array_has_items(async_data->messages)) {
         populate_message_list(async_data->list_box, async_data->messages);
-        free_messages(async_data->messages);
     } else {
         GList *children = gtk_container_get_children(GTK_CONTAINER(async_data->list_box));
         for(GList *iter = children; iter != NULL; iter = g_list_next(iter))
@@ -964,38 +967,28 @@ static gboolean on_messages_loaded(gpointer data)
         gtk_list_box_insert(async_data->list_box, error_label, -1);
     }
 
+    free_messages(async_data->messages);
     g_free(async_data->conversation_id);
     g_free(async_data);
-    return G_SOURCE_REMOVE;
 }
 
-static gpointer fetch_messages_thread(gpointer data)
+static void on_messages_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
+    (void)response_code;
     struct AsyncData *async_data = (struct AsyncData *)data;
-    struct MemoryStruct chunk;
-    gchar *url = g_strdup_printf(DM_MESSAGES_URL, async_data->conversation_id);
 
-    if (fetch_url(url, &chunk, NULL, "GET")) {
-        async_data->messages = parse_messages(chunk.memory);
-        async_data->success = TRUE;
-        free(chunk.memory);
-    } else {
-        async_data->success = FALSE;
+    if (async_data->request_id != active_messages_request_id) {
+        on_messages_parsed(async_data);
+        return;
     }
-
-    g_free(url);
-    g_idle_add(on_messages_loaded, async_data);
-    return NULL;
+    parse_in_background(chunk, async_data, parse_messages_response, on_messages_parsed);
 }
 
 void start_loading_messages(GtkListBox *list_box, const gchar *conversation_id)
 {
     if (!g_auth_token) return;
 
-    g_mutex_lock(&load_messages_mutex);
-    active_messages_request_id++;
-    guint current_request_id = active_messages_request_id;
-    g_mutex_unlock(&load_messages_mutex);
+    guint current_request_id = ++active_messages_request_id;
     
     GList *children = gtk_container_get_children(GTK_CONTAINER(list_box));
     for(GList *iter = children; iter != NULL; iter = g_list_next(iter))
@@ -1011,7 +1004,10 @@ void start_loading_messages(GtkListBox *list_box, const gchar *conversation_id)
     data->request_id = current_request_id;
     data->conversation_id = g_strdup(conversation_id);
     
-    g_thread_new("message-loader", fetch_messages_thread, data);
+    gchar *url = g_strdup_printf(DM_MESSAGES_URL, conversation_id);
+    fetch_url_async_full(url, NULL, "GET", REQUEST_PRIORITY_FEED,
+                         renew_cancellable(&messages_cancellable), on_messages_loaded, data);
+    g_free(url);
 }
 
 void on_messages_clicked(GtkWidget *widget, gpointer user_data)
@@ -1045,40 +1041,37 @@ void on_settings_clicked(GtkWidget *widget, gpointer user_data)
     gtk_widget_show(g_back_button);
 }
 
-static gboolean
-on_admin_stats_loaded(gpointer data)
+static void
+parse_admin_stats_response(struct AsyncData *async_data, const gchar *json)
 {
-    gchar *stats_text = (gchar *)data;
-    if (stats_text) {
-        gtk_label_set_text(GTK_LABEL(g_admin_stats_label), stats_text);
-        g_free(stats_text);
+    async_data->query = parse_admin_stats(json); // Reusing query field for the text
+    async_data->success = (async_data->query != NULL);
+}
+
+static void
+on_admin_stats_parsed(struct AsyncData *async_data)
+{
+    if (async_data->success) {
+        gtk_label_set_text(GTK_LABEL(g_admin_stats_label), async_data->query);
     } else {
         gtk_label_set_text(GTK_LABEL(g_admin_stats_label), "Failed to load admin statistics.");
     }
-    return G_SOURCE_REMOVE;
+    g_free(async_data->query);
+    g_free(async_data);
 }
 
-static gpointer
-fetch_admin_stats_thread(gpointer data)
+static void
+on_admin_stats_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
-    (void)data;
-    struct MemoryStruct chunk;
-    gchar *stats_text = NULL;
-
-    if (fetch_url(ADMIN_STATS_URL, &chunk, NULL, "GET")) {
-        stats_text = parse_admin_stats(chunk.memory);
-        free(chunk.memory);
-    }
-
-    g_idle_add(on_admin_stats_loaded, stats_text);
-    return NULL;
+    (void)response_code;
+    parse_in_background(chunk, (struct AsyncData *)data, parse_admin_stats_response, on_admin_stats_parsed);
 }
 
 void start_loading_admin_stats()
 {
     if (!g_auth_token || !g_is_admin) return;
     gtk_label_set_text(GTK_LABEL(g_admin_stats_label), "Loading admin statistics...");
-    g_thread_new("admin-stats-loader", fetch_admin_stats_thread, NULL);
+    fetch_url_async(ADMIN_STATS_URL, NULL, "GET", on_admin_stats_loaded, g_new0(struct AsyncData, 1));
 }
 
 void on_admin_clicked(GtkWidget *widget, gpointer user_data)
@@ -1094,98 +1087,92 @@ void on_admin_clicked(GtkWidget *widget, gpointer user_data)
     start_loading_admin_posts(NULL);
 }
 
-static gboolean
-on_admin_users_loaded(gpointer data)
+static void
+parse_admin_users_response(struct AsyncData *async_data, const gchar *json)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    if (async_data->success && async_data->users) {
+    async_data->users = parse_admin_users(json);
+    async_data->success = TRUE;
+}
+
+static void
+on_admin_users_parsed(struct AsyncData *async_data)
+{
+    if (async_data->success && array_has_items(async_data->users)) {
         populate_user_list(GTK_LIST_BOX(g_admin_users_list), async_data->users);
-        free_users(async_data->users);
     } else {
         gtk_label_set_text(GTK_LABEL(g_user_label), "Failed to load admin users.");
     }
+    free_users(async_data->users);
     g_free(async_data->query);
     g_free(async_data);
-    return G_SOURCE_REMOVE;
 }
 
-static gpointer
-fetch_admin_users_thread(gpointer data)
+static void
+on_admin_users_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    struct MemoryStruct chunk;
+    (void)response_code;
+    parse_in_background(chunk, (struct AsyncData *)data, parse_admin_users_response, on_admin_users_parsed);
+}
+
+void start_loading_admin_users(const gchar *search)
+{
+    struct AsyncData *data = g_new0(struct AsyncData, 1);
+    data->query = g_strdup(search);
+
     gchar *url;
-    if (async_data->query && strlen(async_data->query) > 0) {
-        gchar *escaped = g_uri_escape_string(async_data->query, NULL, FALSE);
+    if (search && strlen(search) > 0) {
+        gchar *escaped = g_uri_escape_string(search, NULL, FALSE);
         url = g_strdup_printf("%s?search=%s", ADMIN_USERS_URL, escaped);
         g_free(escaped);
     } else {
         url = g_strdup(ADMIN_USERS_URL);
     }
 
-    if (fetch_url(url, &chunk, NULL, "GET")) {
-        async_data->users = parse_admin_users(chunk.memory);
-        async_data->success = TRUE;
-        free(chunk.memory);
-    } else {
-        async_data->success = FALSE;
-    }
+    fetch_url_async(url, NULL, "GET", on_admin_users_loaded, data);
     g_free(url);
-    g_idle_add(on_admin_users_loaded, async_data);
-    return NULL;
 }
 
-void start_loading_admin_users(const gchar *search)
+static void
+parse_admin_posts_response(struct AsyncData *async_data, const gchar *json)
 {
-    struct AsyncData *data = g_new0(struct AsyncData, 1);
-    data->query = g_strdup(search);
-    g_thread_new("admin-users-loader", fetch_admin_users_thread, data);
+    async_data->page = parse_admin_posts(json);
+    async_data->success = TRUE;
 }
 
-static gboolean
-on_admin_posts_loaded(gpointer data)
+static void
+on_admin_posts_parsed(struct AsyncData *async_data)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    if (async_data->success && async_data->tweets) {
-        populate_tweet_list(GTK_LIST_BOX(g_admin_posts_list), async_data->tweets);
-        free_tweets(async_data->tweets);
+    if (async_data->success && page_has_tweets(async_data->page)) {
+        populate_tweet_list(GTK_LIST_BOX(g_admin_posts_list), async_data->page->tweets);
     }
+    tweet_page_unref(async_data->page);
     g_free(async_data->query);
     g_free(async_data);
-    return G_SOURCE_REMOVE;
 }
 
-static gpointer
-fetch_admin_posts_thread(gpointer data)
+static void
+on_admin_posts_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    struct MemoryStruct chunk;
+    (void)response_code;
+    parse_in_background(chunk, (struct AsyncData *)data, parse_admin_posts_response, on_admin_posts_parsed);
+}
+
+void start_loading_admin_posts(const gchar *search)
+{
+    struct AsyncData *data = g_new0(struct AsyncData, 1);
+    data->query = g_strdup(search);
+
     gchar *url;
-    if (async_data->query && strlen(async_data->query) > 0) {
-        gchar *escaped = g_uri_escape_string(async_data->query, NULL, FALSE);
+    if (search && strlen(search) > 0) {
+        gchar *escaped = g_uri_escape_string(search, NULL, FALSE);
         url = g_strdup_printf("%s?search=%s", ADMIN_POSTS_URL, escaped);
         g_free(escaped);
     } else {
         url = g_strdup(ADMIN_POSTS_URL);
     }
 
-    if (fetch_url(url, &chunk, NULL, "GET")) {
-        async_data->tweets = parse_admin_posts(chunk.memory);
-        async_data->success = TRUE;
-        free(chunk.memory);
-    } else {
-        async_data->success = FALSE;
-    }
+    fetch_url_async(url, NULL, "GET", on_admin_posts_loaded, data);
     g_free(url);
-    g_idle_add(on_admin_posts_loaded, async_data);
-    return NULL;
-}
-
-void start_loading_admin_posts(const gchar *search)
-{
-    struct AsyncData *data = g_new0(struct AsyncData, 1);
-    data->query = g_strdup(search);
-    g_thread_new("admin-posts-loader", fetch_admin_posts_thread, data);
 }
 
 void perform_admin_verify(const gchar *username, gboolean verify)
@@ -1195,7 +1182,7 @@ void perform_admin_verify(const gchar *username, gboolean verify)
     gchar *post_data = g_strdup_printf("{\"verified\": %s}", verify ? "true" : "false");
     struct MemoryStruct chunk;
     if (fetch_url(url, &chunk, post_data, "PATCH")) {
-        free(chunk.memory);
+        memory_struct_release(&chunk);
         start_loading_admin_users(gtk_entry_get_text(GTK_ENTRY(g_admin_users_search)));
     }
     g_free(post_data);
@@ -1209,7 +1196,7 @@ void perform_admin_suspend(const gchar *username, const gchar *reason)
     gchar *post_data = g_strdup_printf("{\"reason\": \"%s\", \"action\": \"suspend\"}", reason);
     struct MemoryStruct chunk;
     if (fetch_url(url, &chunk, post_data, "POST")) {
-        free(chunk.memory);
+        memory_struct_release(&chunk);
         start_loading_admin_users(gtk_entry_get_text(GTK_ENTRY(g_admin_users_search)));
     }
     g_free(post_data);
@@ -1222,7 +1209,7 @@ void perform_admin_delete_user(const gchar *username)
     gchar *url = g_strdup_printf("%s/%s", ADMIN_USERS_URL, username);
     struct MemoryStruct chunk;
     if (fetch_url(url, &chunk, NULL, "DELETE")) {
-        free(chunk.memory);
+        memory_struct_release(&chunk);
         start_loading_admin_users(gtk_entry_get_text(GTK_ENTRY(g_admin_users_search)));
     }
     g_free(url);
@@ -1234,19 +1221,22 @@ void perform_admin_delete_post(const gchar *post_id)
     gchar *url = g_strdup_printf("%s/%s", ADMIN_POSTS_URL, post_id);
     struct MemoryStruct chunk;
     if (fetch_url(url, &chunk, NULL, "DELETE")) {
-        free(chunk.memory);
+        memory_struct_release(&chunk);
         start_loading_admin_posts(gtk_entry_get_text(GTK_ENTRY(g_admin_posts_search)));
     }
     g_free(url);
 }
 
-static gboolean on_users_loaded(gpointer data)
+static void parse_users_response(struct AsyncData *async_data, const gchar *json)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    
-    if (async_data->success && async_data->users) {
+    async_data->users = parse_users(json);
+    async_data->success = TRUE;
+}
+
+static void on_users_parsed(struct AsyncData *async_data)
+{
+    if (async_data->success && array_has_items(async_data->users)) {
         populate_user_list(async_data->list_box, async_data->users);
-        free_users(async_data->users);
     } else {
         GList *children = gtk_container_get_children(GTK_CONTAINER(async_data->list_box));
         for(GList *iter = children; iter != NULL; iter = g_list_next(iter))
@@ -1258,18 +1248,21 @@ static gboolean on_users_loaded(gpointer data)
         gtk_list_box_insert(async_data->list_box, error_label, -1);
     }
 
+    free_users(async_data->users);
     g_free(async_data->query);
     g_free(async_data);
-    return G_SOURCE_REMOVE;
 }
 
-static gboolean on_search_tweets_loaded(gpointer data)
+static void on_users_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    
-    if (async_data->success && async_data->tweets) {
-        populate_tweet_list(async_data->list_box, async_data->tweets);
-        free_tweets(async_data->tweets);
+    (void)response_code;
+    parse_in_background(chunk, (struct AsyncData *)data, parse_users_response, on_users_parsed);
+}
+
+static void on_search_tweets_parsed(struct AsyncData *async_data)
+{
+    if (async_data->success) {
+        populate_tweet_list(async_data->list_box, async_data->page->tweets);
     } else {
         GList *children = gtk_container_get_children(GTK_CONTAINER(async_data->list_box));
         for(GList *iter = children; iter != NULL; iter = g_list_next(iter))
@@ -1281,51 +1274,15 @@ static gboolean on_search_tweets_loaded(gpointer data)
         gtk_list_box_insert(async_data->list_box, error_label, -1);
     }
 
+    tweet_page_unref(async_data->page);
     g_free(async_data->query);
     g_free(async_data);
-    return G_SOURCE_REMOVE;
 }
 
-static gpointer fetch_search_users_thread(gpointer data)
+static void on_search_tweets_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
 {
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    struct MemoryStruct chunk;
-    gchar *escaped_query = g_uri_escape_string(async_data->query, NULL, FALSE);
-    gchar *url = g_strdup_printf("%s?q=%s", SEARCH_USERS_URL, escaped_query);
-    g_free(escaped_query);
-
-    if (fetch_url(url, &chunk, NULL, "GET")) {
-        async_data->users = parse_users(chunk.memory);
-        async_data->success = TRUE;
-        free(chunk.memory);
-    } else {
-        async_data->success = FALSE;
-    }
-    g_free(url);
-
-    g_idle_add(on_users_loaded, async_data);
-    return NULL;
-}
-
-static gpointer fetch_search_tweets_thread(gpointer data)
-{
-    struct AsyncData *async_data = (struct AsyncData *)data;
-    struct MemoryStruct chunk;
-    gchar *escaped_query = g_uri_escape_string(async_data->query, NULL, FALSE);
-    gchar *url = g_strdup_printf("%s?q=%s", SEARCH_POSTS_URL, escaped_query);
-    g_free(escaped_query);
-
-    if (fetch_url(url, &chunk, NULL, "GET")) {
-        async_data->tweets = parse_tweets(chunk.memory);
-        async_data->success = TRUE;
-        free(chunk.memory);
-    } else {
-        async_data->success = FALSE;
-    }
-    g_free(url);
-
-    g_idle_add(on_search_tweets_loaded, async_data);
-    return NULL;
+    (void)response_code;
+    parse_in_background(chunk, (struct AsyncData *)data, parse_tweets_response, on_search_tweets_parsed);
 }
 
 void perform_search(const gchar *query)
@@ -1344,15 +1301,23 @@ void perform_search(const gchar *query)
     gtk_widget_show(loading2);
     gtk_list_box_insert(GTK_LIST_BOX(g_search_tweets_list), loading2, -1);
 
+    gchar *escaped_query = g_uri_escape_string(query, NULL, FALSE);
+
     struct AsyncData *data_users = g_new0(struct AsyncData, 1);
     data_users->list_box = GTK_LIST_BOX(g_search_users_list);
     data_users->query = g_strdup(query);
-    g_thread_new("search-users-loader", fetch_search_users_thread, data_users);
+    gchar *users_url = g_strdup_printf("%s?q=%s", SEARCH_USERS_URL, escaped_query);
+    fetch_url_async(users_url, NULL, "GET", on_users_loaded, data_users);
+    g_free(users_url);
 
     struct AsyncData *data_tweets = g_new0(struct AsyncData, 1);
     data_tweets->list_box = GTK_LIST_BOX(g_search_tweets_list);
     data_tweets->query = g_strdup(query);
-    g_thread_new("search-tweets-loader", fetch_search_tweets_thread, data_tweets);
+    gchar *tweets_url = g_strdup_printf("%s?q=%s", SEARCH_POSTS_URL, escaped_query);
+    fetch_url_async(tweets_url, NULL, "GET", on_search_tweets_loaded, data_tweets);
+    g_free(tweets_url);
+
+    g_free(escaped_query);
 }
 
 void on_search_activated(GtkEntry *entry, gpointer user_data)
@@ -1364,91 +1329,6 @@ void on_search_activated(GtkEntry *entry, gpointer user_data)
     }
 }
 
-gboolean perform_like(const gchar *tweet_id)
-{
-    struct MemoryStruct chunk;
-    gboolean success = FALSE;
-    gchar *url = g_strdup_printf(LIKE_TWEET_URL, tweet_id);
-
-    if (fetch_url(url, &chunk, "{}", "POST")) {
-        success = TRUE;
-        free(chunk.memory);
-    }
-
-    g_free(url);
-    return success;
-}
-
-gboolean perform_retweet(const gchar *tweet_id)
-{
-    struct MemoryStruct chunk;
-    gboolean success = FALSE;
-    gchar *url = g_strdup_printf(RETWEET_URL, tweet_id);
-
-    if (fetch_url(url, &chunk, "{}", "POST")) {
-        success = TRUE;
-        free(chunk.memory);
-    }
-
-    g_free(url);
-    return success;
-}
-
-gboolean perform_bookmark(const gchar *tweet_id, gboolean add)
-{
-    struct MemoryStruct chunk;
-    gboolean success = FALSE;
-    const gchar *url = add ? BOOKMARK_ADD_URL : BOOKMARK_REMOVE_URL;
-
-    JsonBuilder *builder = json_builder_new();
-    json_builder_begin_object(builder);
-    json_builder_set_member_name(builder, "postId");
-    json_builder_add_string_value(builder, tweet_id);
-    json_builder_end_object(builder);
-
-    JsonGenerator *gen = json_generator_new();
-    json_generator_set_root(gen, json_builder_get_root(builder));
-    gchar *post_data = json_generator_to_data(gen, NULL);
-
-    if (fetch_url(url, &chunk, post_data, "POST")) {
-        success = TRUE;
-        free(chunk.memory);
-    }
-
-    g_free(post_data);
-    g_object_unref(gen);
-    g_object_unref(builder);
-    return success;
-}
-
-gboolean perform_reaction(const gchar *tweet_id, const gchar *emoji)
-{
-    struct MemoryStruct chunk;
-    gboolean success = FALSE;
-    gchar *url = g_strdup_printf(REACTION_URL, tweet_id);
-
-    JsonBuilder *builder = json_builder_new();
-    json_builder_begin_object(builder);
-    json_builder_set_member_name(builder, "emoji");
-    json_builder_add_string_value(builder, emoji);
-    json_builder_end_object(builder);
-
-    JsonGenerator *gen = json_generator_new();
-    json_generator_set_root(gen, json_builder_get_root(builder));
-    gchar *post_data = json_generator_to_data(gen, NULL);
-
-    if (fetch_url(url, &chunk, post_data, "POST")) {
-        success = TRUE;
-        free(chunk.memory);
-    }
-
-    g_free(post_data);
-    g_object_unref(gen);
-    g_object_unref(builder);
-    g_free(url);
-    return success;
-}
-
 static void free_emoji(gpointer data)
 {
     struct Emoji *emoji = data;
@@ -1460,44 +1340,63 @@ static void free_emoji(gpointer data)
     }
 }
 
-void free_emojis(GList *emojis)
+void free_emojis(GPtrArray *emojis)
 {
-    g_list_free_full(emojis, free_emoji);
+    if (emojis) {
+        g_ptr_array_unref(emojis);
+    }
 }
 
-GList* fetch_emojis(void)
+static GPtrArray* parse_emojis(const gchar *json)
 {
-    struct MemoryStruct chunk;
-    GList *emojis = NULL;
-
-    if (fetch_url(EMOJIS_URL, &chunk, NULL, "GET")) {
-        JsonParser *parser = json_parser_new();
-        GError *error = NULL;
-        json_parser_load_from_data(parser, chunk.memory, -1, &error);
-        if (!error) {
-            JsonNode *root = json_parser_get_root(parser);
-            JsonObject *obj = json_node_get_object(root);
-            if (json_object_has_member(obj, "emojis")) {
-                JsonArray *arr = json_object_get_array_member(obj, "emojis");
-                for (guint i = 0; i < json_array_get_length(arr); i++) {
-                    JsonObject *e_obj = json_array_get_object_element(arr, i);
-                    struct Emoji *emoji = g_new0(struct Emoji, 1);
-                    emoji->id = g_strdup(json_object_get_string_member(e_obj, "id"));
-                    emoji->name = g_strdup(json_object_get_string_member(e_obj, "name"));
-                    emoji->file_url = g_strdup(json_object_get_string_member(e_obj, "file_url"));
-                    emojis = g_list_append(emojis, emoji);
-                }
+    GPtrArray *emojis = NULL;
+    JsonParser *parser = json_parser_new();
+    GError *error = NULL;
+    json_parser_load_from_data(parser, json, -1, &error);
+    if (!error) {
+        JsonNode *root = json_parser_get_root(parser);
+        JsonObject *obj = json_node_get_object(root);
+        if (json_object_has_member(obj, "emojis")) {
+            JsonArray *arr = json_object_get_array_member(obj, "emojis");
+            guint length = json_array_get_length(arr);
+            emojis = g_ptr_array_new_full(length, free_emoji);
+            for (guint i = 0; i < length; i++) {
+                JsonObject *e_obj = json_array_get_object_element(arr, i);
+                struct Emoji *emoji = g_new0(struct Emoji, 1);
+                emoji->id = g_strdup(json_object_get_string_member(e_obj, "id"));
+                emoji->name = g_strdup(json_object_get_string_member(e_obj, "name"));
+                emoji->file_url = g_strdup(json_object_get_string_member(e_obj, "file_url"));
+                g_ptr_array_add(emojis, emoji);
             }
-        } else {
-            g_error_free(error);
         }
-        g_object_unref(parser);
-        free(chunk.memory);
+    } else {
+        g_error_free(error);
     }
-
+    g_object_unref(parser);
     return emojis;
 }
 
+struct EmojisRequest {
+    EmojisCallback callback;
+    gpointer user_data;
+};
+
+static void on_emojis_loaded(struct MemoryStruct *chunk, long response_code, gpointer data)
+{
+    (void)response_code;
+    struct EmojisRequest *request = (struct EmojisRequest *)data;
+    request->callback(chunk ? parse_emojis(chunk->memory) : NULL, request->user_data);
+    g_free(request);
+}
+
+void fetch_emojis(EmojisCallback callback, gpointer user_data)
+{
+    struct EmojisRequest *request = g_new(struct EmojisRequest, 1);
+    request->callback = callback;
+    request->user_data = user_data;
+    fetch_url_async(EMOJIS_URL, NULL, "GET", on_emojis_loaded, request);
+}
+
 static gboolean perform_add_note(const gchar *tweet_id, const gchar *note, const gchar *severity)
 {
     struct MemoryStruct chunk;
@@ -1518,7 +1417,7 @@ static gboolean perform_add_note(const gchar *tweet_id, const gchar *note, const
 
     if (fetch_url(url, &chunk, post_data, "POST")) {
         success = TRUE;
-        free(chunk.memory);
+        memory_struct_release(&chunk);
     }
 
     g_free(post_data);
@@ -39,11 +39,18 @@ void update_login_ui();
 void on_login_clicked(GtkWidget *widget, gpointer window);
 void on_scroll_edge_reached(GtkScrolledWindow *scrolled_window, GtkPositionType pos, gpointer user_data);
 
-gboolean perform_like(const gchar *tweet_id);
-gboolean perform_retweet(const gchar *tweet_id);
-gboolean perform_bookmark(const gchar *tweet_id, gboolean add);
-gboolean perform_reaction(const gchar *tweet_id, const gchar *emoji);
-GList* fetch_emojis(void);
-void free_emojis(GList *emojis);
+/**
+ * Callback for fetch_emojis().
+ * @param emojis The custom emojis, or NULL if the request failed. Owned by
+ *               the callback, which frees it with free_emojis().
+ */
+typedef void (*EmojisCallback)(GPtrArray *emojis, gpointer user_data);
+
+/**
+ * Fetches the server's custom emojis without blocking and hands them to
+ * @callback on the main loop.
+ */
+void fetch_emojis(EmojisCallback callback, gpointer user_data);
+void free_emojis(GPtrArray *emojis);
 
 #endif // ACTIONS_H
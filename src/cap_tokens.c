@@ -0,0 +1,218 @@
+#include "cap_tokens.h"
+#include "challenge.h"
+#include "constants.h"
+#include "executor.h"
+#include "memory_pool.h"
+#include "network.h"
+
+struct CapToken {
+    gchar *token;
+    gint64 expires_at;  // Monotonic time in microseconds
+};
+
+static GMutex tokens_mutex;
+static GCond tokens_cond;
+static GQueue ready = G_QUEUE_INIT;  // struct CapToken*, oldest first
+static gboolean solving = FALSE;     // A solve is running, in the background or inline
+static gboolean presolve_queued = FALSE;  // presolve_task() is waiting for a worker
+static gint64 pressure_until = 0;    // Keep the pool filled until this monotonic time
+static guint64 stat_ready = 0;
+static guint64 stat_solved_inline = 0;
+
+static void
+free_token(struct CapToken *token)
+{
+    g_free(token->token);
+    g_free(token);
+}
+
+// Caller holds the lock. Tokens are added in solve order, so the oldest
+// expire first.
+static void
+drop_expired(void)
+{
+    gint64 now = g_get_monotonic_time();
+    while (ready.head && ((struct CapToken *)ready.head->data)->expires_at <= now) {
+        free_token(g_queue_pop_head(&ready));
+    }
+}
+
+// Fetches a challenge, solves it and redeems the solution. Blocking.
+static gchar*
+solve_token(void)
+{
+    struct MemoryStruct chunk;
+    long response_code = 0;
+    gchar *token = NULL;
+
+    memory_struct_init(&chunk);
+    if (fetch_url_internal(CAP_CHALLENGE_URL, &chunk, "{}", "POST", &response_code)) {
+        token = check_and_solve_challenge(chunk.memory);
+    }
+    memory_struct_release(&chunk);
+
+    return token;
+}
+
+static gint64
+token_expiry(void)
+{
+    return g_get_monotonic_time() + CAP_TOKEN_LIFETIME_SECONDS * G_USEC_PER_SEC;
+}
+
+// Caller holds the lock
+static gboolean
+wants_more_locked(void)
+{
+    drop_expired();
+    return ready.length < CAP_TOKEN_POOL_SIZE && g_get_monotonic_time() < pressure_until;
+}
+
+static void
+presolve_task(gpointer data)
+{
+    (void)data;
+    gboolean more;
+
+    // Only claim the solve once a worker runs it. Challenge resolutions share
+    // the I/O lane and wait in cap_tokens_take() while a solve is claimed, so
+    // claiming it at submit time could fill every worker with waiters for a
+    // task queued behind them.
+    g_mutex_lock(&tokens_mutex);
+    presolve_queued = FALSE;
+    more = !solving && wants_more_locked();
+    if (more) {
+        solving = TRUE;
+    }
+    g_mutex_unlock(&tokens_mutex);
+
+    while (more) {
+        gchar *token = solve_token();
+
+        g_mutex_lock(&tokens_mutex);
+        if (token) {
+            struct CapToken *entry = g_new(struct CapToken, 1);
+            entry->token = token;
+            entry->expires_at = token_expiry();
+            g_queue_push_tail(&ready, entry);
+        }
+        // Stop on failure rather than hammering the challenge endpoint
+        more = token != NULL && wants_more_locked();
+        if (!more) {
+            solving = FALSE;
+        }
+        g_cond_broadcast(&tokens_cond);
+        g_mutex_unlock(&tokens_mutex);
+    }
+}
+
+void
+cap_tokens_presolve(void)
+{
+    gboolean start = FALSE;
+
+    g_mutex_lock(&tokens_mutex);
+    if (!solving && !presolve_queued && wants_more_locked()) {
+        presolve_queued = TRUE;
+        start = TRUE;
+    }
+    g_mutex_unlock(&tokens_mutex);
+
+    if (start) {
+        executor_submit(EXECUTOR_LANE_IO, presolve_task, NULL);
+    }
+}
+
+gchar*
+cap_tokens_take(void)
+{
+    gchar *token = NULL;
+    gboolean solve_here = FALSE;
+
+    g_mutex_lock(&tokens_mutex);
+    for (;;) {
+        drop_expired();
+        if (ready.head) {
+            struct CapToken *entry = g_queue_pop_head(&ready);
+            token = entry->token;
+            g_free(entry);
+            stat_ready++;
+            break;
+        }
+        if (!solving) {
+            solving = TRUE;
+            solve_here = TRUE;
+            stat_solved_inline++;
+            break;
+        }
+        // A solve that started earlier finishes sooner than a new one
+        g_cond_wait(&tokens_cond, &tokens_mutex);
+    }
+    g_mutex_unlock(&tokens_mutex);
+
+    if (solve_here) {
+        token = solve_token();
+        g_mutex_lock(&tokens_mutex);
+        solving = FALSE;
+        g_cond_broadcast(&tokens_cond);
+        g_mutex_unlock(&tokens_mutex);
+    }
+
+    cap_tokens_presolve();
+    return token;
+}
+
+void
+cap_tokens_add(const gchar *token, gint64 expires_at)
+{
+    struct CapToken *entry = g_new(struct CapToken, 1);
+    entry->token = g_strdup(token);
+    entry->expires_at = expires_at;
+
+    g_mutex_lock(&tokens_mutex);
+    g_queue_push_tail(&ready, entry);
+    g_cond_broadcast(&tokens_cond);
+    g_mutex_unlock(&tokens_mutex);
+}
+
+void
+cap_tokens_observe_response(long response_code, const gchar *rate_limit_remaining)
+{
+    gboolean pressure = response_code == 429;
+
+    if (!pressure && rate_limit_remaining) {
+        gchar *end = NULL;
+        gint64 remaining = g_ascii_strtoll(rate_limit_remaining, &end, 10);
+        pressure = end != rate_limit_remaining && remaining < CAP_PRESOLVE_REMAINING;
+    }
+    if (!pressure) return;
+
+    g_mutex_lock(&tokens_mutex);
+    pressure_until = g_get_monotonic_time() + CAP_PRESOLVE_WINDOW_SECONDS * G_USEC_PER_SEC;
+    g_mutex_unlock(&tokens_mutex);
+
+    cap_tokens_presolve();
+}
+
+void
+cap_tokens_get_stats(guint64 *ready_count, guint64 *solved_inline)
+{
+    g_mutex_lock(&tokens_mutex);
+    if (ready_count) *ready_count = stat_ready;
+    if (solved_inline) *solved_inline = stat_solved_inline;
+    g_mutex_unlock(&tokens_mutex);
+}
+
+void
+cap_tokens_clear(void)
+{
+    g_mutex_lock(&tokens_mutex);
+    pressure_until = 0;
+    while (solving) {
+        g_cond_wait(&tokens_cond, &tokens_mutex);
+    }
+    while (ready.head) {
+        free_token(g_queue_pop_head(&ready));
+    }
+    g_mutex_unlock(&tokens_mutex);
+}
@@ -0,0 +1,52 @@
+#ifndef CAP_TOKENS_H
+#define CAP_TOKENS_H
+
+#include <glib.h>
+
+// Pool of solved Cap tokens. Once the server signals rate limiting, tokens
+// are fetched, solved and redeemed on the executor's I/O lane, so a request
+// that needs one does not wait for that whole chain. All functions are safe
+// to call from any thread.
+
+/**
+ * Takes a ready token, or solves one right away if none is ready (waiting
+ * for a background solve that is already running instead of starting a
+ * second one; one still queued on the executor is not waited for).
+ * The pool is topped up in the background afterwards.
+ * @return A newly allocated token, or NULL if solving failed.
+ */
+gchar* cap_tokens_take(void);
+
+/**
+ * Adds a solved token to the pool.
+ * @param expires_at Monotonic time in microseconds after which it is dropped.
+ */
+void cap_tokens_add(const gchar *token, gint64 expires_at);
+
+/**
+ * Notes a response's status and RateLimit-Remaining header. A 429, or fewer
+ * than CAP_PRESOLVE_REMAINING requests left, keeps the pool filled for the
+ * next CAP_PRESOLVE_WINDOW_SECONDS.
+ * @param rate_limit_remaining Header value, or NULL if absent.
+ */
+void cap_tokens_observe_response(long response_code, const gchar *rate_limit_remaining);
+
+/**
+ * Starts a background solve if the pool is being kept filled and holds
+ * fewer than CAP_TOKEN_POOL_SIZE tokens.
+ */
+void cap_tokens_presolve(void);
+
+/**
+ * @param ready_count Set to the number of tokens handed out straight from the pool.
+ * @param solved_inline Set to the number the caller had to wait for.
+ */
+void cap_tokens_get_stats(guint64 *ready_count, guint64 *solved_inline);
+
+/**
+ * Drops all tokens and stops pre-solving. Waits for a background solve that
+ * is still running.
+ */
+void cap_tokens_clear(void);
+
+#endif // CAP_TOKENS_H
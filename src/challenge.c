@@ -1,6 +1,8 @@
 #include "challenge.h"
 #include "constants.h"
 #include "network.h"
+#include "memory_pool.h"
+#include "sha256.h"
 #include <json-glib/json-glib.h>
 #include <string.h>
 #include <stdio.h>
@@ -15,7 +17,7 @@ static guint32 cap_hash(const gchar *e) {
     return t;
 }
 
-static gchar* cap_prng_gen(const gchar *e, int t_len) {
+gchar* cap_prng_gen(const gchar *e, int t_len) {
     guint32 r = cap_hash(e);
     GString *i = g_string_new("");
     while (i->len < (gsize)t_len) {
@@ -31,43 +33,219 @@ static gchar* cap_prng_gen(const gchar *e, int t_len) {
     return res;
 }
 
-static guint64 solve_pow(const gchar *salt, const gchar *target_hex) {
-    int target_len = strlen(target_hex) / 2;
-    if (target_len > 32) target_len = 32;
+static gint solver_threads = 0;  // 0 means one per core
+
+// Nonces are handed out to solver threads in blocks of this size. Large
+// enough that the job lock is rarely contended, small enough that little
+// work is wasted past the answer.
+#define POW_BLOCK_SIZE 4096
+
+// One sub-challenge. Blocks are claimed in increasing order and every
+// thread stops at the first match within its block, so the smallest match
+// overall is exactly what the old sequential search returned.
+struct PowJob {
+    struct Sha256 midstate;  // Salt already absorbed
     guint8 target[32];
+    int target_len;
+    GMutex mutex;
+    guint64 next_block;  // First nonce of the next unclaimed block
+    guint64 best;        // Smallest matching nonce so far, G_MAXUINT64 if none
+};
+
+struct PowSolver {
+    struct PowJob *jobs;
+    int job_count;
+};
+
+// The padded final block(s) of salt || nonce. The nonce's decimal digits
+// live inside the block and are incremented in place, so the hot loop never
+// formats a number or re-pads the message.
+struct PowMessage {
+    guint8 blocks[2 * SHA256_BLOCK_SIZE];
+    gsize tail_len;     // Salt bytes left over after the midstate
+    gsize digits_len;
+    gsize block_count;  // 1, or 2 when the padding does not fit
+};
+
+static void pow_message_layout(struct PowMessage *m, const struct Sha256 *midstate, guint64 nonce) {
+    gchar digits[24];
+    gsize len = 0;
+
+    do {
+        digits[sizeof(digits) - 1 - len++] = (gchar)('0' + nonce % 10);
+        nonce /= 10;
+    } while (nonce > 0);
+
+    m->tail_len = midstate->block_len;
+    m->digits_len = len;
+    gsize used = m->tail_len + len;
+    m->block_count = used + 9 <= SHA256_BLOCK_SIZE ? 1 : 2;
+
+    gsize total = m->block_count * SHA256_BLOCK_SIZE;
+    guint64 bit_length = (midstate->length + len) * 8;
+
+    memcpy(m->blocks, midstate->block, m->tail_len);
+    memcpy(m->blocks + m->tail_len, digits + sizeof(digits) - len, len);
+    m->blocks[used] = 0x80;
+    memset(m->blocks + used + 1, 0, total - used - 1);
+    for (int i = 0; i < 8; i++) {
+        m->blocks[total - 1 - i] = (guint8)(bit_length >> (8 * i));
+    }
+}
+
+// Adds one to the nonce digits. Returns FALSE when it carries into a new
+// digit, in which case the message has to be laid out again.
+static gboolean pow_message_increment(struct PowMessage *m) {
+    guint8 *digits = m->blocks + m->tail_len;
+
+    for (gsize i = m->digits_len; i-- > 0;) {
+        if (digits[i] != '9') {
+            digits[i]++;
+            return TRUE;
+        }
+        digits[i] = '0';
+    }
+    return FALSE;
+}
+
+static gboolean pow_digest_matches(const guint32 state[8], const guint8 *target, int target_len) {
     for (int i = 0; i < target_len; i++) {
-        unsigned int val;
-        sscanf(target_hex + 2 * i, "%02x", &val);
-        target[i] = (guint8)val;
+        if ((guint8)(state[i / 4] >> (24 - 8 * (i % 4))) != target[i]) return FALSE;
     }
+    return TRUE;
+}
 
-    guint64 nonce = 0;
-    while (TRUE) {
-        GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA256);
-        gchar *nonce_str = g_strdup_printf("%llu", (unsigned long long)nonce);
-        gchar *combined = g_strconcat(salt, nonce_str, NULL);
-        
-        g_checksum_update(checksum, (const guchar *)combined, strlen(combined));
-        
-        guint8 digest[32];
-        gsize digest_len = 32;
-        g_checksum_get_digest(checksum, digest, &digest_len);
-        
-        gboolean found = TRUE;
-        for (int i = 0; i < target_len; i++) {
-            if (digest[i] != target[i]) {
-                found = FALSE;
-                break;
+// Hashes salt || nonce for every nonce in [start, end) and stops at the
+// first digest that begins with @target. Consecutive nonces are spread over
+// the lanes of the fastest SHA-256 kernel; each costs one compression (two
+// for long salt tails) on a copy of the midstate, and nothing is allocated.
+static gboolean pow_scan(const struct Sha256 *midstate, const guint8 *target, int target_len,
+                         guint64 start, guint64 end, guint64 *found) {
+    const struct Sha256Kernel *kernel = sha256_get_kernel();
+    guint8 lane_blocks[SHA256_MAX_LANES][2 * SHA256_BLOCK_SIZE];
+    const guint8 *first[SHA256_MAX_LANES];
+    const guint8 *second[SHA256_MAX_LANES];
+    guint32 states[SHA256_MAX_LANES][8];
+    struct PowMessage m;
+    guint64 nonce = start;
+
+    for (guint j = 0; j < kernel->lanes; j++) {
+        first[j] = lane_blocks[j];
+        second[j] = lane_blocks[j] + SHA256_BLOCK_SIZE;
+    }
+
+    pow_message_layout(&m, midstate, start);
+    while (nonce < end) {
+        gsize block_count = m.block_count;
+        guint used = 0;
+
+        // A batch stops early at the end of the range or where the nonce
+        // grows a digit and no longer fits the same number of blocks
+        while (used < kernel->lanes && nonce + used < end && m.block_count == block_count) {
+            memcpy(lane_blocks[used], m.blocks, block_count * SHA256_BLOCK_SIZE);
+            used++;
+            if (!pow_message_increment(&m)) {
+                pow_message_layout(&m, midstate, nonce + used);
             }
         }
-        
-        g_free(combined);
-        g_free(nonce_str);
-        g_checksum_free(checksum);
-        
-        if (found) return nonce;
-        nonce++;
+
+        // Idle lanes hash a copy of the first lane and are ignored
+        for (guint j = 0; j < kernel->lanes; j++) {
+            memcpy(states[j], midstate->state, sizeof(states[j]));
+            if (j >= used) {
+                memcpy(lane_blocks[j], lane_blocks[0], block_count * SHA256_BLOCK_SIZE);
+            }
+        }
+
+        kernel->compress(states, first);
+        if (block_count == 2) {
+            kernel->compress(states, second);
+        }
+
+        for (guint j = 0; j < used; j++) {
+            if (pow_digest_matches(states[j], target, target_len)) {
+                *found = nonce + j;
+                return TRUE;
+            }
+        }
+        nonce += used;
     }
+    return FALSE;
+}
+
+// Claims the next block of @job that can still hold the answer
+static gboolean pow_claim_block(struct PowJob *job, guint64 *start) {
+    gboolean claimed = FALSE;
+
+    g_mutex_lock(&job->mutex);
+    if (job->next_block < job->best) {
+        *start = job->next_block;
+        job->next_block += POW_BLOCK_SIZE;
+        claimed = TRUE;
+    }
+    g_mutex_unlock(&job->mutex);
+
+    return claimed;
+}
+
+// Works on the earliest sub-challenge that still has blocks left. Once a
+// job's remaining blocks are all past its answer, threads move on to the
+// next one, so independent sub-challenges overlap.
+static gpointer pow_worker(gpointer data) {
+    struct PowSolver *solver = (struct PowSolver *)data;
+    int first_open = 0;
+
+    while (first_open < solver->job_count) {
+        struct PowJob *job = &solver->jobs[first_open];
+        guint64 start, nonce;
+
+        if (!pow_claim_block(job, &start)) {
+            first_open++;
+            continue;
+        }
+
+        if (pow_scan(&job->midstate, job->target, job->target_len, start, start + POW_BLOCK_SIZE, &nonce)) {
+            g_mutex_lock(&job->mutex);
+            job->best = MIN(job->best, nonce);
+            g_mutex_unlock(&job->mutex);
+        }
+    }
+
+    return NULL;
+}
+
+static int pow_parse_target(const gchar *target_hex, guint8 target[32]) {
+    int target_len = MIN((int)strlen(target_hex) / 2, 32);
+    for (int i = 0; i < target_len; i++) {
+        unsigned int val;
+        sscanf(target_hex + 2 * i, "%02x", &val);
+        target[i] = (guint8)val;
+    }
+    return target_len;
+}
+
+static void pow_job_init(struct PowJob *job, const gchar *salt, const gchar *target_hex) {
+    sha256_init(&job->midstate);
+    sha256_update(&job->midstate, salt, strlen(salt));
+    job->target_len = pow_parse_target(target_hex, job->target);
+    g_mutex_init(&job->mutex);
+    job->next_block = 0;
+    job->best = G_MAXUINT64;
+}
+
+gboolean challenge_pow_scan(const gchar *salt, const gchar *target_hex,
+                            guint64 start, guint64 count, guint64 *nonce) {
+    struct Sha256 midstate;
+    guint8 target[32];
+    int target_len = pow_parse_target(target_hex, target);
+
+    sha256_init(&midstate);
+    sha256_update(&midstate, salt, strlen(salt));
+    return pow_scan(&midstate, target, target_len, start, start + count, nonce);
+}
+
+void challenge_set_thread_count(guint n_threads) {
+    g_atomic_int_set(&solver_threads, (gint)n_threads);
 }
 
 JsonArray* solve_challenge_internal(JsonObject *obj, const gchar *token) {
@@ -77,22 +255,39 @@ JsonArray* solve_challenge_internal(JsonObject *obj, const gchar *token) {
         int count = json_object_get_int_member(obj, "c");
         int salt_len = json_object_get_int_member(obj, "s");
         int difficulty = json_object_get_int_member(obj, "d");
-        
+        if (count <= 0) return solutions;
+
+        struct PowSolver solver = { g_new0(struct PowJob, count), count };
         for (int i = 1; i <= count; i++) {
             gchar *seed_salt = g_strdup_printf("%s%d", token, i);
             gchar *seed_target = g_strdup_printf("%s%dd", token, i);
-            
             gchar *salt = cap_prng_gen(seed_salt, salt_len);
             gchar *target = cap_prng_gen(seed_target, difficulty);
-            
-            guint64 nonce = solve_pow(salt, target);
-            json_array_add_int_element(solutions, (gint64)nonce);
-            
+
+            pow_job_init(&solver.jobs[i - 1], salt, target);
+
             g_free(salt);
             g_free(target);
             g_free(seed_salt);
             g_free(seed_target);
         }
+
+        gint configured = g_atomic_int_get(&solver_threads);
+        guint n_threads = configured > 0 ? (guint)configured : MAX(g_get_num_processors(), 1);
+        GThread **threads = g_new(GThread *, n_threads);
+        for (guint t = 0; t < n_threads; t++) {
+            threads[t] = g_thread_new("pow-solver", pow_worker, &solver);
+        }
+        for (guint t = 0; t < n_threads; t++) {
+            g_thread_join(threads[t]);
+        }
+        g_free(threads);
+
+        for (int i = 0; i < count; i++) {
+            json_array_add_int_element(solutions, (gint64)solver.jobs[i].best);
+            g_mutex_clear(&solver.jobs[i].mutex);
+        }
+        g_free(solver.jobs);
     }
     return solutions;
 }
@@ -160,8 +355,7 @@ gchar* check_and_solve_challenge(const gchar *response_json) {
         gchar *post_data = json_generator_to_data(gen, NULL);
         
         struct MemoryStruct chunk;
-        chunk.memory = NULL;
-        chunk.size = 0;
+        memory_struct_init(&chunk);
         long response_code = 0;
         if (fetch_url_internal(CAP_REDEEM_URL, &chunk, post_data, "POST", &response_code)) {
             JsonParser *redeem_parser = json_parser_new();
@@ -173,7 +367,7 @@ gchar* check_and_solve_challenge(const gchar *response_json) {
                 }
             }
             g_object_unref(redeem_parser);
-            free(chunk.memory);
+            memory_struct_release(&chunk);
         }
         
         g_free(post_data);
@@ -19,4 +19,28 @@ gchar* solve_challenge(const gchar *challenge_json, const gchar *token);
  */
 gchar* check_and_solve_challenge(const gchar *response_json);
 
+/**
+ * Cap's seeded pseudo-random hex generator, used for salts and targets.
+ * @param seed The token followed by the sub-challenge index (and "d" for targets).
+ * @param length Number of hex characters to produce.
+ * @return A newly allocated string.
+ */
+gchar* cap_prng_gen(const gchar *seed, int length);
+
+/**
+ * Overrides the number of solver threads, for benchmarks.
+ * @param n_threads Thread count, or 0 for one per core (the default).
+ */
+void challenge_set_thread_count(guint n_threads);
+
+/**
+ * Searches nonces [start, start + count) for the first one whose
+ * SHA-256(salt || decimal nonce) begins with the bytes of @target_hex.
+ * This is the solver's inner loop, exposed for tests and benchmarks.
+ * @param nonce Set to the matching nonce.
+ * @return TRUE if a match was found.
+ */
+gboolean challenge_pow_scan(const gchar *salt, const gchar *target_hex,
+                            guint64 start, guint64 count, guint64 *nonce);
+
 #endif // CHALLENGE_H
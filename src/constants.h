@@ -5,6 +5,40 @@
 #define BASE_DOMAIN "https://tweeta.tiago.zip"
 #define AVATAR_SIZE 48
 #define MEDIA_SIZE 400
+// HTTP/2: requests to BASE_DOMAIN are multiplexed over at most
+// MAX_HOST_CONNECTIONS connections, each carrying up to
+// MAX_CONCURRENT_STREAMS parallel requests by default.
+#define MAX_HOST_CONNECTIONS 2
+#define MAX_CONCURRENT_STREAMS 32
+// Non-interactive async requests running at once per host; the rest queue
+#define MAX_REQUESTS_PER_HOST 16
+// Upper bound on response bodies kept by the HTTP cache (network_cache.c)
+#define HTTP_CACHE_MAX_BYTES (16 * 1024 * 1024)
+// Solved Cap tokens kept ready while rate limited (cap_tokens.c). A token is
+// assumed valid for CAP_TOKEN_LIFETIME_SECONDS, which stays short of the
+// server's expiry so a pooled token is never handed out stale.
+#define CAP_TOKEN_POOL_SIZE 2
+#define CAP_TOKEN_LIFETIME_SECONDS 120
+// Pre-solving starts on a 429 or when RateLimit-Remaining drops below
+// CAP_PRESOLVE_REMAINING, and continues for CAP_PRESOLVE_WINDOW_SECONDS.
+#define CAP_PRESOLVE_REMAINING 5
+#define CAP_PRESOLVE_WINDOW_SECONDS 300
+// Challenge responses are tiny; larger 2xx bodies are never scanned for one
+#define CHALLENGE_MAX_BODY_BYTES (16 * 1024)
+// Delay before a like/retweet/bookmark click is sent, so that a quick
+// second click cancels it instead of sending a second request
+#define INTERACTION_DEBOUNCE_MS 300
+// Backoff between attempts to send the outbox (outbox.c), doubling per failure
+#define OUTBOX_RETRY_MIN_SECONDS 2
+#define OUTBOX_RETRY_MAX_SECONDS 300
+// An entry is dropped once the server has refused it (429 or 5xx) this many
+// times, or once it has failed to go out for this long
+#define OUTBOX_MAX_ATTEMPTS 10
+#define OUTBOX_MAX_AGE_SECONDS (24 * 60 * 60)
+// Changes to the outbox journal within this window are written together
+#define OUTBOX_SAVE_DELAY_MS 500
+// Workers of the executor's I/O lane (executor.c); the CPU lane gets one per core
+#define EXECUTOR_IO_WORKERS 4
 #define PUBLIC_TWEETS_URL API_BASE_URL "/public-tweets"
 #define LOGIN_URL API_BASE_URL "/auth/basic-login"
 #define AUTH_ME_URL API_BASE_URL "/auth/me"
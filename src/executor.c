@@ -0,0 +1,153 @@
+#include "executor.h"
+#include "constants.h"
+
+struct ExecutorTask {
+    ExecutorFunc func;
+    ExecutorFunc done;
+    gpointer data;
+    gint64 submitted_at;
+};
+
+static GThreadPool *pools[EXECUTOR_LANE_COUNT];
+static struct ExecutorStats lane_stats[EXECUTOR_LANE_COUNT];
+static GMutex executor_mutex;   // Guards pools and lane_stats
+
+static const gchar *lane_names[EXECUTOR_LANE_COUNT] = {
+    [EXECUTOR_LANE_CPU] = "cpu",
+    [EXECUTOR_LANE_IO] = "io",
+};
+
+const gchar*
+executor_lane_name(ExecutorLane lane)
+{
+    return lane_names[lane];
+}
+
+static guint
+lane_workers(ExecutorLane lane)
+{
+    if (lane == EXECUTOR_LANE_IO) return EXECUTOR_IO_WORKERS;
+    return MAX(1, g_get_num_processors());
+}
+
+static gboolean
+run_done(gpointer user_data)
+{
+    struct ExecutorTask *task = user_data;
+    task->done(task->data);
+    g_free(task);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+run_task(gpointer task_data, gpointer pool_data)
+{
+    struct ExecutorTask *task = task_data;
+    struct ExecutorStats *stats = &lane_stats[GPOINTER_TO_INT(pool_data)];
+    gint64 started_at = g_get_monotonic_time();
+
+    g_mutex_lock(&executor_mutex);
+    stats->queued--;
+    stats->running++;
+    network_stats_histogram_add(&stats->wait, (guint64)(started_at - task->submitted_at));
+    g_mutex_unlock(&executor_mutex);
+
+    task->func(task->data);
+
+    g_mutex_lock(&executor_mutex);
+    stats->running--;
+    stats->completed++;
+    network_stats_histogram_add(&stats->run, (guint64)(g_get_monotonic_time() - started_at));
+    g_mutex_unlock(&executor_mutex);
+
+    if (task->done) {
+        g_idle_add(run_done, task);
+    } else {
+        g_free(task);
+    }
+}
+
+// Caller holds executor_mutex
+static GThreadPool*
+get_pool_locked(ExecutorLane lane)
+{
+    if (!pools[lane]) {
+        guint workers = lane_workers(lane);
+        // Shared (non-exclusive) threads: idle workers are reused across
+        // lanes instead of being created per task
+        pools[lane] = g_thread_pool_new(run_task, GINT_TO_POINTER(lane), workers, FALSE, NULL);
+        lane_stats[lane].workers = workers;
+    }
+    return pools[lane];
+}
+
+void
+executor_submit_full(ExecutorLane lane, ExecutorFunc func, ExecutorFunc done, gpointer data)
+{
+    struct ExecutorTask *task = g_new(struct ExecutorTask, 1);
+    task->func = func;
+    task->done = done;
+    task->data = data;
+    task->submitted_at = g_get_monotonic_time();
+
+    g_mutex_lock(&executor_mutex);
+    struct ExecutorStats *stats = &lane_stats[lane];
+    stats->submitted++;
+    stats->queued++;
+    stats->max_queued = MAX(stats->max_queued, stats->queued);
+    // Pushed under the lock so executor_shutdown() cannot free the pool
+    // in between; g_thread_pool_push() does not wait for the task
+    g_thread_pool_push(get_pool_locked(lane), task, NULL);
+    g_mutex_unlock(&executor_mutex);
+}
+
+void
+executor_submit(ExecutorLane lane, ExecutorFunc func, gpointer data)
+{
+    executor_submit_full(lane, func, NULL, data);
+}
+
+void
+executor_get_stats(ExecutorLane lane, struct ExecutorStats *stats)
+{
+    g_mutex_lock(&executor_mutex);
+    *stats = lane_stats[lane];
+    if (!pools[lane]) {
+        stats->workers = lane_workers(lane);
+    }
+    g_mutex_unlock(&executor_mutex);
+}
+
+void
+executor_log_summary(void)
+{
+    for (int lane = 0; lane < EXECUTOR_LANE_COUNT; lane++) {
+        struct ExecutorStats stats;
+        executor_get_stats(lane, &stats);
+        if (stats.submitted == 0) continue;
+
+        g_message("Executor %s: %" G_GUINT64_FORMAT " tasks on %u workers, queue depth max %u, "
+                  "wait p95 %.1f ms, run p95 %.1f ms",
+                  executor_lane_name(lane), stats.completed, stats.workers, stats.max_queued,
+                  network_stats_histogram_percentile(&stats.wait, 0.95) / 1000.0,
+                  network_stats_histogram_percentile(&stats.run, 0.95) / 1000.0);
+    }
+}
+
+void
+executor_shutdown(void)
+{
+    // I/O first, since its tasks may still hand work to the CPU lane
+    for (int lane = EXECUTOR_LANE_COUNT - 1; lane >= 0; lane--) {
+        g_mutex_lock(&executor_mutex);
+        GThreadPool *pool = pools[lane];
+        pools[lane] = NULL;
+        g_mutex_unlock(&executor_mutex);
+
+        // Not under the lock: running tasks may still submit
+        if (pool) {
+            g_thread_pool_free(pool, FALSE, TRUE);
+        }
+    }
+    executor_log_summary();
+}
@@ -0,0 +1,60 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <glib.h>
+#include "network_stats.h"
+
+// Shared worker pool for everything that must not run on the main loop.
+// Each lane is a GThreadPool with a bounded number of workers, so a burst of
+// tasks (e.g. fast scrolling) queues up instead of spawning threads.
+typedef enum {
+    EXECUTOR_LANE_CPU,  // Parsing and decoding, one worker per core
+    EXECUTOR_LANE_IO,   // Blocking work: challenge solving, Cap pre-solving
+    EXECUTOR_LANE_COUNT
+} ExecutorLane;
+
+typedef void (*ExecutorFunc)(gpointer data);
+
+struct ExecutorStats {
+    guint workers;                  // Upper bound on threads for the lane
+    guint queued;                   // Tasks waiting for a worker right now
+    guint running;
+    guint max_queued;               // Deepest the queue has been
+    guint64 submitted;
+    guint64 completed;
+    struct LatencyHistogram wait;   // Submission until a worker picks the task up
+    struct LatencyHistogram run;    // Time spent in the task itself
+};
+
+/**
+ * Runs @func(@data) on a worker of @lane. Safe to call from any thread.
+ */
+void executor_submit(ExecutorLane lane, ExecutorFunc func, gpointer data);
+
+/**
+ * Like executor_submit(), then runs @done(@data) on the main loop once @func
+ * has returned. @done is where results are handed to widgets and @data is
+ * freed.
+ */
+void executor_submit_full(ExecutorLane lane, ExecutorFunc func, ExecutorFunc done, gpointer data);
+
+/**
+ * Copies the counters of @lane into @stats.
+ */
+void executor_get_stats(ExecutorLane lane, struct ExecutorStats *stats);
+
+const gchar* executor_lane_name(ExecutorLane lane);
+
+/**
+ * Logs one line per lane with its queue depth and latencies.
+ */
+void executor_log_summary(void);
+
+/**
+ * Waits for every queued and running task, then stops the workers. Tasks
+ * submitted later start a new pool. @done callbacks still pending on the
+ * main loop are not run.
+ */
+void executor_shutdown(void);
+
+#endif // EXECUTOR_H
@@ -0,0 +1,272 @@
+#include <json-glib/json-glib.h>
+#include "interactions.h"
+#include "constants.h"
+#include "memory_pool.h"
+#include "outbox.h"
+
+struct InteractionLabels {
+    const gchar *on;
+    const gchar *off;
+    const gchar *state_member;  // Response member carrying the new state
+};
+
+static const struct InteractionLabels labels[] = {
+    [INTERACTION_LIKE] = { "♥ Liked", "♡ Like", "liked" },
+    [INTERACTION_RETWEET] = { "↻ Retweeted", "↻ Retweet", "retweeted" },
+    [INTERACTION_BOOKMARK] = { "★ Saved", "☆ Bookmark", "bookmarked" },
+};
+
+const gchar*
+interaction_label(InteractionKind kind, gboolean state)
+{
+    return state ? labels[kind].on : labels[kind].off;
+}
+
+struct InteractionData*
+interaction_data_new(const gchar *tweet_id, InteractionKind kind, gboolean state)
+{
+    struct InteractionData *data = g_new0(struct InteractionData, 1);
+    data->tweet_id = g_strdup(tweet_id);
+    data->kind = kind;
+    data->state = state;
+    data->confirmed = state;
+    data->queued = state;
+    return data;
+}
+
+void
+interaction_data_free(struct InteractionData *data)
+{
+    if (!data) return;
+    if (data->debounce_id) {
+        g_source_remove(data->debounce_id);
+    }
+    g_free(data->tweet_id);
+    g_free(data);
+}
+
+void
+interaction_toggle(struct InteractionData *data)
+{
+    data->state = !data->state;
+}
+
+gboolean
+interaction_begin_request(struct InteractionData *data)
+{
+    if (data->state == data->queued) {
+        return FALSE;
+    }
+    data->queued = data->state;
+    data->pending++;
+    return TRUE;
+}
+
+void
+interaction_finish_request(struct InteractionData *data, gboolean success, gint reported_state)
+{
+    if (data->pending > 0) {
+        data->pending--;
+    }
+
+    if (success) {
+        // Queued requests alternate between the two states, so each one
+        // that goes through flips the server's
+        data->confirmed = reported_state >= 0 ? (gboolean)reported_state : !data->confirmed;
+    }
+
+    if (data->pending == 0) {
+        data->queued = data->confirmed;
+        if (!data->debounce_id) {
+            data->state = data->confirmed;
+        }
+    }
+}
+
+static void
+update_button(struct InteractionData *data)
+{
+    if (data->button) {
+        gtk_button_set_label(GTK_BUTTON(data->button), interaction_label(data->kind, data->state));
+    }
+}
+
+// Frees @data once its button is gone and nothing is left to send
+static void
+release_if_orphaned(struct InteractionData *data)
+{
+    if (!data->button && !data->pending && !data->debounce_id) {
+        interaction_data_free(data);
+    }
+}
+
+static gint
+read_reported_state(const struct MemoryStruct *chunk, InteractionKind kind)
+{
+    gint reported = -1;
+    JsonParser *parser = json_parser_new();
+
+    if (json_parser_load_from_data(parser, chunk->memory, chunk->size, NULL)) {
+        JsonNode *root = json_parser_get_root(parser);
+        if (JSON_NODE_HOLDS_OBJECT(root)) {
+            JsonObject *obj = json_node_get_object(root);
+            JsonNode *member = json_object_get_member(obj, labels[kind].state_member);
+            if (member && JSON_NODE_HOLDS_VALUE(member) &&
+                json_node_get_value_type(member) == G_TYPE_BOOLEAN) {
+                reported = json_node_get_boolean(member);
+            }
+        }
+    }
+
+    g_object_unref(parser);
+    return reported;
+}
+
+static void
+on_interaction_sent(struct MemoryStruct *chunk, long response_code, gpointer user_data)
+{
+    struct InteractionData *data = user_data;
+    gboolean success = chunk && response_code >= 200 && response_code < 300;
+
+    // A NULL chunk means the request cancelled out, or the outbox was cleared
+    // or gave up on it
+    if (chunk && !success) {
+        g_warning("Interaction with tweet %s failed (HTTP %ld), rolling back", data->tweet_id, response_code);
+    }
+    interaction_finish_request(data, success, success ? read_reported_state(chunk, data->kind) : -1);
+    update_button(data);
+    release_if_orphaned(data);
+}
+
+static gchar*
+build_bookmark_payload(const gchar *tweet_id)
+{
+    JsonBuilder *builder = json_builder_new();
+    json_builder_begin_object(builder);
+    json_builder_set_member_name(builder, "postId");
+    json_builder_add_string_value(builder, tweet_id);
+    json_builder_end_object(builder);
+
+    JsonGenerator *gen = json_generator_new();
+    json_generator_set_root(gen, json_builder_get_root(builder));
+    gchar *post_data = json_generator_to_data(gen, NULL);
+
+    g_object_unref(gen);
+    g_object_unref(builder);
+    return post_data;
+}
+
+static void
+send_request(struct InteractionData *data)
+{
+    if (!interaction_begin_request(data)) return;
+
+    gchar *url = NULL;
+    gchar *post_data = NULL;
+    gchar *key = NULL;
+
+    switch (data->kind) {
+    case INTERACTION_LIKE:
+        url = g_strdup_printf(LIKE_TWEET_URL, data->tweet_id);
+        key = g_strconcat("like:", data->tweet_id, NULL);
+        break;
+    case INTERACTION_RETWEET:
+        url = g_strdup_printf(RETWEET_URL, data->tweet_id);
+        key = g_strconcat("retweet:", data->tweet_id, NULL);
+        break;
+    case INTERACTION_BOOKMARK:
+        url = g_strdup(data->queued ? BOOKMARK_ADD_URL : BOOKMARK_REMOVE_URL);
+        post_data = build_bookmark_payload(data->tweet_id);
+        key = g_strconcat("bookmark:", data->tweet_id, NULL);
+        break;
+    }
+
+    // Like and retweet are toggles on the server, and bookmark add/remove
+    // alternate, so two queued requests for the same key cancel out
+    outbox_enqueue(url, "POST", post_data ? post_data : "{}", key, OUTBOX_TOGGLE,
+                   on_interaction_sent, data);
+
+    g_free(key);
+    g_free(post_data);
+    g_free(url);
+}
+
+static gboolean
+on_debounce_elapsed(gpointer user_data)
+{
+    struct InteractionData *data = user_data;
+
+    data->debounce_id = 0;
+    send_request(data);
+    release_if_orphaned(data);
+    return G_SOURCE_REMOVE;
+}
+
+// Destroy notify of the button's "interaction" data. Queued requests are
+// still sent; the state is freed once they have all completed.
+static void
+on_button_destroyed(gpointer user_data)
+{
+    struct InteractionData *data = user_data;
+
+    data->button = NULL;
+    release_if_orphaned(data);
+}
+
+void
+interaction_attach(GtkWidget *button, const gchar *tweet_id, InteractionKind kind, gboolean state)
+{
+    struct InteractionData *data = interaction_data_new(tweet_id, kind, state);
+
+    data->button = button;
+    gtk_button_set_label(GTK_BUTTON(button), interaction_label(kind, state));
+    g_object_set_data_full(G_OBJECT(button), "interaction", data, on_button_destroyed);
+}
+
+void
+interaction_button_toggle(GtkWidget *button)
+{
+    struct InteractionData *data = g_object_get_data(G_OBJECT(button), "interaction");
+    if (!data) return;
+
+    interaction_toggle(data);
+    if (data->debounce_id) {
+        g_source_remove(data->debounce_id);
+    }
+    data->debounce_id = g_timeout_add(INTERACTION_DEBOUNCE_MS, on_debounce_elapsed, data);
+    update_button(data);
+}
+
+static void
+on_reaction_sent(struct MemoryStruct *chunk, long response_code, gpointer user_data)
+{
+    gchar *tweet_id = user_data;
+
+    if (chunk && (response_code < 200 || response_code >= 300)) {
+        g_warning("Reaction to tweet %s failed (HTTP %ld)", tweet_id, response_code);
+    }
+    g_free(tweet_id);
+}
+
+void
+interaction_send_reaction(const gchar *tweet_id, const gchar *emoji)
+{
+    gchar *url = g_strdup_printf(REACTION_URL, tweet_id);
+
+    JsonBuilder *builder = json_builder_new();
+    json_builder_begin_object(builder);
+    json_builder_set_member_name(builder, "emoji");
+    json_builder_add_string_value(builder, emoji);
+    json_builder_end_object(builder);
+
+    JsonGenerator *gen = json_generator_new();
+    json_generator_set_root(gen, json_builder_get_root(builder));
+    gchar *post_data = json_generator_to_data(gen, NULL);
+
+    outbox_enqueue(url, "POST", post_data, NULL, OUTBOX_APPEND, on_reaction_sent, g_strdup(tweet_id));
+
+    g_free(post_data);
+    g_object_unref(gen);
+    g_object_unref(builder);
+    g_free(url);
+}
@@ -0,0 +1,62 @@
+#ifndef INTERACTIONS_H
+#define INTERACTIONS_H
+
+#include <gtk/gtk.h>
+#include "types.h"
+
+// Likes, retweets, bookmarks and reactions, sent through the outbox so the
+// main loop never waits for them. A button shows its new state as soon as it
+// is clicked; the request is queued INTERACTION_DEBOUNCE_MS later, only if
+// the state still differs from what is already queued, and the button rolls
+// back if the server rejects it. A queued request undone by a later click
+// cancels out in the outbox, so like then unlike sends nothing. Main thread
+// only.
+
+/**
+ * Makes @button an interaction button for @tweet_id, showing @state.
+ * The state is freed with the button, or once its last request finishes.
+ */
+void interaction_attach(GtkWidget *button, const gchar *tweet_id, InteractionKind kind, gboolean state);
+
+/**
+ * Handles a click on a button set up by interaction_attach().
+ */
+void interaction_button_toggle(GtkWidget *button);
+
+/**
+ * @return The button label for @kind in @state.
+ */
+const gchar* interaction_label(InteractionKind kind, gboolean state);
+
+/**
+ * Sends a reaction in the background. Failures are only logged.
+ */
+void interaction_send_reaction(const gchar *tweet_id, const gchar *emoji);
+
+// State machine behind the buttons, without any widgets or network access
+
+struct InteractionData* interaction_data_new(const gchar *tweet_id, InteractionKind kind, gboolean state);
+void interaction_data_free(struct InteractionData *data);
+
+/**
+ * Flips the shown state. The caller schedules interaction_begin_request().
+ */
+void interaction_toggle(struct InteractionData *data);
+
+/**
+ * Queues a request if the shown state differs from the queued one.
+ * @return TRUE if the caller should queue a request for data->queued.
+ */
+gboolean interaction_begin_request(struct InteractionData *data);
+
+/**
+ * Records the outcome of the oldest queued request. Once none are left
+ * and no click is waiting to be queued, the shown state falls back to the
+ * confirmed one: a failure rolls the button back, and a state reported by
+ * the server wins.
+ * @param success FALSE if the request was rejected or cancelled out.
+ * @param reported_state 1 or 0 if the response carried the new state, -1 if not.
+ */
+void interaction_finish_request(struct InteractionData *data, gboolean success, gint reported_state);
+
+#endif // INTERACTIONS_H
@@ -0,0 +1,501 @@
+#include <string.h>
+#include "json_stream.h"
+
+// Nesting deeper than this is treated as malformed rather than recursed into
+#define JSON_STREAM_MAX_DEPTH 512
+
+void
+json_stream_init(struct JsonStream *stream, const gchar *data, gssize length)
+{
+    if (!data) {
+        data = "";
+        length = 0;
+    }
+    stream->start = data;
+    stream->pos = data;
+    stream->end = data + (length < 0 ? strlen(data) : (gsize)length);
+    stream->failed = FALSE;
+    stream->after_value = FALSE;
+    stream->depth = 0;
+    stream->key = g_string_sized_new(32);
+    stream->scratch = g_string_sized_new(256);
+}
+
+void
+json_stream_clear(struct JsonStream *stream)
+{
+    if (stream->key) {
+        g_string_free(stream->key, TRUE);
+        stream->key = NULL;
+    }
+    if (stream->scratch) {
+        g_string_free(stream->scratch, TRUE);
+        stream->scratch = NULL;
+    }
+}
+
+gsize
+json_stream_get_offset(const struct JsonStream *stream)
+{
+    return stream->pos - stream->start;
+}
+
+static void
+fail(struct JsonStream *stream)
+{
+    stream->failed = TRUE;
+}
+
+static void
+skip_whitespace(struct JsonStream *stream)
+{
+    while (stream->pos < stream->end &&
+           (*stream->pos == ' ' || *stream->pos == '\n' || *stream->pos == '\r' || *stream->pos == '\t')) {
+        stream->pos++;
+    }
+}
+
+// Consumes @literal if it comes next
+static gboolean
+match_literal(struct JsonStream *stream, const gchar *literal, gsize length)
+{
+    if ((gsize)(stream->end - stream->pos) < length || memcmp(stream->pos, literal, length) != 0) {
+        fail(stream);
+        return FALSE;
+    }
+    stream->pos += length;
+    return TRUE;
+}
+
+// Length of the number at the current position, 0 if it is malformed.
+// Sets @is_double for a fraction or exponent.
+static gsize
+scan_number(const struct JsonStream *stream, gboolean *is_double)
+{
+    const gchar *p = stream->pos;
+    const gchar *end = stream->end;
+
+    *is_double = FALSE;
+    if (p < end && *p == '-') p++;
+    if (p >= end || !g_ascii_isdigit(*p)) return 0;
+    if (*p == '0') {
+        p++;
+    } else {
+        while (p < end && g_ascii_isdigit(*p)) p++;
+    }
+    if (p < end && *p == '.') {
+        *is_double = TRUE;
+        p++;
+        if (p >= end || !g_ascii_isdigit(*p)) return 0;
+        while (p < end && g_ascii_isdigit(*p)) p++;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        *is_double = TRUE;
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) p++;
+        if (p >= end || !g_ascii_isdigit(*p)) return 0;
+        while (p < end && g_ascii_isdigit(*p)) p++;
+    }
+    return p - stream->pos;
+}
+
+JsonStreamType
+json_stream_peek(struct JsonStream *stream)
+{
+    if (stream->failed) return JSON_STREAM_ERROR;
+
+    skip_whitespace(stream);
+    if (stream->pos >= stream->end) {
+        fail(stream);
+        return JSON_STREAM_ERROR;
+    }
+
+    switch (*stream->pos) {
+    case '{': return JSON_STREAM_OBJECT;
+    case '[': return JSON_STREAM_ARRAY;
+    case '"': return JSON_STREAM_STRING;
+    case 't':
+    case 'f': return JSON_STREAM_BOOLEAN;
+    case 'n': return JSON_STREAM_NULL;
+    default: {
+        gboolean is_double;
+        if (scan_number(stream, &is_double) > 0) {
+            return is_double ? JSON_STREAM_DOUBLE : JSON_STREAM_INT;
+        }
+        fail(stream);
+        return JSON_STREAM_ERROR;
+    }
+    }
+}
+
+static guint
+hex_digits(const gchar *p)
+{
+    guint value = 0;
+    for (int i = 0; i < 4; i++) {
+        value = (value << 4) | g_ascii_xdigit_value(p[i]);
+    }
+    return value;
+}
+
+// Reads the string at the current position into @out, or only checks it if
+// @out is NULL. Unpaired surrogates become U+FFFD.
+static gboolean
+read_string_into(struct JsonStream *stream, GString *out)
+{
+    const gchar *p = stream->pos + 1;
+    const gchar *end = stream->end;
+    const gchar *run = p;   // Start of the bytes not yet copied to @out
+
+    while (p < end && *p != '"') {
+        guchar c = (guchar)*p;
+        if (c < 0x20) return FALSE;
+        if (c != '\\') {
+            p++;
+            continue;
+        }
+
+        if (out) g_string_append_len(out, run, p - run);
+        if (p + 1 >= end) return FALSE;
+
+        gchar escape = p[1];
+        p += 2;
+        switch (escape) {
+        case '"': case '\\': case '/':
+            if (out) g_string_append_c(out, escape);
+            break;
+        case 'b': if (out) g_string_append_c(out, '\b'); break;
+        case 'f': if (out) g_string_append_c(out, '\f'); break;
+        case 'n': if (out) g_string_append_c(out, '\n'); break;
+        case 'r': if (out) g_string_append_c(out, '\r'); break;
+        case 't': if (out) g_string_append_c(out, '\t'); break;
+        case 'u': {
+            if (end - p < 4 || !g_ascii_isxdigit(p[0]) || !g_ascii_isxdigit(p[1]) ||
+                !g_ascii_isxdigit(p[2]) || !g_ascii_isxdigit(p[3])) {
+                return FALSE;
+            }
+            gunichar ch = hex_digits(p);
+            p += 4;
+            if (ch >= 0xD800 && ch <= 0xDBFF) {
+                if (end - p >= 6 && p[0] == '\\' && p[1] == 'u' && g_ascii_isxdigit(p[2]) &&
+                    g_ascii_isxdigit(p[3]) && g_ascii_isxdigit(p[4]) && g_ascii_isxdigit(p[5])) {
+                    gunichar low = hex_digits(p + 2);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        ch = 0x10000 + ((ch - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    } else {
+                        ch = 0xFFFD;
+                    }
+                } else {
+                    ch = 0xFFFD;
+                }
+            } else if (ch >= 0xDC00 && ch <= 0xDFFF) {
+                ch = 0xFFFD;
+            }
+            if (out) g_string_append_unichar(out, ch);
+            break;
+        }
+        default:
+            return FALSE;
+        }
+        run = p;
+    }
+
+    if (p >= end) return FALSE;
+    if (out) g_string_append_len(out, run, p - run);
+    stream->pos = p + 1;
+    return TRUE;
+}
+
+// Length of the string body at the current position if it has no escapes,
+// -1 otherwise (or if it is unterminated)
+static gssize
+plain_string_length(const struct JsonStream *stream)
+{
+    const gchar *p = stream->pos + 1;
+    while (p < stream->end) {
+        guchar c = (guchar)*p;
+        if (c == '"') return p - (stream->pos + 1);
+        if (c == '\\' || c < 0x20) return -1;
+        p++;
+    }
+    return -1;
+}
+
+const gchar*
+json_stream_read_string_view(struct JsonStream *stream, gsize *length)
+{
+    if (json_stream_peek(stream) != JSON_STREAM_STRING) {
+        json_stream_skip(stream);
+        return NULL;
+    }
+
+    const gchar *view;
+    gssize plain_length = plain_string_length(stream);
+    if (plain_length >= 0) {
+        // Most strings have no escapes and are handed out in place
+        view = stream->pos + 1;
+        *length = plain_length;
+        stream->pos += plain_length + 2;
+    } else {
+        g_string_truncate(stream->scratch, 0);
+        if (!read_string_into(stream, stream->scratch)) {
+            fail(stream);
+            return NULL;
+        }
+        view = stream->scratch->str;
+        *length = stream->scratch->len;
+    }
+
+    // A decoded \u0000 ends the string, as it would for a C string
+    const gchar *valid_end;
+    if (!g_utf8_validate(view, *length, &valid_end)) {
+        if (valid_end == view + *length || *valid_end != '\0') {
+            fail(stream);
+            return NULL;
+        }
+        *length = valid_end - view;
+    }
+    stream->after_value = TRUE;
+    return view;
+}
+
+gchar*
+json_stream_read_string(struct JsonStream *stream)
+{
+    gsize length;
+    const gchar *view = json_stream_read_string_view(stream, &length);
+    return view ? g_strndup(view, length) : NULL;
+}
+
+static gint64
+read_number(struct JsonStream *stream, gboolean *is_double, gdouble *double_value)
+{
+    gsize length = scan_number(stream, is_double);
+    gint64 value = 0;
+
+    if (*is_double) {
+        // g_ascii_strtod() needs a terminated copy since the data is not
+        gchar buffer[64];
+        if (length < sizeof(buffer)) {
+            memcpy(buffer, stream->pos, length);
+            buffer[length] = '\0';
+            *double_value = g_ascii_strtod(buffer, NULL);
+        } else {
+            gchar *copy = g_strndup(stream->pos, length);
+            *double_value = g_ascii_strtod(copy, NULL);
+            g_free(copy);
+        }
+    } else {
+        const gchar *p = stream->pos;
+        gboolean negative = *p == '-';
+        guint64 magnitude = 0;
+        if (negative) p++;
+        for (; p < stream->pos + length; p++) {
+            guint digit = *p - '0';
+            if (magnitude > (G_MAXUINT64 - digit) / 10) {
+                magnitude = G_MAXUINT64;
+                break;
+            }
+            magnitude = magnitude * 10 + digit;
+        }
+        // Saturate like g_ascii_strtoll()
+        if (negative) {
+            value = magnitude > (guint64)G_MAXINT64 ? G_MININT64 : -(gint64)magnitude;
+        } else {
+            value = magnitude > (guint64)G_MAXINT64 ? G_MAXINT64 : (gint64)magnitude;
+        }
+    }
+
+    stream->pos += length;
+    stream->after_value = TRUE;
+    return value;
+}
+
+static gboolean
+read_literal_boolean(struct JsonStream *stream)
+{
+    gboolean value = *stream->pos == 't';
+    if (value) {
+        match_literal(stream, "true", 4);
+    } else {
+        match_literal(stream, "false", 5);
+    }
+    stream->after_value = TRUE;
+    return value;
+}
+
+gint64
+json_stream_read_int(struct JsonStream *stream)
+{
+    gboolean is_double;
+    gdouble double_value = 0.0;
+
+    switch (json_stream_peek(stream)) {
+    case JSON_STREAM_INT:
+    case JSON_STREAM_DOUBLE: {
+        gint64 value = read_number(stream, &is_double, &double_value);
+        return is_double ? (gint64)double_value : value;
+    }
+    case JSON_STREAM_BOOLEAN:
+        return read_literal_boolean(stream) ? 1 : 0;
+    default:
+        json_stream_skip(stream);
+        return 0;
+    }
+}
+
+gboolean
+json_stream_read_boolean(struct JsonStream *stream)
+{
+    gboolean is_double;
+    gdouble double_value = 0.0;
+
+    switch (json_stream_peek(stream)) {
+    case JSON_STREAM_BOOLEAN:
+        return read_literal_boolean(stream);
+    case JSON_STREAM_INT:
+    case JSON_STREAM_DOUBLE: {
+        gint64 value = read_number(stream, &is_double, &double_value);
+        return is_double ? double_value != 0.0 : value != 0;
+    }
+    default:
+        json_stream_skip(stream);
+        return FALSE;
+    }
+}
+
+static gboolean
+begin_container(struct JsonStream *stream, JsonStreamType type)
+{
+    if (json_stream_peek(stream) != type) {
+        json_stream_skip(stream);
+        return FALSE;
+    }
+    if (++stream->depth > JSON_STREAM_MAX_DEPTH) {
+        fail(stream);
+        return FALSE;
+    }
+    stream->pos++;
+    stream->after_value = FALSE;
+    return TRUE;
+}
+
+// Moves past the separator before the next item of the current container.
+// @return FALSE if @close ended it instead.
+static gboolean
+next_item(struct JsonStream *stream, gchar close)
+{
+    if (stream->failed) return FALSE;
+
+    skip_whitespace(stream);
+    if (stream->pos >= stream->end) {
+        fail(stream);
+        return FALSE;
+    }
+    if (*stream->pos == close) {
+        stream->pos++;
+        stream->depth--;
+        stream->after_value = TRUE;
+        return FALSE;
+    }
+    if (stream->after_value) {
+        if (*stream->pos != ',') {
+            fail(stream);
+            return FALSE;
+        }
+        stream->pos++;
+        skip_whitespace(stream);
+    }
+    stream->after_value = FALSE;
+    return TRUE;
+}
+
+gboolean
+json_stream_begin_object(struct JsonStream *stream)
+{
+    return begin_container(stream, JSON_STREAM_OBJECT);
+}
+
+const gchar*
+json_stream_next_member(struct JsonStream *stream)
+{
+    if (!next_item(stream, '}')) return NULL;
+
+    g_string_truncate(stream->key, 0);
+    if (stream->pos >= stream->end || *stream->pos != '"' || !read_string_into(stream, stream->key)) {
+        fail(stream);
+        return NULL;
+    }
+
+    skip_whitespace(stream);
+    if (stream->pos >= stream->end || *stream->pos != ':') {
+        fail(stream);
+        return NULL;
+    }
+    stream->pos++;
+    return stream->key->str;
+}
+
+gboolean
+json_stream_begin_array(struct JsonStream *stream)
+{
+    return begin_container(stream, JSON_STREAM_ARRAY);
+}
+
+gboolean
+json_stream_next_element(struct JsonStream *stream)
+{
+    return next_item(stream, ']');
+}
+
+void
+json_stream_skip(struct JsonStream *stream)
+{
+    gboolean is_double;
+    gdouble double_value;
+
+    switch (json_stream_peek(stream)) {
+    case JSON_STREAM_OBJECT:
+        if (json_stream_begin_object(stream)) {
+            while (json_stream_next_member(stream)) {
+                json_stream_skip(stream);
+            }
+        }
+        break;
+    case JSON_STREAM_ARRAY:
+        if (json_stream_begin_array(stream)) {
+            while (json_stream_next_element(stream)) {
+                json_stream_skip(stream);
+            }
+        }
+        break;
+    case JSON_STREAM_STRING:
+        if (!read_string_into(stream, NULL)) {
+            fail(stream);
+        }
+        stream->after_value = TRUE;
+        break;
+    case JSON_STREAM_INT:
+    case JSON_STREAM_DOUBLE:
+        read_number(stream, &is_double, &double_value);
+        break;
+    case JSON_STREAM_BOOLEAN:
+        read_literal_boolean(stream);
+        break;
+    case JSON_STREAM_NULL:
+        match_literal(stream, "null", 4);
+        stream->after_value = TRUE;
+        break;
+    case JSON_STREAM_ERROR:
+        break;
+    }
+}
+
+gboolean
+json_stream_finish(struct JsonStream *stream)
+{
+    if (stream->failed) return FALSE;
+    skip_whitespace(stream);
+    return stream->pos == stream->end && stream->depth == 0;
+}
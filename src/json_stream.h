@@ -0,0 +1,118 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <glib.h>
+
+// Pull tokenizer over a JSON buffer, for decoders that fill their structs
+// directly instead of going through a json-glib tree. The caller walks the
+// document with begin/next calls and consumes every value it is handed, by
+// reading or skipping it. The first syntax error puts the stream in a
+// failed state in which every call returns right away; check it once with
+// json_stream_finish().
+
+typedef enum {
+    JSON_STREAM_ERROR,   // Malformed input or end of data
+    JSON_STREAM_OBJECT,
+    JSON_STREAM_ARRAY,
+    JSON_STREAM_STRING,
+    JSON_STREAM_INT,
+    JSON_STREAM_DOUBLE,
+    JSON_STREAM_BOOLEAN,
+    JSON_STREAM_NULL
+} JsonStreamType;
+
+struct JsonStream {
+    const gchar *pos;
+    const gchar *end;
+    const gchar *start;
+    gboolean failed;
+    gboolean after_value;  // A value was just consumed, so ',' or a close must follow
+    guint depth;
+    GString *key;          // Last member name, reused between members
+    GString *scratch;      // Last string value that had escapes
+};
+
+/**
+ * @param length Size of @data, or -1 if it is NUL-terminated.
+ */
+void json_stream_init(struct JsonStream *stream, const gchar *data, gssize length);
+
+void json_stream_clear(struct JsonStream *stream);
+
+/**
+ * @return The type of the next value without consuming it.
+ */
+JsonStreamType json_stream_peek(struct JsonStream *stream);
+
+/**
+ * Enters the next value if it is an object, otherwise skips it.
+ * @return TRUE if an object was entered.
+ */
+gboolean json_stream_begin_object(struct JsonStream *stream);
+
+/**
+ * Moves to the next member of the current object. Its value must be
+ * consumed before the next call.
+ * @return The member name, valid until the next call, or NULL once the
+ *         object is closed (or on error).
+ */
+const gchar* json_stream_next_member(struct JsonStream *stream);
+
+/**
+ * Enters the next value if it is an array, otherwise skips it.
+ * @return TRUE if an array was entered.
+ */
+gboolean json_stream_begin_array(struct JsonStream *stream);
+
+/**
+ * Moves to the next element of the current array, which must be consumed
+ * before the next call.
+ * @return FALSE once the array is closed (or on error).
+ */
+gboolean json_stream_next_element(struct JsonStream *stream);
+
+/**
+ * Reads the next value as a string.
+ * @return A newly allocated UTF-8 string, or NULL if the value is not a
+ *         string (it is skipped).
+ */
+gchar* json_stream_read_string(struct JsonStream *stream);
+
+/**
+ * Like json_stream_read_string(), without a copy: the result points into the
+ * input when the string has no escapes.
+ * @param length Set to the length of the string, which is not NUL-terminated.
+ * @return The string, valid until the next call on @stream, or NULL if the
+ *         value is not a string.
+ */
+const gchar* json_stream_read_string_view(struct JsonStream *stream, gsize *length);
+
+/**
+ * Reads the next value like json_node_get_int(): doubles are truncated,
+ * booleans are 0 or 1 and anything else is 0.
+ */
+gint64 json_stream_read_int(struct JsonStream *stream);
+
+/**
+ * Reads the next value like json_node_get_boolean(): numbers are TRUE if
+ * non-zero and anything else is FALSE.
+ */
+gboolean json_stream_read_boolean(struct JsonStream *stream);
+
+/**
+ * Consumes the next value, checking its syntax.
+ */
+void json_stream_skip(struct JsonStream *stream);
+
+/**
+ * @return TRUE if the whole document was well-formed and nothing but
+ *         whitespace follows the root value.
+ */
+gboolean json_stream_finish(struct JsonStream *stream);
+
+/**
+ * @return Byte offset of the current position, e.g. for error messages.
+ */
+gsize json_stream_get_offset(const struct JsonStream *stream);
+
+#endif // JSON_STREAM_H
@@ -1,4 +1,8 @@
+#include <string.h>
 #include <json-glib/json-glib.h>
+#include "json_stream.h"
+#include "memory_pool.h"
+#include "string_intern.h"
 #include "json_utils.h"
 
 static GList*
@@ -14,406 +18,510 @@ parse_attachments(JsonObject *post_object)
             attach->id = g_strdup(json_object_get_string_member(attach_obj, "id"));
             attach->file_url = g_strdup(json_object_get_string_member(attach_obj, "file_url"));
             attach->file_type = g_strdup(json_object_get_string_member(attach_obj, "file_type"));
-            attachments = g_list_append(attachments, attach);
+            attachments = g_list_prepend(attachments, attach);
         }
     }
-    return attachments;
+    return g_list_reverse(attachments);
 }
 
-GList*
-parse_tweets(const gchar *json_data)
+// Which flag of struct Tweet a member sets
+enum {
+    TWEET_FLAG_LIKED,
+    TWEET_FLAG_RETWEETED,
+    TWEET_FLAG_BOOKMARKED,
+    TWEET_FLAG_COUNT
+};
+
+struct FlagAlias {
+    const gchar *key;
+    guint flag;
+    guint rank;         // When several spellings are present the lowest rank wins
+    gboolean strict;    // Only booleans and integers count, anything else is FALSE
+    gboolean feed_only; // Spellings only the feed endpoints use
+};
+
+static const struct FlagAlias flag_aliases[] = {
+    { "liked_by_user",     TWEET_FLAG_LIKED,      1, TRUE,  FALSE },
+    { "liked",             TWEET_FLAG_LIKED,      2, FALSE, FALSE },
+    { "is_liked",          TWEET_FLAG_LIKED,      3, FALSE, TRUE },
+    { "user_liked",        TWEET_FLAG_LIKED,      4, FALSE, TRUE },
+    { "retweeted_by_user", TWEET_FLAG_RETWEETED,  1, TRUE,  FALSE },
+    { "retweeted",         TWEET_FLAG_RETWEETED,  2, FALSE, FALSE },
+    { "is_retweeted",      TWEET_FLAG_RETWEETED,  3, FALSE, TRUE },
+    { "user_retweeted",    TWEET_FLAG_RETWEETED,  4, FALSE, TRUE },
+    { "bookmarked",        TWEET_FLAG_BOOKMARKED, 1, FALSE, FALSE },
+    { "is_bookmarked",     TWEET_FLAG_BOOKMARKED, 2, FALSE, TRUE },
+    { "user_bookmarked",   TWEET_FLAG_BOOKMARKED, 3, FALSE, TRUE },
+};
+
+// A GList whose nodes live in an arena. Only its head is handed out, and it
+// is never freed with the g_list functions.
+struct ArenaList {
+    GList *head;
+    GList *tail;
+};
+
+static void
+arena_list_append(struct MemoryArena *arena, struct ArenaList *list, gpointer data)
 {
-    JsonParser *parser;
-    GError *error = NULL;
-    GList *tweets = NULL;
+    GList *link = memory_arena_alloc(arena, sizeof(GList));
+    link->data = data;
+    link->prev = list->tail;
+    if (list->tail) {
+        list->tail->next = link;
+    } else {
+        list->head = link;
+    }
+    list->tail = link;
+}
 
-    parser = json_parser_new();
-    json_parser_load_from_data(parser, json_data, -1, &error);
-    if (error) {
-        g_warning("Unable to parse json: %s", error->message);
-        g_error_free(error);
-        g_object_unref(parser);
-        return NULL;
+// State for filling one struct Tweet member by member, in whatever order the
+// server sent them
+struct TweetDecoder {
+    struct MemoryArena *arena;          // Holds the tweet and everything it points to
+    struct Tweet *tweet;
+    gboolean feed;                      // Accept the feed-only flag spellings
+    guint flag_ranks[TWEET_FLAG_COUNT]; // Rank of the spelling each flag came from, 0 if none yet
+    gboolean has_id;
+    gboolean has_author;                // "author" is an object
+};
+
+static gboolean*
+tweet_flag(struct Tweet *tweet, guint flag)
+{
+    switch (flag) {
+    case TWEET_FLAG_LIKED: return &tweet->liked;
+    case TWEET_FLAG_RETWEETED: return &tweet->retweeted;
+    default: return &tweet->bookmarked;
     }
+}
 
-    JsonNode *root_node = json_parser_get_root(parser);
-    JsonObject *root_object = json_node_get_object(root_node);
-    
-    if (json_object_has_member(root_object, "posts")) {
-        JsonArray *posts = json_object_get_array_member(root_object, "posts");
-
-        for (guint i = 0; i < json_array_get_length(posts); i++) {
-            JsonNode *post_node = json_array_get_element(posts, i);
-            JsonObject *post_object = json_node_get_object(post_node);
-            JsonObject *author_object = json_object_get_object_member(post_object, "author");
-
-            struct Tweet *tweet = g_new0(struct Tweet, 1);
-            tweet->content = g_strdup(json_object_get_string_member(post_object, "content"));
-            tweet->author_name = g_strdup(json_object_get_string_member(author_object, "name"));
-            tweet->author_username = g_strdup(json_object_get_string_member(author_object, "username"));
-            if (json_object_has_member(author_object, "avatar") && !json_node_is_null(json_object_get_member(author_object, "avatar"))) {
-                tweet->author_avatar = g_strdup(json_object_get_string_member(author_object, "avatar"));
-            } else {
-                tweet->author_avatar = NULL;
-            }
+// Replaces *@field with the next value, so the last duplicate member wins.
+// The previous value stays in the arena until the page is freed.
+static void
+read_string_field(struct MemoryArena *arena, struct JsonStream *stream, gchar **field)
+{
+    gsize length;
+    const gchar *view = json_stream_read_string_view(stream, &length);
+    *field = view ? memory_arena_strndup(arena, view, length) : NULL;
+}
 
-            if (json_object_has_member(post_object, "id")) {
-                tweet->id = g_strdup(json_object_get_string_member(post_object, "id"));
+// Like read_string_field() for the author fields, which repeat across posts
+// and pages and are interned instead of copied into the arena
+static void
+read_interned_field(struct JsonStream *stream, const gchar **field)
+{
+    gsize length;
+    const gchar *view = json_stream_read_string_view(stream, &length);
+    *field = view ? string_intern_len(view, length) : NULL;
+}
+
+static void
+decode_author(struct TweetDecoder *decoder, struct JsonStream *stream)
+{
+    struct Tweet *tweet = decoder->tweet;
+    tweet->author_name = NULL;
+    tweet->author_username = NULL;
+    tweet->author_avatar = NULL;
+
+    decoder->has_author = json_stream_begin_object(stream);
+    if (!decoder->has_author) return;
+
+    const gchar *key;
+    while ((key = json_stream_next_member(stream))) {
+        if (strcmp(key, "name") == 0) {
+            read_interned_field(stream, &tweet->author_name);
+        } else if (strcmp(key, "username") == 0) {
+            read_interned_field(stream, &tweet->author_username);
+        } else if (strcmp(key, "avatar") == 0) {
+            read_interned_field(stream, &tweet->author_avatar);
+        } else {
+            json_stream_skip(stream);
+        }
+    }
+}
+
+static void
+decode_fact_check(struct TweetDecoder *decoder, struct JsonStream *stream)
+{
+    struct Tweet *tweet = decoder->tweet;
+    tweet->note = NULL;
+    tweet->note_severity = NULL;
+
+    if (!json_stream_begin_object(stream)) return;
+
+    const gchar *key;
+    while ((key = json_stream_next_member(stream))) {
+        if (strcmp(key, "note") == 0) {
+            read_string_field(decoder->arena, stream, &tweet->note);
+        } else if (strcmp(key, "severity") == 0) {
+            read_string_field(decoder->arena, stream, &tweet->note_severity);
+        } else {
+            json_stream_skip(stream);
+        }
+    }
+}
+
+static GList*
+decode_attachments(struct MemoryArena *arena, struct JsonStream *stream)
+{
+    struct ArenaList attachments = { NULL, NULL };
+
+    if (!json_stream_begin_array(stream)) return NULL;
+
+    while (json_stream_next_element(stream)) {
+        if (!json_stream_begin_object(stream)) continue;
+
+        struct Attachment *attach = memory_arena_alloc(arena, sizeof(struct Attachment));
+        const gchar *key;
+        while ((key = json_stream_next_member(stream))) {
+            if (strcmp(key, "id") == 0) {
+                read_string_field(arena, stream, &attach->id);
+            } else if (strcmp(key, "file_url") == 0) {
+                read_string_field(arena, stream, &attach->file_url);
+            } else if (strcmp(key, "file_type") == 0) {
+                read_string_field(arena, stream, &attach->file_type);
             } else {
-                tweet->id = NULL;
+                json_stream_skip(stream);
             }
+        }
+        arena_list_append(arena, &attachments, attach);
+    }
+    return attachments.head;
+}
 
-            if (json_object_has_member(post_object, "fact_check") && !json_node_is_null(json_object_get_member(post_object, "fact_check"))) {
-                JsonNode *fc_node = json_object_get_member(post_object, "fact_check");
-                if (JSON_NODE_HOLDS_OBJECT(fc_node)) {
-                    JsonObject *fact_check = json_node_get_object(fc_node);
-                    if (json_object_has_member(fact_check, "note")) {
-                        tweet->note = g_strdup(json_object_get_string_member(fact_check, "note"));
-                    }
-                    if (json_object_has_member(fact_check, "severity")) {
-                        tweet->note_severity = g_strdup(json_object_get_string_member(fact_check, "severity"));
-                    }
-                }
-            }
+// Reads a *_by_user flag, which only counts if it is a boolean or an integer
+static gboolean
+read_strict_flag(struct JsonStream *stream)
+{
+    switch (json_stream_peek(stream)) {
+    case JSON_STREAM_BOOLEAN:
+        return json_stream_read_boolean(stream);
+    case JSON_STREAM_INT:
+        return json_stream_read_int(stream) != 0;
+    default:
+        json_stream_skip(stream);
+        return FALSE;
+    }
+}
 
-            tweet->attachments = parse_attachments(post_object);
+static gboolean
+decode_flag(struct TweetDecoder *decoder, struct JsonStream *stream, const gchar *key)
+{
+    for (guint i = 0; i < G_N_ELEMENTS(flag_aliases); i++) {
+        const struct FlagAlias *alias = &flag_aliases[i];
+        if (strcmp(key, alias->key) != 0) continue;
+        if (alias->feed_only && !decoder->feed) return FALSE;
+
+        guint *rank = &decoder->flag_ranks[alias->flag];
+        if (*rank != 0 && *rank < alias->rank) {
+            // A preferred spelling was already seen
+            json_stream_skip(stream);
+            return TRUE;
+        }
+        *rank = alias->rank;
+        *tweet_flag(decoder->tweet, alias->flag) = alias->strict ? read_strict_flag(stream)
+                                                                 : json_stream_read_boolean(stream);
+        return TRUE;
+    }
+    return FALSE;
+}
 
-            tweet->liked = FALSE;
-            if (json_object_has_member(post_object, "liked_by_user")) {
-                JsonNode *node = json_object_get_member(post_object, "liked_by_user");
-                if (JSON_NODE_HOLDS_VALUE(node)) {
-                    if (json_node_get_value_type(node) == G_TYPE_BOOLEAN)
-                        tweet->liked = json_node_get_boolean(node);
-                    else if (json_node_get_value_type(node) == G_TYPE_INT64)
-                        tweet->liked = json_node_get_int(node) != 0;
-                }
-            } else if (json_object_has_member(post_object, "liked")) {
-                tweet->liked = json_object_get_boolean_member(post_object, "liked");
-            } else if (json_object_has_member(post_object, "is_liked")) {
-                tweet->liked = json_object_get_boolean_member(post_object, "is_liked");
-            } else if (json_object_has_member(post_object, "user_liked")) {
-                tweet->liked = json_object_get_boolean_member(post_object, "user_liked");
-            }
+static void
+decode_tweet_member(struct TweetDecoder *decoder, struct JsonStream *stream, const gchar *key)
+{
+    struct Tweet *tweet = decoder->tweet;
+
+    if (strcmp(key, "id") == 0) {
+        read_string_field(decoder->arena, stream, &tweet->id);
+        decoder->has_id = TRUE;
+    } else if (strcmp(key, "content") == 0) {
+        read_string_field(decoder->arena, stream, &tweet->content);
+    } else if (strcmp(key, "author") == 0) {
+        decode_author(decoder, stream);
+    } else if (strcmp(key, "fact_check") == 0) {
+        decode_fact_check(decoder, stream);
+    } else if (strcmp(key, "attachments") == 0) {
+        tweet->attachments = decode_attachments(decoder->arena, stream);
+    } else if (strcmp(key, "likes") == 0) {
+        tweet->like_count = (int)json_stream_read_int(stream);
+    } else if (strcmp(key, "retweets") == 0) {
+        tweet->retweet_count = (int)json_stream_read_int(stream);
+    } else if (strcmp(key, "replies") == 0) {
+        tweet->reply_count = (int)json_stream_read_int(stream);
+    } else if (!decode_flag(decoder, stream, key)) {
+        json_stream_skip(stream);
+    }
+}
 
-            tweet->retweeted = FALSE;
-            if (json_object_has_member(post_object, "retweeted_by_user")) {
-                JsonNode *node = json_object_get_member(post_object, "retweeted_by_user");
-                if (JSON_NODE_HOLDS_VALUE(node)) {
-                    if (json_node_get_value_type(node) == G_TYPE_BOOLEAN)
-                        tweet->retweeted = json_node_get_boolean(node);
-                    else if (json_node_get_value_type(node) == G_TYPE_INT64)
-                        tweet->retweeted = json_node_get_int(node) != 0;
-                }
-            } else if (json_object_has_member(post_object, "retweeted")) {
-                tweet->retweeted = json_object_get_boolean_member(post_object, "retweeted");
-            } else if (json_object_has_member(post_object, "is_retweeted")) {
-                tweet->retweeted = json_object_get_boolean_member(post_object, "is_retweeted");
-            } else if (json_object_has_member(post_object, "user_retweeted")) {
-                tweet->retweeted = json_object_get_boolean_member(post_object, "user_retweeted");
-            }
+static void
+tweet_decoder_init(struct TweetDecoder *decoder, struct MemoryArena *arena, gboolean feed)
+{
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->arena = arena;
+    decoder->feed = feed;
+}
 
-            tweet->bookmarked = FALSE;
-            if (json_object_has_member(post_object, "bookmarked")) {
-                tweet->bookmarked = json_object_get_boolean_member(post_object, "bookmarked");
-            } else if (json_object_has_member(post_object, "is_bookmarked")) {
-                tweet->bookmarked = json_object_get_boolean_member(post_object, "is_bookmarked");
-            } else if (json_object_has_member(post_object, "user_bookmarked")) {
-                tweet->bookmarked = json_object_get_boolean_member(post_object, "user_bookmarked");
-            }
+// Decodes the next value into a new tweet if it is an object, otherwise
+// skips it and leaves decoder->tweet NULL
+static void
+decode_tweet_object(struct TweetDecoder *decoder, struct JsonStream *stream)
+{
+    if (!json_stream_begin_object(stream)) return;
 
-            if (json_object_has_member(post_object, "likes")) {
-                tweet->like_count = json_object_get_int_member(post_object, "likes");
-            }
+    decoder->tweet = memory_arena_alloc(decoder->arena, sizeof(struct Tweet));
+    const gchar *key;
+    while ((key = json_stream_next_member(stream))) {
+        decode_tweet_member(decoder, stream, key);
+    }
+}
 
-            if (json_object_has_member(post_object, "retweets")) {
-                tweet->retweet_count = json_object_get_int_member(post_object, "retweets");
-            }
+// @param feed Whether to accept the flag spellings of the feed endpoints.
+static struct Tweet*
+decode_tweet(struct MemoryArena *arena, struct JsonStream *stream, gboolean feed)
+{
+    struct TweetDecoder decoder;
+    tweet_decoder_init(&decoder, arena, feed);
+    decode_tweet_object(&decoder, stream);
+    return decoder.tweet;
+}
 
-            if (json_object_has_member(post_object, "replies")) {
-                tweet->reply_count = json_object_get_int_member(post_object, "replies");
-            }
+// Decodes an array of posts into @tweets, replacing what it held and
+// skipping elements that are not objects
+static void
+decode_tweet_array(struct MemoryArena *arena, struct JsonStream *stream, gboolean feed, GPtrArray *tweets)
+{
+    g_ptr_array_set_size(tweets, 0);
+    if (!json_stream_begin_array(stream)) return;
 
-            tweets = g_list_append(tweets, tweet);
+    while (json_stream_next_element(stream)) {
+        struct Tweet *tweet = decode_tweet(arena, stream, feed);
+        if (tweet) {
+            g_ptr_array_add(tweets, tweet);
         }
     }
+}
 
-    g_object_unref(parser);
-    return tweets;
+static struct TweetPage*
+tweet_page_new(void)
+{
+    struct TweetPage *page = g_new0(struct TweetPage, 1);
+    page->ref_count = 1;
+    // No free function: the tweets live in the arena
+    page->tweets = g_ptr_array_new();
+    memory_arena_init(&page->arena);
+    return page;
 }
 
-static struct Tweet*
-parse_single_tweet(JsonObject *post_object)
+struct TweetPage*
+tweet_page_ref(struct TweetPage *page)
 {
-    JsonObject *author_object = json_object_get_object_member(post_object, "author");
+    g_atomic_int_inc(&page->ref_count);
+    return page;
+}
 
-    struct Tweet *tweet = g_new0(struct Tweet, 1);
-    tweet->content = g_strdup(json_object_get_string_member(post_object, "content"));
-    tweet->author_name = g_strdup(json_object_get_string_member(author_object, "name"));
-    tweet->author_username = g_strdup(json_object_get_string_member(author_object, "username"));
-    if (json_object_has_member(author_object, "avatar") && !json_node_is_null(json_object_get_member(author_object, "avatar"))) {
-        tweet->author_avatar = g_strdup(json_object_get_string_member(author_object, "avatar"));
+void
+tweet_page_unref(struct TweetPage *page)
+{
+    if (page && g_atomic_int_dec_and_test(&page->ref_count)) {
+        g_ptr_array_unref(page->tweets);
+        memory_arena_release(&page->arena);
+        g_free(page);
     }
+}
 
-    if (json_object_has_member(post_object, "id")) {
-        tweet->id = g_strdup(json_object_get_string_member(post_object, "id"));
-    }
+static void
+warn_syntax_error(const struct JsonStream *stream)
+{
+    g_warning("Unable to parse json: syntax error at offset %" G_GSIZE_FORMAT,
+              json_stream_get_offset(stream));
+}
 
-    if (json_object_has_member(post_object, "fact_check") && !json_node_is_null(json_object_get_member(post_object, "fact_check"))) {
-        JsonNode *fc_node = json_object_get_member(post_object, "fact_check");
-        if (JSON_NODE_HOLDS_OBJECT(fc_node)) {
-            JsonObject *fact_check = json_node_get_object(fc_node);
-            if (json_object_has_member(fact_check, "note")) {
-                tweet->note = g_strdup(json_object_get_string_member(fact_check, "note"));
-            }
-            if (json_object_has_member(fact_check, "severity")) {
-                tweet->note_severity = g_strdup(json_object_get_string_member(fact_check, "severity"));
+// Decodes the array of posts under @member of the root object, straight from
+// the response bytes without building a JsonNode tree.
+// @return NULL if @json_data is malformed.
+static struct TweetPage*
+decode_tweet_page(const gchar *json_data, const gchar *member)
+{
+    struct JsonStream stream;
+    struct TweetPage *page = tweet_page_new();
+
+    json_stream_init(&stream, json_data, -1);
+    if (json_stream_begin_object(&stream)) {
+        const gchar *key;
+        while ((key = json_stream_next_member(&stream))) {
+            if (strcmp(key, member) == 0) {
+                decode_tweet_array(&page->arena, &stream, TRUE, page->tweets);
+            } else {
+                json_stream_skip(&stream);
             }
         }
     }
 
-    tweet->attachments = parse_attachments(post_object);
-
-    tweet->liked = FALSE;
-    if (json_object_has_member(post_object, "liked_by_user")) {
-        JsonNode *node = json_object_get_member(post_object, "liked_by_user");
-        if (JSON_NODE_HOLDS_VALUE(node)) {
-            if (json_node_get_value_type(node) == G_TYPE_BOOLEAN)
-                tweet->liked = json_node_get_boolean(node);
-            else if (json_node_get_value_type(node) == G_TYPE_INT64)
-                tweet->liked = json_node_get_int(node) != 0;
-        }
-    } else if (json_object_has_member(post_object, "liked")) {
-        tweet->liked = json_object_get_boolean_member(post_object, "liked");
-    }
-
-    tweet->retweeted = FALSE;
-    if (json_object_has_member(post_object, "retweeted_by_user")) {
-        JsonNode *node = json_object_get_member(post_object, "retweeted_by_user");
-        if (JSON_NODE_HOLDS_VALUE(node)) {
-            if (json_node_get_value_type(node) == G_TYPE_BOOLEAN)
-                tweet->retweeted = json_node_get_boolean(node);
-            else if (json_node_get_value_type(node) == G_TYPE_INT64)
-                tweet->retweeted = json_node_get_int(node) != 0;
-        }
-    } else if (json_object_has_member(post_object, "retweeted")) {
-        tweet->retweeted = json_object_get_boolean_member(post_object, "retweeted");
+    if (!json_stream_finish(&stream)) {
+        warn_syntax_error(&stream);
+        tweet_page_unref(page);
+        page = NULL;
     }
+    json_stream_clear(&stream);
+    return page;
+}
 
-    tweet->bookmarked = FALSE;
-    if (json_object_has_member(post_object, "bookmarked")) {
-        tweet->bookmarked = json_object_get_boolean_member(post_object, "bookmarked");
-    }
+struct TweetPage*
+parse_tweets(const gchar *json_data)
+{
+    return decode_tweet_page(json_data, "posts");
+}
 
-    if (json_object_has_member(post_object, "likes")) {
-        tweet->like_count = json_object_get_int_member(post_object, "likes");
-    }
-    if (json_object_has_member(post_object, "retweets")) {
-        tweet->retweet_count = json_object_get_int_member(post_object, "retweets");
-    }
-    if (json_object_has_member(post_object, "replies")) {
-        tweet->reply_count = json_object_get_int_member(post_object, "replies");
+// Appends the posts of @tweets to @dest, except those with the id @skip_id
+static void
+append_tweets_except(GPtrArray *dest, GPtrArray *tweets, const gchar *skip_id)
+{
+    for (guint i = 0; i < tweets->len; i++) {
+        struct Tweet *tweet = g_ptr_array_index(tweets, i);
+        if (skip_id && g_strcmp0(tweet->id, skip_id) == 0) continue;
+        g_ptr_array_add(dest, tweet);
     }
-
-    return tweet;
 }
 
-GList*
+struct TweetPage*
 parse_tweet_details(const gchar *json_data)
 {
-    JsonParser *parser = json_parser_new();
-    GError *error = NULL;
-    GList *tweets = NULL;
-
-    json_parser_load_from_data(parser, json_data, -1, &error);
-    if (!error) {
-        JsonNode *root = json_parser_get_root(parser);
-        JsonObject *obj = json_node_get_object(root);
-        gchar *main_id = NULL;
-
-        if (json_object_has_member(obj, "tweet")) {
-            JsonObject *post_obj = json_object_get_object_member(obj, "tweet");
-            main_id = g_strdup(json_object_get_string_member(post_obj, "id"));
-        }
-
-        // 1. threadPosts (Parents)
-        if (json_object_has_member(obj, "threadPosts")) {
-            JsonArray *arr = json_object_get_array_member(obj, "threadPosts");
-            for (guint i = 0; i < json_array_get_length(arr); i++) {
-                JsonObject *post_obj = json_array_get_object_element(arr, i);
-                const gchar *id = json_object_get_string_member(post_obj, "id");
-                // Don't add the main tweet again if it's in threadPosts
-                if (main_id && g_strcmp0(id, main_id) == 0) continue;
-                tweets = g_list_append(tweets, parse_single_tweet(post_obj));
+    struct JsonStream stream;
+    struct TweetPage *page = tweet_page_new();
+    GPtrArray *thread = g_ptr_array_new();
+    GPtrArray *replies = g_ptr_array_new();
+    struct Tweet *main_tweet = NULL;
+
+    json_stream_init(&stream, json_data, -1);
+    if (json_stream_begin_object(&stream)) {
+        const gchar *key;
+        while ((key = json_stream_next_member(&stream))) {
+            if (strcmp(key, "threadPosts") == 0) {
+                decode_tweet_array(&page->arena, &stream, FALSE, thread);
+            } else if (strcmp(key, "tweet") == 0) {
+                main_tweet = decode_tweet(&page->arena, &stream, FALSE);
+            } else if (strcmp(key, "replies") == 0) {
+                decode_tweet_array(&page->arena, &stream, FALSE, replies);
+            } else {
+                json_stream_skip(&stream);
             }
         }
+    }
 
-        // 2. The main tweet
-        if (json_object_has_member(obj, "tweet")) {
-            JsonObject *post_obj = json_object_get_object_member(obj, "tweet");
-            tweets = g_list_append(tweets, parse_single_tweet(post_obj));
+    if (json_stream_finish(&stream)) {
+        // Parents, then the main tweet, then replies, whatever order the
+        // members came in. The main tweet may also be listed in either array.
+        const gchar *main_id = main_tweet ? main_tweet->id : NULL;
+        append_tweets_except(page->tweets, thread, main_id);
+        if (main_tweet) {
+            g_ptr_array_add(page->tweets, main_tweet);
         }
-
-        // 3. replies
-        if (json_object_has_member(obj, "replies")) {
-            JsonArray *arr = json_object_get_array_member(obj, "replies");
-            for (guint i = 0; i < json_array_get_length(arr); i++) {
-                JsonObject *post_obj = json_array_get_object_element(arr, i);
-                const gchar *id = json_object_get_string_member(post_obj, "id");
-                // Safety check against duplicates
-                if (main_id && g_strcmp0(id, main_id) == 0) continue;
-                tweets = g_list_append(tweets, parse_single_tweet(post_obj));
-            }
-        }
-        g_free(main_id);
+        append_tweets_except(page->tweets, replies, main_id);
     } else {
-        g_error_free(error);
+        tweet_page_unref(page);
+        page = NULL;
     }
-    g_object_unref(parser);
-    return tweets;
+
+    g_ptr_array_unref(thread);
+    g_ptr_array_unref(replies);
+    json_stream_clear(&stream);
+    return page;
 }
 
-struct Profile*
-parse_profile(const gchar *json_data)
+// Replaces *@field with a copy of the next value, so the last duplicate
+// member wins
+static void
+read_owned_string(struct JsonStream *stream, gchar **field)
 {
-    JsonParser *parser = json_parser_new();
-    GError *error = NULL;
-    struct Profile *profile = NULL;
+    g_free(*field);
+    *field = json_stream_read_string(stream);
+}
 
-    json_parser_load_from_data(parser, json_data, -1, &error);
-    if (!error) {
-        JsonNode *root = json_parser_get_root(parser);
-        JsonObject *obj = json_node_get_object(root);
-        if (json_object_has_member(obj, "profile")) {
-            JsonObject *p_obj = json_object_get_object_member(obj, "profile");
-            profile = g_new0(struct Profile, 1);
-            profile->name = g_strdup(json_object_get_string_member(p_obj, "name"));
-            profile->username = g_strdup(json_object_get_string_member(p_obj, "username"));
-            profile->bio = g_strdup(json_object_get_string_member(p_obj, "bio"));
-            if (json_object_has_member(p_obj, "avatar") && !json_node_is_null(json_object_get_member(p_obj, "avatar"))) {
-                profile->avatar = g_strdup(json_object_get_string_member(p_obj, "avatar"));
-            }
-            profile->follower_count = json_object_get_int_member(p_obj, "follower_count");
-            profile->following_count = json_object_get_int_member(p_obj, "following_count");
-            profile->post_count = json_object_get_int_member(p_obj, "post_count");
+// Decodes the next value into a new profile if it is an object
+static struct Profile*
+decode_profile(struct JsonStream *stream)
+{
+    if (!json_stream_begin_object(stream)) return NULL;
+
+    struct Profile *profile = g_new0(struct Profile, 1);
+    const gchar *key;
+    while ((key = json_stream_next_member(stream))) {
+        if (strcmp(key, "name") == 0) {
+            read_owned_string(stream, &profile->name);
+        } else if (strcmp(key, "username") == 0) {
+            read_owned_string(stream, &profile->username);
+        } else if (strcmp(key, "bio") == 0) {
+            read_owned_string(stream, &profile->bio);
+        } else if (strcmp(key, "avatar") == 0) {
+            read_owned_string(stream, &profile->avatar);
+        } else if (strcmp(key, "follower_count") == 0) {
+            profile->follower_count = (int)json_stream_read_int(stream);
+        } else if (strcmp(key, "following_count") == 0) {
+            profile->following_count = (int)json_stream_read_int(stream);
+        } else if (strcmp(key, "post_count") == 0) {
+            profile->post_count = (int)json_stream_read_int(stream);
+        } else {
+            json_stream_skip(stream);
         }
-    } else {
-        g_error_free(error);
     }
-    g_object_unref(parser);
     return profile;
 }
 
-GList*
-parse_profile_replies(const gchar *json_data)
+struct TweetPage*
+parse_profile_page(const gchar *json_data, struct Profile **profile_out)
 {
-    JsonParser *parser = json_parser_new();
-    GError *error = NULL;
-    GList *tweets = NULL;
-
-    json_parser_load_from_data(parser, json_data, -1, &error);
-    if (!error) {
-        JsonNode *root = json_parser_get_root(parser);
-        JsonObject *obj = json_node_get_object(root);
-        if (json_object_has_member(obj, "replies")) {
-            JsonArray *replies = json_object_get_array_member(obj, "replies");
-            for (guint i = 0; i < json_array_get_length(replies); i++) {
-                JsonNode *reply_node = json_array_get_element(replies, i);
-                JsonObject *reply_obj = json_node_get_object(reply_node);
-                JsonObject *author_obj = json_object_get_object_member(reply_obj, "author");
-
-                struct Tweet *tweet = g_new0(struct Tweet, 1);
-                tweet->content = g_strdup(json_object_get_string_member(reply_obj, "content"));
-                tweet->author_name = g_strdup(json_object_get_string_member(author_obj, "name"));
-                tweet->author_username = g_strdup(json_object_get_string_member(author_obj, "username"));
-                if (json_object_has_member(author_obj, "avatar") && !json_node_is_null(json_object_get_member(author_obj, "avatar"))) {
-                    tweet->author_avatar = g_strdup(json_object_get_string_member(author_obj, "avatar"));
-                }
-                tweet->id = g_strdup(json_object_get_string_member(reply_obj, "id"));
-                
-                if (json_object_has_member(reply_obj, "fact_check") && !json_node_is_null(json_object_get_member(reply_obj, "fact_check"))) {
-                    JsonNode *fc_node = json_object_get_member(reply_obj, "fact_check");
-                    if (JSON_NODE_HOLDS_OBJECT(fc_node)) {
-                        JsonObject *fact_check = json_node_get_object(fc_node);
-                        if (json_object_has_member(fact_check, "note")) {
-                            tweet->note = g_strdup(json_object_get_string_member(fact_check, "note"));
-                        }
-                        if (json_object_has_member(fact_check, "severity")) {
-                            tweet->note_severity = g_strdup(json_object_get_string_member(fact_check, "severity"));
-                        }
-                    }
-                }
-
-                tweet->attachments = parse_attachments(reply_obj);
-
-                tweet->liked = FALSE;
-                if (json_object_has_member(reply_obj, "liked_by_user")) {
-                    JsonNode *node = json_object_get_member(reply_obj, "liked_by_user");
-                    if (JSON_NODE_HOLDS_VALUE(node)) {
-                        if (json_node_get_value_type(node) == G_TYPE_BOOLEAN)
-                            tweet->liked = json_node_get_boolean(node);
-                        else if (json_node_get_value_type(node) == G_TYPE_INT64)
-                            tweet->liked = json_node_get_int(node) != 0;
-                    }
-                } else if (json_object_has_member(reply_obj, "liked")) {
-                    tweet->liked = json_object_get_boolean_member(reply_obj, "liked");
-                } else if (json_object_has_member(reply_obj, "is_liked")) {
-                    tweet->liked = json_object_get_boolean_member(reply_obj, "is_liked");
-                } else if (json_object_has_member(reply_obj, "user_liked")) {
-                    tweet->liked = json_object_get_boolean_member(reply_obj, "user_liked");
-                }
-
-                tweet->retweeted = FALSE;
-                if (json_object_has_member(reply_obj, "retweeted_by_user")) {
-                    JsonNode *node = json_object_get_member(reply_obj, "retweeted_by_user");
-                    if (JSON_NODE_HOLDS_VALUE(node)) {
-                        if (json_node_get_value_type(node) == G_TYPE_BOOLEAN)
-                            tweet->retweeted = json_node_get_boolean(node);
-                        else if (json_node_get_value_type(node) == G_TYPE_INT64)
-                            tweet->retweeted = json_node_get_int(node) != 0;
-                    }
-                } else if (json_object_has_member(reply_obj, "retweeted")) {
-                    tweet->retweeted = json_object_get_boolean_member(reply_obj, "retweeted");
-                } else if (json_object_has_member(reply_obj, "is_retweeted")) {
-                    tweet->retweeted = json_object_get_boolean_member(reply_obj, "is_retweeted");
-                } else if (json_object_has_member(reply_obj, "user_retweeted")) {
-                    tweet->retweeted = json_object_get_boolean_member(reply_obj, "user_retweeted");
-                }
-
-                tweet->bookmarked = FALSE;
-                if (json_object_has_member(reply_obj, "bookmarked")) {
-                    tweet->bookmarked = json_object_get_boolean_member(reply_obj, "bookmarked");
-                } else if (json_object_has_member(reply_obj, "is_bookmarked")) {
-                    tweet->bookmarked = json_object_get_boolean_member(reply_obj, "is_bookmarked");
-                } else if (json_object_has_member(reply_obj, "user_bookmarked")) {
-                    tweet->bookmarked = json_object_get_boolean_member(reply_obj, "user_bookmarked");
-                }
-
-                if (json_object_has_member(reply_obj, "likes")) {
-                    tweet->like_count = json_object_get_int_member(reply_obj, "likes");
-                }
-                if (json_object_has_member(reply_obj, "retweets")) {
-                    tweet->retweet_count = json_object_get_int_member(reply_obj, "retweets");
-                }
-                if (json_object_has_member(reply_obj, "replies")) {
-                    tweet->reply_count = json_object_get_int_member(reply_obj, "replies");
-                }
+    struct JsonStream stream;
+    struct TweetPage *page = tweet_page_new();
+    struct Profile *profile = NULL;
 
-                tweets = g_list_append(tweets, tweet);
+    json_stream_init(&stream, json_data, -1);
+    if (json_stream_begin_object(&stream)) {
+        const gchar *key;
+        while ((key = json_stream_next_member(&stream))) {
+            if (strcmp(key, "profile") == 0) {
+                if (profile) free_user(profile);
+                profile = decode_profile(&stream);
+            } else if (strcmp(key, "posts") == 0) {
+                decode_tweet_array(&page->arena, &stream, TRUE, page->tweets);
+            } else {
+                json_stream_skip(&stream);
             }
         }
-    } else {
-        g_error_free(error);
     }
-    g_object_unref(parser);
-    return tweets;
+
+    if (!json_stream_finish(&stream)) {
+        warn_syntax_error(&stream);
+        if (profile) free_user(profile);
+        profile = NULL;
+        tweet_page_unref(page);
+        page = NULL;
+    }
+    json_stream_clear(&stream);
+    *profile_out = profile;
+    return page;
+}
+
+struct Profile*
+parse_profile(const gchar *json_data)
+{
+    struct Profile *profile;
+    tweet_page_unref(parse_profile_page(json_data, &profile));
+    return profile;
 }
 
-GList*
+struct TweetPage*
+parse_profile_replies(const gchar *json_data)
+{
+    return decode_tweet_page(json_data, "replies");
+}
+
+GPtrArray*
 parse_users(const gchar *json_data)
 {
     JsonParser *parser = json_parser_new();
     GError *error = NULL;
-    GList *users = NULL;
+    GPtrArray *users = NULL;
 
     json_parser_load_from_data(parser, json_data, -1, &error);
     if (!error) {
@@ -421,7 +529,9 @@ parse_users(const gchar *json_data)
         JsonObject *obj = json_node_get_object(root);
         if (json_object_has_member(obj, "users")) {
             JsonArray *users_array = json_object_get_array_member(obj, "users");
-            for (guint i = 0; i < json_array_get_length(users_array); i++) {
+            guint length = json_array_get_length(users_array);
+            users = g_ptr_array_new_full(length, free_user);
+            for (guint i = 0; i < length; i++) {
                 JsonNode *user_node = json_array_get_element(users_array, i);
                 JsonObject *user_obj = json_node_get_object(user_node);
                 struct Profile *user = g_new0(struct Profile, 1);
@@ -437,7 +547,7 @@ parse_users(const gchar *json_data)
                     user->avatar = g_strdup(json_object_get_string_member(user_obj, "avatar"));
                 }
                 user->follower_count = json_object_has_member(user_obj, "follower_count") ? json_object_get_int_member(user_obj, "follower_count") : 0;
-                users = g_list_append(users, user);
+                g_ptr_array_add(users, user);
             }
         }
     } else {
@@ -447,12 +557,12 @@ parse_users(const gchar *json_data)
     return users;
 }
 
-GList*
+GPtrArray*
 parse_notifications(const gchar *json_data)
 {
     JsonParser *parser = json_parser_new();
     GError *error = NULL;
-    GList *notifications = NULL;
+    GPtrArray *notifications = NULL;
 
     json_parser_load_from_data(parser, json_data, -1, &error);
     if (!error) {
@@ -460,7 +570,9 @@ parse_notifications(const gchar *json_data)
         JsonObject *obj = json_node_get_object(root);
         if (json_object_has_member(obj, "notifications")) {
             JsonArray *notif_array = json_object_get_array_member(obj, "notifications");
-            for (guint i = 0; i < json_array_get_length(notif_array); i++) {
+            guint length = json_array_get_length(notif_array);
+            notifications = g_ptr_array_new_full(length, free_notification);
+            for (guint i = 0; i < length; i++) {
                 JsonNode *notif_node = json_array_get_element(notif_array, i);
                 JsonObject *notif_obj = json_node_get_object(notif_node);
                 struct Notification *notif = g_new0(struct Notification, 1);
@@ -492,7 +604,7 @@ parse_notifications(const gchar *json_data)
                 notif->read = json_object_get_boolean_member(notif_obj, "read");
                 notif->created_at = g_strdup(json_object_get_string_member(notif_obj, "created_at"));
                 
-                notifications = g_list_append(notifications, notif);
+                g_ptr_array_add(notifications, notif);
             }
         }
     } else {
@@ -502,12 +614,12 @@ parse_notifications(const gchar *json_data)
     return notifications;
 }
 
-GList*
+GPtrArray*
 parse_conversations(const gchar *json_data)
 {
     JsonParser *parser = json_parser_new();
     GError *error = NULL;
-    GList *conversations = NULL;
+    GPtrArray *conversations = NULL;
 
     json_parser_load_from_data(parser, json_data, -1, &error);
     if (!error) {
@@ -515,7 +627,9 @@ parse_conversations(const gchar *json_data)
         JsonObject *obj = json_node_get_object(root);
         if (json_object_has_member(obj, "conversations")) {
             JsonArray *conv_array = json_object_get_array_member(obj, "conversations");
-            for (guint i = 0; i < json_array_get_length(conv_array); i++) {
+            guint length = json_array_get_length(conv_array);
+            conversations = g_ptr_array_new_full(length, free_conversation);
+            for (guint i = 0; i < length; i++) {
                 JsonNode *conv_node = json_array_get_element(conv_array, i);
                 JsonObject *conv_obj = json_node_get_object(conv_node);
                 struct Conversation *conv = g_new0(struct Conversation, 1);
@@ -545,7 +659,7 @@ parse_conversations(const gchar *json_data)
 
                 conv->unread_count = json_object_get_int_member(conv_obj, "unread_count");
                 
-                conversations = g_list_append(conversations, conv);
+                g_ptr_array_add(conversations, conv);
             }
         }
     } else {
@@ -555,12 +669,34 @@ parse_conversations(const gchar *json_data)
     return conversations;
 }
 
-GList*
+static struct DirectMessage*
+parse_single_message(JsonObject *msg_obj)
+{
+    struct DirectMessage *msg = g_new0(struct DirectMessage, 1);
+
+    msg->id = g_strdup(json_object_get_string_member(msg_obj, "id"));
+    msg->conversation_id = g_strdup(json_object_get_string_member(msg_obj, "conversation_id"));
+    msg->sender_id = g_strdup(json_object_get_string_member(msg_obj, "sender_id"));
+    msg->content = g_strdup(json_object_get_string_member(msg_obj, "content"));
+    msg->username = g_strdup(json_object_get_string_member(msg_obj, "username"));
+    msg->name = g_strdup(json_object_get_string_member(msg_obj, "name"));
+
+    if (json_object_has_member(msg_obj, "avatar") && !json_node_is_null(json_object_get_member(msg_obj, "avatar"))) {
+        msg->avatar = g_strdup(json_object_get_string_member(msg_obj, "avatar"));
+    }
+
+    msg->created_at = g_strdup(json_object_get_string_member(msg_obj, "created_at"));
+    msg->attachments = parse_attachments(msg_obj);
+
+    return msg;
+}
+
+GPtrArray*
 parse_messages(const gchar *json_data)
 {
     JsonParser *parser = json_parser_new();
     GError *error = NULL;
-    GList *messages = NULL;
+    GPtrArray *messages = NULL;
 
     json_parser_load_from_data(parser, json_data, -1, &error);
     if (!error) {
@@ -568,26 +704,11 @@ parse_messages(const gchar *json_data)
         JsonObject *obj = json_node_get_object(root);
         if (json_object_has_member(obj, "messages")) {
             JsonArray *msg_array = json_object_get_array_member(obj, "messages");
-            for (guint i = 0; i < json_array_get_length(msg_array); i++) {
+            guint length = json_array_get_length(msg_array);
+            messages = g_ptr_array_new_full(length, free_message);
+            for (guint i = 0; i < length; i++) {
                 JsonNode *msg_node = json_array_get_element(msg_array, i);
-                JsonObject *msg_obj = json_node_get_object(msg_node);
-                struct DirectMessage *msg = g_new0(struct DirectMessage, 1);
-                
-                msg->id = g_strdup(json_object_get_string_member(msg_obj, "id"));
-                msg->conversation_id = g_strdup(json_object_get_string_member(msg_obj, "conversation_id"));
-                msg->sender_id = g_strdup(json_object_get_string_member(msg_obj, "sender_id"));
-                msg->content = g_strdup(json_object_get_string_member(msg_obj, "content"));
-                msg->username = g_strdup(json_object_get_string_member(msg_obj, "username"));
-                msg->name = g_strdup(json_object_get_string_member(msg_obj, "name"));
-                
-                if (json_object_has_member(msg_obj, "avatar") && !json_node_is_null(json_object_get_member(msg_obj, "avatar"))) {
-                    msg->avatar = g_strdup(json_object_get_string_member(msg_obj, "avatar"));
-                }
-                
-                msg->created_at = g_strdup(json_object_get_string_member(msg_obj, "created_at"));
-                msg->attachments = parse_attachments(msg_obj);
-                
-                messages = g_list_append(messages, msg);
+                g_ptr_array_add(messages, parse_single_message(json_node_get_object(msg_node)));
             }
         }
     } else {
@@ -597,6 +718,79 @@ parse_messages(const gchar *json_data)
     return messages;
 }
 
+// The object under @member of a write response, or the root itself if the
+// server returned the bare object. NULL if it has no "id".
+static JsonObject*
+get_created_object(JsonNode *root, const gchar *member)
+{
+    if (!JSON_NODE_HOLDS_OBJECT(root)) return NULL;
+
+    JsonObject *obj = json_node_get_object(root);
+    if (json_object_has_member(obj, member)) {
+        JsonNode *node = json_object_get_member(obj, member);
+        obj = JSON_NODE_HOLDS_OBJECT(node) ? json_node_get_object(node) : NULL;
+    }
+    if (!obj || !json_object_has_member(obj, "id")) return NULL;
+    return obj;
+}
+
+struct TweetPage*
+parse_posted_tweet(const gchar *json_data)
+{
+    struct JsonStream stream;
+    struct TweetPage *page = tweet_page_new();
+    struct TweetDecoder root;
+    struct TweetDecoder nested;
+    gboolean has_nested = FALSE;
+
+    // The members of the root are decoded as a bare post while looking for
+    // a "tweet" member, so the response is only walked once either way
+    tweet_decoder_init(&root, &page->arena, FALSE);
+    tweet_decoder_init(&nested, &page->arena, FALSE);
+    json_stream_init(&stream, json_data, -1);
+    if (json_stream_begin_object(&stream)) {
+        root.tweet = memory_arena_alloc(&page->arena, sizeof(struct Tweet));
+        const gchar *key;
+        while ((key = json_stream_next_member(&stream))) {
+            if (strcmp(key, "tweet") == 0) {
+                tweet_decoder_init(&nested, &page->arena, FALSE);
+                decode_tweet_object(&nested, &stream);
+                has_nested = TRUE;
+            } else {
+                decode_tweet_member(&root, &stream, key);
+            }
+        }
+    }
+
+    struct TweetDecoder *created = has_nested ? &nested : &root;
+    if (json_stream_finish(&stream) && created->tweet && created->has_id && created->has_author) {
+        g_ptr_array_add(page->tweets, created->tweet);
+    } else {
+        tweet_page_unref(page);
+        page = NULL;
+    }
+
+    json_stream_clear(&stream);
+    return page;
+}
+
+struct DirectMessage*
+parse_sent_message(const gchar *json_data)
+{
+    JsonParser *parser = json_parser_new();
+    struct DirectMessage *msg = NULL;
+
+    if (json_parser_load_from_data(parser, json_data, -1, NULL)) {
+        JsonObject *msg_obj = get_created_object(json_parser_get_root(parser), "message");
+        if (msg_obj) {
+            msg = parse_single_message(msg_obj);
+        }
+    }
+
+    g_object_unref(parser);
+    return msg;
+}
+
 gchar*
 construct_dm_payload(const gchar *content)
 {
@@ -615,12 +809,12 @@ construct_dm_payload(const gchar *content)
     return post_data;
 }
 
-GList*
+GPtrArray*
 parse_admin_users(const gchar *json_data)
 {
     JsonParser *parser = json_parser_new();
     GError *error = NULL;
-    GList *users = NULL;
+    GPtrArray *users = NULL;
 
     json_parser_load_from_data(parser, json_data, -1, &error);
     if (!error) {
@@ -628,7 +822,9 @@ parse_admin_users(const gchar *json_data)
         JsonObject *obj = json_node_get_object(root);
         if (json_object_has_member(obj, "users")) {
             JsonArray *arr = json_object_get_array_member(obj, "users");
-            for (guint i = 0; i < json_array_get_length(arr); i++) {
+            guint length = json_array_get_length(arr);
+            users = g_ptr_array_new_full(length, free_user);
+            for (guint i = 0; i < length; i++) {
                 JsonObject *u_obj = json_array_get_object_element(arr, i);
                 struct Profile *user = g_new0(struct Profile, 1);
                 user->username = g_strdup(json_object_get_string_member(u_obj, "username"));
@@ -637,7 +833,7 @@ parse_admin_users(const gchar *json_data)
                     user->avatar = g_strdup(json_object_get_string_member(u_obj, "avatar"));
                 if (json_object_has_member(u_obj, "bio") && !json_node_is_null(json_object_get_member(u_obj, "bio")))
                     user->bio = g_strdup(json_object_get_string_member(u_obj, "bio"));
-                users = g_list_append(users, user);
+                g_ptr_array_add(users, user);
             }
         }
     } else {
@@ -647,36 +843,37 @@ parse_admin_users(const gchar *json_data)
     return users;
 }
 
-GList*
+struct TweetPage*
 parse_admin_posts(const gchar *json_data)
 {
     JsonParser *parser = json_parser_new();
     GError *error = NULL;
-    GList *tweets = NULL;
+    struct TweetPage *page = NULL;
 
     json_parser_load_from_data(parser, json_data, -1, &error);
     if (!error) {
         JsonNode *root = json_parser_get_root(parser);
         JsonObject *obj = json_node_get_object(root);
+        page = tweet_page_new();
         if (json_object_has_member(obj, "posts")) {
             JsonArray *arr = json_object_get_array_member(obj, "posts");
             for (guint i = 0; i < json_array_get_length(arr); i++) {
                 JsonObject *p_obj = json_array_get_object_element(arr, i);
-                struct Tweet *tweet = g_new0(struct Tweet, 1);
-                tweet->id = g_strdup(json_object_get_string_member(p_obj, "id"));
-                tweet->content = g_strdup(json_object_get_string_member(p_obj, "content"));
-                tweet->author_username = g_strdup(json_object_get_string_member(p_obj, "username"));
-                tweet->author_name = g_strdup(json_object_get_string_member(p_obj, "name"));
+                struct Tweet *tweet = memory_arena_alloc(&page->arena, sizeof(struct Tweet));
+                tweet->id = memory_arena_strdup(&page->arena, json_object_get_string_member(p_obj, "id"));
+                tweet->content = memory_arena_strdup(&page->arena, json_object_get_string_member(p_obj, "content"));
+                tweet->author_username = string_intern(json_object_get_string_member(p_obj, "username"));
+                tweet->author_name = string_intern(json_object_get_string_member(p_obj, "name"));
                 if (json_object_has_member(p_obj, "avatar") && !json_node_is_null(json_object_get_member(p_obj, "avatar")))
-                    tweet->author_avatar = g_strdup(json_object_get_string_member(p_obj, "avatar"));
-                tweets = g_list_append(tweets, tweet);
+                    tweet->author_avatar = string_intern(json_object_get_string_member(p_obj, "avatar"));
+                g_ptr_array_add(page->tweets, tweet);
             }
         }
     } else {
         g_error_free(error);
     }
     g_object_unref(parser);
-    return tweets;
+    return page;
 }
 
 gchar*
@@ -826,6 +1023,12 @@ parse_user_me_response(const gchar *json_data, gboolean *is_admin_out)
 
 gchar*
 construct_tweet_payload(const gchar *content, const gchar *reply_to_id)
+{
+    return construct_post_payload(content, reply_to_id, NULL);
+}
+
+gchar*
+construct_post_payload(const gchar *content, const gchar *reply_to_id, const gchar *quote_id)
 {
     JsonBuilder *builder = json_builder_new();
     json_builder_begin_object(builder);
@@ -840,6 +1043,11 @@ construct_tweet_payload(const gchar *content, const gchar *reply_to_id)
         json_builder_add_string_value(builder, reply_to_id);
     }
 
+    if (quote_id) {
+        json_builder_set_member_name(builder, "quote_tweet_id");
+        json_builder_add_string_value(builder, quote_id);
+    }
+
     json_builder_end_object(builder);
 
     JsonGenerator *gen = json_generator_new();
@@ -863,29 +1071,6 @@ free_attachment(gpointer data)
     }
 }
 
-void
-free_tweet(gpointer data)
-{
-    struct Tweet *tweet = data;
-    g_free(tweet->content);
-    g_free(tweet->author_name);
-    g_free(tweet->author_username);
-    g_free(tweet->author_avatar);
-    g_free(tweet->id);
-    g_free(tweet->note);
-    g_free(tweet->note_severity);
-    if (tweet->attachments) {
-        g_list_free_full(tweet->attachments, free_attachment);
-    }
-    g_free(tweet);
-}
-
-void
-free_tweets(GList *tweets)
-{
-    g_list_free_full(tweets, free_tweet);
-}
-
 void
 free_user(gpointer data)
 {
@@ -898,9 +1083,11 @@ free_user(gpointer data)
 }
 
 void
-free_users(GList *users)
+free_users(GPtrArray *users)
 {
-    g_list_free_full(users, free_user);
+    if (users) {
+        g_ptr_array_unref(users);
+    }
 }
 
 void
@@ -922,9 +1109,11 @@ free_notification(gpointer data)
 }
 
 void
-free_notifications(GList *notifications)
+free_notifications(GPtrArray *notifications)
 {
-    g_list_free_full(notifications, free_notification);
+    if (notifications) {
+        g_ptr_array_unref(notifications);
+    }
 }
 
 void
@@ -947,9 +1136,11 @@ free_conversation(gpointer data)
 }
 
 void
-free_conversations(GList *conversations)
+free_conversations(GPtrArray *conversations)
 {
-    g_list_free_full(conversations, free_conversation);
+    if (conversations) {
+        g_ptr_array_unref(conversations);
+    }
 }
 
 void
@@ -973,7 +1164,9 @@ free_message(gpointer data)
 }
 
 void
-free_messages(GList *messages)
+free_messages(GPtrArray *messages)
 {
-    g_list_free_full(messages, free_message);
+    if (messages) {
+        g_ptr_array_unref(messages);
+    }
 }
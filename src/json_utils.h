@@ -4,31 +4,73 @@
 #include <json-glib/json-glib.h>
 #include "types.h"
 
-GList* parse_tweets(const gchar *json_data);
-GList* parse_tweet_details(const gchar *json_data);
+/**
+ * Parses a page of posts. Every post lives in the page's arena, see
+ * struct TweetPage.
+ * @return The page, possibly with no tweets, or NULL if @json_data is
+ *         malformed.
+ */
+struct TweetPage* parse_tweets(const gchar *json_data);
+/**
+ * Parses a thread: the parents, the post itself, then its replies.
+ */
+struct TweetPage* parse_tweet_details(const gchar *json_data);
+/**
+ * Parses a profile response, {"profile": {...}, "posts": [...]}, in a single
+ * pass over the body.
+ * @param profile_out Set to the profile, to be freed with free_user(), or NULL
+ *        if the response has none.
+ * @return The posts, or NULL (with no profile) if @json_data is malformed.
+ */
+struct TweetPage* parse_profile_page(const gchar *json_data, struct Profile **profile_out);
+/**
+ * Like parse_profile_page(), for the profile alone.
+ */
 struct Profile* parse_profile(const gchar *json_data);
-GList* parse_profile_replies(const gchar *json_data);
-GList* parse_users(const gchar *json_data);
-GList* parse_notifications(const gchar *json_data);
-GList* parse_conversations(const gchar *json_data);
-GList* parse_messages(const gchar *json_data);
-GList* parse_admin_users(const gchar *json_data);
-GList* parse_admin_posts(const gchar *json_data);
+struct TweetPage* parse_profile_replies(const gchar *json_data);
+/**
+ * The list parsers below size their array from the response and set its free
+ * function, so it is released with g_ptr_array_unref() or free_users() etc.
+ * @return The items, or NULL if @json_data is malformed or lacks the list.
+ */
+GPtrArray* parse_users(const gchar *json_data);
+GPtrArray* parse_notifications(const gchar *json_data);
+GPtrArray* parse_conversations(const gchar *json_data);
+GPtrArray* parse_messages(const gchar *json_data);
+/**
+ * Parses the response to a new post, either {"tweet": {...}} or the bare post.
+ * @return A page holding just the created tweet, or NULL if the response does
+ *         not contain it.
+ */
+struct TweetPage* parse_posted_tweet(const gchar *json_data);
+/**
+ * Parses the response to a sent DM, either {"message": {...}} or the bare message.
+ * @return The created message, or NULL if the response does not contain it.
+ */
+struct DirectMessage* parse_sent_message(const gchar *json_data);
+GPtrArray* parse_admin_users(const gchar *json_data);
+struct TweetPage* parse_admin_posts(const gchar *json_data);
 gchar* parse_admin_stats(const gchar *json_data);
 gboolean parse_login_response(const gchar *json_data, gchar **token_out, gchar **username_out, gboolean *is_admin_out);
 gboolean parse_user_me_response(const gchar *json_data, gboolean *is_admin_out);
 gchar* construct_tweet_payload(const gchar *content, const gchar *reply_to_id);
+gchar* construct_post_payload(const gchar *content, const gchar *reply_to_id, const gchar *quote_id);
 gchar* construct_dm_payload(const gchar *content);
 
-void free_tweet(gpointer data);
-void free_tweets(GList *tweets);
+struct TweetPage* tweet_page_ref(struct TweetPage *page);
+/**
+ * Drops a reference to @page, freeing it and all of its tweets with the last
+ * one. Safe to call with NULL.
+ */
+void tweet_page_unref(struct TweetPage *page);
+void free_attachment(gpointer data);
 void free_user(gpointer data);
-void free_users(GList *users);
+void free_users(GPtrArray *users);
 void free_notification(gpointer data);
-void free_notifications(GList *notifications);
+void free_notifications(GPtrArray *notifications);
 void free_conversation(gpointer data);
-void free_conversations(GList *conversations);
+void free_conversations(GPtrArray *conversations);
 void free_message(gpointer data);
-void free_messages(GList *messages);
+void free_messages(GPtrArray *messages);
 
 #endif // JSON_UTILS_H
@@ -5,12 +5,20 @@
 #include "session.h"
 #include "actions.h"
 #include "views.h"
+#include "network.h"
+#include "network_async.h"
+#include "executor.h"
+#include "cap_tokens.h"
+#include "outbox.h"
+#include "sha256.h"
 
 int main(int argc, char *argv[]) {
     GtkWidget *window;
 
     gtk_init(&argc, &argv);
     curl_global_init(CURL_GLOBAL_ALL);
+    // Pick the SHA-256 kernel now so the first challenge does not pay for it
+    sha256_get_kernel();
 
     // CSS Provider
     GtkCssProvider *provider = gtk_css_provider_new();
@@ -31,6 +39,7 @@ int main(int argc, char *argv[]) {
 
     load_session();
     update_login_ui();
+    outbox_init();
 
     gtk_widget_show_all(window);
 
@@ -38,6 +47,14 @@ int main(int argc, char *argv[]) {
 
     gtk_main();
 
+    outbox_flush();
+    network_async_cleanup();
+    // I/O-lane tasks (challenge solves, Cap pre-solves) use pooled handles,
+    // so the lane is drained before network_cleanup() frees the pool.
+    // Clearing the Cap tokens first turns queued pre-solves into no-ops.
+    cap_tokens_clear();
+    executor_shutdown();
+    network_cleanup();
     curl_global_cleanup();
     g_free(g_auth_token);
     g_free(g_current_username);
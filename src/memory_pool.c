@@ -0,0 +1,255 @@
+#include <stdlib.h>
+#include <string.h>
+#include "memory_pool.h"
+
+// Buffers are handed out in power-of-two size classes from 4 KiB to 4 MiB.
+// Free buffers are kept on intrusive per-class lists (the link lives in the
+// first bytes of the buffer), bounded by a total byte budget.
+#define POOL_MIN_CLASS_SHIFT 12
+#define POOL_CLASS_COUNT 11
+#define POOL_MAX_BYTES (16 * 1024 * 1024)
+
+static GMutex pool_mutex;
+static char *free_lists[POOL_CLASS_COUNT];
+static gsize pooled_bytes = 0;
+static guint64 stat_allocations = 0;
+static guint64 stat_reuses = 0;
+
+static gsize
+class_size(gint cls)
+{
+    return (gsize)1 << (cls + POOL_MIN_CLASS_SHIFT);
+}
+
+// Smallest class that fits @size, or -1 if it is larger than every class
+static gint
+class_for_size(gsize size)
+{
+    for (gint cls = 0; cls < POOL_CLASS_COUNT; cls++) {
+        if (size <= class_size(cls)) return cls;
+    }
+    return -1;
+}
+
+static char*
+buffer_acquire(gsize min_capacity, gsize *capacity)
+{
+    gint cls = class_for_size(min_capacity);
+    char *buf = NULL;
+
+    *capacity = cls >= 0 ? class_size(cls) : min_capacity;
+
+    g_mutex_lock(&pool_mutex);
+    if (cls >= 0 && free_lists[cls]) {
+        buf = free_lists[cls];
+        memcpy(&free_lists[cls], buf, sizeof(char *));
+        pooled_bytes -= *capacity;
+        stat_reuses++;
+    } else {
+        stat_allocations++;
+    }
+    g_mutex_unlock(&pool_mutex);
+
+    if (!buf) {
+        buf = malloc(*capacity);
+    }
+    return buf;
+}
+
+static void
+buffer_release(char *buf, gsize capacity)
+{
+    if (!buf) return;
+
+    gint cls = class_for_size(capacity);
+    if (cls >= 0 && class_size(cls) == capacity) {
+        g_mutex_lock(&pool_mutex);
+        if (pooled_bytes + capacity <= POOL_MAX_BYTES) {
+            memcpy(buf, &free_lists[cls], sizeof(char *));
+            free_lists[cls] = buf;
+            pooled_bytes += capacity;
+            buf = NULL;
+        }
+        g_mutex_unlock(&pool_mutex);
+    }
+
+    free(buf);
+}
+
+void
+memory_struct_init(struct MemoryStruct *chunk)
+{
+    chunk->memory = NULL;
+    chunk->size = 0;
+    chunk->capacity = 0;
+}
+
+gboolean
+memory_struct_reserve(struct MemoryStruct *chunk, size_t length)
+{
+    if (chunk->memory && length < chunk->capacity) {
+        return TRUE;
+    }
+
+    gsize wanted = length + 1;
+    if (wanted < chunk->capacity * 2) {
+        wanted = chunk->capacity * 2;
+    }
+
+    gsize capacity = 0;
+    char *buf = buffer_acquire(wanted, &capacity);
+    if (!buf) {
+        return FALSE;
+    }
+
+    if (chunk->memory) {
+        memcpy(buf, chunk->memory, chunk->size + 1);
+        buffer_release(chunk->memory, chunk->capacity);
+    } else {
+        chunk->size = 0;
+        buf[0] = '\0';
+    }
+
+    chunk->memory = buf;
+    chunk->capacity = capacity;
+    return TRUE;
+}
+
+gboolean
+memory_struct_append(struct MemoryStruct *chunk, const void *data, size_t length)
+{
+    if (!memory_struct_reserve(chunk, chunk->size + length)) {
+        return FALSE;
+    }
+
+    memcpy(chunk->memory + chunk->size, data, length);
+    chunk->size += length;
+    chunk->memory[chunk->size] = '\0';
+    return TRUE;
+}
+
+void
+memory_struct_release(struct MemoryStruct *chunk)
+{
+    buffer_release(chunk->memory, chunk->capacity);
+    memory_struct_init(chunk);
+}
+
+// Arena blocks start with this header. Blocks grow geometrically so a large
+// page needs a handful of them; an allocation larger than the next block
+// gets a block of its own.
+struct ArenaBlock {
+    char *prev;
+    gsize capacity;
+};
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_HEADER_SIZE ((sizeof(struct ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(gsize)(ARENA_ALIGNMENT - 1))
+#define ARENA_MIN_BLOCK (8 * 1024)
+#define ARENA_MAX_BLOCK (256 * 1024)
+
+void
+memory_arena_init(struct MemoryArena *arena)
+{
+    arena->block = NULL;
+    arena->used = 0;
+    arena->capacity = 0;
+}
+
+static void
+arena_grow(struct MemoryArena *arena, gsize size)
+{
+    gsize wanted = arena->capacity ? MIN(arena->capacity * 2, ARENA_MAX_BLOCK) : ARENA_MIN_BLOCK;
+    wanted = MAX(wanted, ARENA_HEADER_SIZE + size);
+
+    gsize capacity = 0;
+    char *block = buffer_acquire(wanted, &capacity);
+    if (!block) {
+        g_error("Failed to allocate an arena block of %" G_GSIZE_FORMAT " bytes", wanted);
+    }
+
+    struct ArenaBlock header = { arena->block, arena->capacity };
+    memcpy(block, &header, sizeof(header));
+    arena->block = block;
+    arena->used = ARENA_HEADER_SIZE;
+    arena->capacity = capacity;
+}
+
+static gpointer
+arena_bump(struct MemoryArena *arena, gsize size, gsize alignment)
+{
+    gsize offset = (arena->used + alignment - 1) & ~(alignment - 1);
+    if (!arena->block || offset + size > arena->capacity) {
+        arena_grow(arena, size);
+        offset = arena->used;
+    }
+    arena->used = offset + size;
+    return arena->block + offset;
+}
+
+gpointer
+memory_arena_alloc(struct MemoryArena *arena, gsize size)
+{
+    gpointer mem = arena_bump(arena, size, ARENA_ALIGNMENT);
+    memset(mem, 0, size);
+    return mem;
+}
+
+gchar*
+memory_arena_strndup(struct MemoryArena *arena, const gchar *str, gsize length)
+{
+    // Strings need no alignment, so they pack tightly
+    gchar *copy = arena_bump(arena, length + 1, 1);
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+gchar*
+memory_arena_strdup(struct MemoryArena *arena, const gchar *str)
+{
+    return str ? memory_arena_strndup(arena, str, strlen(str)) : NULL;
+}
+
+void
+memory_arena_release(struct MemoryArena *arena)
+{
+    char *block = arena->block;
+    gsize capacity = arena->capacity;
+
+    while (block) {
+        struct ArenaBlock header;
+        memcpy(&header, block, sizeof(header));
+        buffer_release(block, capacity);
+        block = header.prev;
+        capacity = header.capacity;
+    }
+    memory_arena_init(arena);
+}
+
+void
+memory_pool_get_stats(guint64 *allocations, guint64 *reuses)
+{
+    g_mutex_lock(&pool_mutex);
+    if (allocations) *allocations = stat_allocations;
+    if (reuses) *reuses = stat_reuses;
+    g_mutex_unlock(&pool_mutex);
+}
+
+void
+memory_pool_trim(void)
+{
+    g_mutex_lock(&pool_mutex);
+    for (gint cls = 0; cls < POOL_CLASS_COUNT; cls++) {
+        char *buf = free_lists[cls];
+        while (buf) {
+            char *next;
+            memcpy(&next, buf, sizeof(char *));
+            free(buf);
+            buf = next;
+        }
+        free_lists[cls] = NULL;
+    }
+    pooled_bytes = 0;
+    g_mutex_unlock(&pool_mutex);
+}
@@ -0,0 +1,71 @@
+#ifndef MEMORY_POOL_H
+#define MEMORY_POOL_H
+
+#include <glib.h>
+#include "types.h"
+
+/**
+ * Resets @chunk to an empty buffer without allocating.
+ */
+void memory_struct_init(struct MemoryStruct *chunk);
+
+/**
+ * Ensures @chunk can hold @length bytes plus a NUL terminator. Grows at least
+ * geometrically and keeps the existing contents. An empty chunk gets a
+ * NUL-terminated zero-length buffer.
+ * @return FALSE if memory could not be allocated.
+ */
+gboolean memory_struct_reserve(struct MemoryStruct *chunk, size_t length);
+
+/**
+ * Appends @length bytes to @chunk and keeps it NUL-terminated.
+ * @return FALSE if memory could not be allocated.
+ */
+gboolean memory_struct_append(struct MemoryStruct *chunk, const void *data, size_t length);
+
+/**
+ * Returns the buffer of @chunk to the pool (or frees it) and resets @chunk.
+ * Safe to call on an empty chunk.
+ */
+void memory_struct_release(struct MemoryStruct *chunk);
+
+/**
+ * Resets @arena to empty without allocating.
+ */
+void memory_arena_init(struct MemoryArena *arena);
+
+/**
+ * Allocates @size zeroed bytes from @arena, aligned for any scalar type.
+ * Blocks come from the buffer pool. Aborts if memory runs out, like g_malloc().
+ */
+gpointer memory_arena_alloc(struct MemoryArena *arena, gsize size);
+
+/**
+ * Copies @length bytes of @str into @arena and NUL-terminates them.
+ */
+gchar* memory_arena_strndup(struct MemoryArena *arena, const gchar *str, gsize length);
+
+/**
+ * Copies @str into @arena.
+ * @return The copy, or NULL if @str is NULL.
+ */
+gchar* memory_arena_strdup(struct MemoryArena *arena, const gchar *str);
+
+/**
+ * Returns every block of @arena to the pool and resets it. Safe to call on an
+ * empty arena.
+ */
+void memory_arena_release(struct MemoryArena *arena);
+
+/**
+ * Reports how many buffers were obtained from the allocator vs. reused from
+ * the pool since startup.
+ */
+void memory_pool_get_stats(guint64 *allocations, guint64 *reuses);
+
+/**
+ * Frees every pooled buffer.
+ */
+void memory_pool_trim(void);
+
+#endif // MEMORY_POOL_H
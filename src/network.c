@@ -6,6 +6,165 @@
 #include "globals.h"
 #include "challenge.h"
 #include "constants.h"
+#include "network_stats.h"
+#include "memory_pool.h"
+#include "network_cache.h"
+#include "cap_tokens.h"
+
+// Idle easy handles kept around between requests. Each handle owns its own
+// connection cache, so reusing a handle reuses its keep-alive connection to
+// the API host instead of doing a fresh TCP + TLS handshake.
+#define NETWORK_POOL_MAX_IDLE 8
+
+static GMutex pool_mutex;
+static GQueue pool_idle = G_QUEUE_INIT;
+static guint64 pool_hits = 0;
+static guint64 pool_misses = 0;
+
+// DNS results and TLS session tickets are shared between every handle.
+static CURLSH *pool_share = NULL;
+static GMutex share_locks[CURL_LOCK_DATA_LAST];
+static GOnce pool_once = G_ONCE_INIT;
+
+static void
+share_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+    (void)handle;
+    (void)access;
+    (void)userptr;
+    g_mutex_lock(&share_locks[data]);
+}
+
+static void
+share_unlock(CURL *handle, curl_lock_data data, void *userptr)
+{
+    (void)handle;
+    (void)userptr;
+    g_mutex_unlock(&share_locks[data]);
+}
+
+static gpointer
+init_share(gpointer data)
+{
+    (void)data;
+    CURLSH *share = curl_share_init();
+    if (!share) {
+        g_warning("curl_share_init() failed, handles will not share DNS/TLS caches");
+        return NULL;
+    }
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, share_lock);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    pool_share = share;
+    return share;
+}
+
+CURL *
+network_pool_acquire(void)
+{
+    CURL *handle;
+
+    g_once(&pool_once, init_share, NULL);
+
+    g_mutex_lock(&pool_mutex);
+    handle = g_queue_pop_head(&pool_idle);
+    if (handle) {
+        pool_hits++;
+    } else {
+        pool_misses++;
+    }
+    g_mutex_unlock(&pool_mutex);
+
+    if (!handle) {
+        handle = curl_easy_init();
+        if (!handle) {
+            return NULL;
+        }
+    }
+
+    // curl_easy_reset() clears every option, so the shared ones are applied
+    // on each checkout. The caches owned by the handle survive the reset.
+    if (pool_share) {
+        curl_easy_setopt(handle, CURLOPT_SHARE, pool_share);
+    }
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+
+    return handle;
+}
+
+void
+network_pool_release(CURL *handle)
+{
+    if (!handle) return;
+
+    curl_easy_reset(handle);
+
+    g_mutex_lock(&pool_mutex);
+    if (g_queue_get_length(&pool_idle) < NETWORK_POOL_MAX_IDLE) {
+        g_queue_push_head(&pool_idle, handle);
+        handle = NULL;
+    }
+    g_mutex_unlock(&pool_mutex);
+
+    if (handle) {
+        curl_easy_cleanup(handle);
+    }
+}
+
+void
+network_get_pool_stats(guint64 *hits, guint64 *misses)
+{
+    g_mutex_lock(&pool_mutex);
+    if (hits) *hits = pool_hits;
+    if (misses) *misses = pool_misses;
+    g_mutex_unlock(&pool_mutex);
+}
+
+void
+network_cleanup(void)
+{
+    CURL *handle;
+
+    network_stats_log_summary();
+
+    // Callers drain the executor's I/O lane first, so no Cap solve is using
+    // the pool any more; this only drops leftover tokens
+    guint64 cap_ready = 0, cap_solved_inline = 0;
+    cap_tokens_get_stats(&cap_ready, &cap_solved_inline);
+    g_message("Cap tokens: %" G_GUINT64_FORMAT " ready, %" G_GUINT64_FORMAT " solved while waiting",
+              cap_ready, cap_solved_inline);
+    cap_tokens_clear();
+
+    g_mutex_lock(&pool_mutex);
+    g_message("Connection pool: %" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT " misses",
+              pool_hits, pool_misses);
+    while ((handle = g_queue_pop_head(&pool_idle)) != NULL) {
+        curl_easy_cleanup(handle);
+    }
+    g_mutex_unlock(&pool_mutex);
+
+    if (pool_share) {
+        curl_share_cleanup(pool_share);
+        pool_share = NULL;
+    }
+
+    guint64 buffer_allocations = 0, buffer_reuses = 0;
+    memory_pool_get_stats(&buffer_allocations, &buffer_reuses);
+    g_message("Response buffers: %" G_GUINT64_FORMAT " allocated, %" G_GUINT64_FORMAT " reused",
+              buffer_allocations, buffer_reuses);
+    memory_pool_trim();
+
+    guint64 cache_fresh_hits = 0, cache_not_modified = 0;
+    network_cache_get_stats(&cache_fresh_hits, &cache_not_modified);
+    g_message("HTTP cache: %" G_GUINT64_FORMAT " fresh hits, %" G_GUINT64_FORMAT " not modified",
+              cache_fresh_hits, cache_not_modified);
+    network_cache_clear();
+}
+
+// Bodies larger than this are still received, just not pre-sized
+#define NETWORK_MAX_PRESIZE (64 * 1024 * 1024)
 
 static size_t
 WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp)
@@ -13,46 +172,52 @@ WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp)
   size_t realsize = size * nmemb;
   struct MemoryStruct *mem = (struct MemoryStruct *)userp;
 
-  char *ptr = realloc(mem->memory, mem->size + realsize + 1);
-  if(ptr == NULL) {
-    g_critical("not enough memory (realloc returned NULL)");
+  if(!memory_struct_append(mem, contents, realsize)) {
+    g_critical("not enough memory (could not grow response buffer)");
     return 0;
   }
 
-  mem->memory = ptr;
-  memcpy(&(mem->memory[mem->size]), contents, realsize);
-  mem->size += realsize;
-  mem->memory[mem->size] = 0;
-
   return realsize;
 }
 
-gboolean
-fetch_url_internal(const gchar *url, struct MemoryStruct *chunk, const gchar *post_data, const gchar *method, long *response_code)
+static size_t
+HeaderCallback(char *buffer, size_t size, size_t nitems, void *userp)
 {
-    CURL *curl_handle;
-    CURLcode res;
-    struct curl_slist *headers = NULL;
+    size_t realsize = size * nitems;
+    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
+    static const char prefix[] = "content-length:";
 
-    if (chunk->memory) {
-        free(chunk->memory);
+    // Pre-size the body buffer so it is allocated once instead of grown
+    // chunk by chunk. With content encoding this is the compressed length,
+    // so it is only a lower bound and the buffer may still grow.
+    if (realsize > sizeof(prefix) - 1 && g_ascii_strncasecmp(buffer, prefix, sizeof(prefix) - 1) == 0) {
+        gchar *value = g_strndup(buffer + sizeof(prefix) - 1, realsize - (sizeof(prefix) - 1));
+        guint64 length = g_ascii_strtoull(g_strstrip(value), NULL, 10);
+        g_free(value);
+        if (length > 0 && length <= NETWORK_MAX_PRESIZE) {
+            memory_struct_reserve(mem, mem->size + (size_t)length);
+        }
     }
-    chunk->memory = malloc(1);
-    chunk->size = 0;
-    chunk->memory[0] = '\0';
 
-    curl_handle = curl_easy_init();
-    if (!curl_handle) {
-        g_critical("curl_easy_init() failed");
-        free(chunk->memory);
-        chunk->memory = NULL;
-        return FALSE;
-    }
+    return realsize;
+}
+
+struct curl_slist *
+network_prepare_handle(CURL *curl_handle, const gchar *url, struct MemoryStruct *chunk, const gchar *post_data, const gchar *method,
+                       gboolean conditional)
+{
+    struct curl_slist *headers = NULL;
 
     curl_easy_setopt(curl_handle, CURLOPT_URL, url);
     curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
     curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *)chunk);
-    curl_easy_setopt(curl_handle, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    curl_easy_setopt(curl_handle, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(curl_handle, CURLOPT_HEADERDATA, (void *)chunk);
+    curl_easy_setopt(curl_handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    // An empty string advertises every encoding this libcurl was built with
+    // (gzip, deflate and, when available, br and zstd). The body is decoded
+    // as it streams in, so the write callback only ever sees plain bytes.
+    curl_easy_setopt(curl_handle, CURLOPT_ACCEPT_ENCODING, "");
 
     headers = curl_slist_append(headers, "Content-Type: application/json");
     if (g_auth_token) {
@@ -60,6 +225,24 @@ fetch_url_internal(const gchar *url, struct MemoryStruct *chunk, const gchar *po
         headers = curl_slist_append(headers, auth_header);
         g_free(auth_header);
     }
+    if (conditional && network_cache_is_cacheable_request(post_data, method)) {
+        gchar *etag = NULL, *last_modified = NULL;
+        if (network_cache_get_validators(url, &etag, &last_modified)) {
+            gchar *header = NULL;
+            if (etag) {
+                header = g_strdup_printf("If-None-Match: %s", etag);
+                headers = curl_slist_append(headers, header);
+                g_free(header);
+            }
+            if (last_modified) {
+                header = g_strdup_printf("If-Modified-Since: %s", last_modified);
+                headers = curl_slist_append(headers, header);
+                g_free(header);
+            }
+        }
+        g_free(etag);
+        g_free(last_modified);
+    }
     curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
 
     if (method) {
@@ -70,38 +253,194 @@ fetch_url_internal(const gchar *url, struct MemoryStruct *chunk, const gchar *po
         curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, post_data);
     }
 
-    res = curl_easy_perform(curl_handle);
+    return headers;
+}
 
-    if (res == CURLE_OK) {
-        curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, response_code);
+// Difference of two cumulative curl timestamps, clamped at zero
+static guint64
+phase_between(curl_off_t start_us, curl_off_t end_us)
+{
+    return end_us > start_us ? (guint64)(end_us - start_us) : 0;
+}
+
+void
+network_record_transfer(CURL *curl_handle, const gchar *url, const struct MemoryStruct *chunk)
+{
+    curl_off_t wire_bytes = 0, sent_bytes = 0;
+    curl_off_t namelookup = 0, connect = 0, appconnect = 0, pretransfer = 0, starttransfer = 0, total = 0;
+    long new_connections = 0;
+    guint64 phase_us[NETWORK_PHASE_COUNT] = { 0 };
+
+    curl_easy_getinfo(curl_handle, CURLINFO_SIZE_DOWNLOAD_T, &wire_bytes);
+    curl_easy_getinfo(curl_handle, CURLINFO_SIZE_UPLOAD_T, &sent_bytes);
+    network_stats_record_transfer(url, (guint64)wire_bytes, chunk->size);
+
+    // All of these are cumulative from the start of the transfer
+    curl_easy_getinfo(curl_handle, CURLINFO_NAMELOOKUP_TIME_T, &namelookup);
+    curl_easy_getinfo(curl_handle, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl_handle, CURLINFO_APPCONNECT_TIME_T, &appconnect);
+    curl_easy_getinfo(curl_handle, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+    curl_easy_getinfo(curl_handle, CURLINFO_STARTTRANSFER_TIME_T, &starttransfer);
+    curl_easy_getinfo(curl_handle, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(curl_handle, CURLINFO_NUM_CONNECTS, &new_connections);
+
+    phase_us[NETWORK_PHASE_DNS] = phase_between(0, namelookup);
+    phase_us[NETWORK_PHASE_CONNECT] = phase_between(namelookup, connect);
+    phase_us[NETWORK_PHASE_TLS] = appconnect > 0 ? phase_between(connect, appconnect) : 0;
+    phase_us[NETWORK_PHASE_SERVER] = phase_between(pretransfer, starttransfer);
+    phase_us[NETWORK_PHASE_DOWNLOAD] = phase_between(starttransfer, total);
+    phase_us[NETWORK_PHASE_TOTAL] = phase_between(0, total);
+    network_stats_record_timings(url, (guint64)sent_bytes, phase_us, new_connections > 0);
+}
+
+static gchar*
+dup_response_header(CURL *curl_handle, const gchar *name)
+{
+    struct curl_header *header = NULL;
+    if (curl_easy_header(curl_handle, name, 0, CURLH_HEADER, -1, &header) != CURLHE_OK) {
+        return NULL;
+    }
+    return g_strdup(header->value);
+}
+
+void
+network_observe_rate_limit(CURL *curl_handle, long response_code)
+{
+    gchar *remaining = dup_response_header(curl_handle, "RateLimit-Remaining");
+    if (!remaining) {
+        remaining = dup_response_header(curl_handle, "X-RateLimit-Remaining");
     }
+    cap_tokens_observe_response(response_code, remaining);
+    g_free(remaining);
+}
+
+gboolean
+network_cache_update(CURL *curl_handle, const gchar *url, const gchar *post_data, const gchar *method,
+                     struct MemoryStruct *chunk, long *response_code)
+{
+    if (!network_cache_is_cacheable_request(post_data, method)) return TRUE;
 
-    curl_slist_free_all(headers);
+    gboolean no_store = FALSE;
+    gchar *cache_control = dup_response_header(curl_handle, "Cache-Control");
+    gint64 max_age = network_cache_parse_max_age(cache_control, &no_store);
+    g_free(cache_control);
+
+    if (*response_code == 304) {
+        if (!network_cache_revalidated(url, max_age, chunk)) {
+            g_debug("Got 304 for %s but the cached copy is gone", url);
+            return FALSE;
+        }
+        *response_code = 200;
+        return TRUE;
+    }
+
+    if (*response_code != 200 || no_store) return TRUE;
+    // Never keep a challenge around, it has to be solved and retried
+    if (network_response_may_need_challenge(chunk, *response_code)) return TRUE;
+
+    gchar *etag = dup_response_header(curl_handle, "ETag");
+    gchar *last_modified = dup_response_header(curl_handle, "Last-Modified");
+    network_cache_store(url, etag, last_modified, max_age, chunk->memory, chunk->size);
+    g_free(etag);
+    g_free(last_modified);
+    return TRUE;
+}
+
+gboolean
+fetch_url_internal(const gchar *url, struct MemoryStruct *chunk, const gchar *post_data, const gchar *method, long *response_code)
+{
+    CURL *curl_handle;
+    CURLcode res;
+    struct curl_slist *headers = NULL;
+
+    memory_struct_release(chunk);
+    if (!memory_struct_reserve(chunk, 0)) {
+        g_critical("not enough memory for response buffer");
+        return FALSE;
+    }
+
+    if (network_cache_is_cacheable_request(post_data, method) && network_cache_lookup_fresh(url, chunk)) {
+        *response_code = 200;
+        return TRUE;
+    }
+
+    curl_handle = network_pool_acquire();
+    if (!curl_handle) {
+        g_critical("curl_easy_init() failed");
+        memory_struct_release(chunk);
+        return FALSE;
+    }
+
+    for (gboolean conditional = TRUE; ; conditional = FALSE) {
+        headers = network_prepare_handle(curl_handle, url, chunk, post_data, method, conditional);
+        res = curl_easy_perform(curl_handle);
+        curl_slist_free_all(headers);
+        if (res != CURLE_OK) break;
+
+        curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, response_code);
+        network_record_transfer(curl_handle, url, chunk);
+        network_observe_rate_limit(curl_handle, *response_code);
+        if (network_cache_update(curl_handle, url, post_data, method, chunk, response_code)) break;
+
+        // A 304 for an entry evicted after the validators were sent has no
+        // body to serve, so ask once more without them
+        memory_struct_release(chunk);
+        if (!conditional || !memory_struct_reserve(chunk, 0)) {
+            g_critical("Got 304 for %s with nothing cached", url);
+            network_pool_release(curl_handle);
+            return FALSE;
+        }
+    }
 
     if (res != CURLE_OK) {
         g_critical("curl_easy_perform() failed: %s", curl_easy_strerror(res));
-        free(chunk->memory);
-        chunk->memory = NULL;
-        chunk->size = 0;
-        curl_easy_cleanup(curl_handle);
+        memory_struct_release(chunk);
+        network_pool_release(curl_handle);
         return FALSE;
     }
 
-    curl_easy_cleanup(curl_handle);
+    network_pool_release(curl_handle);
     return TRUE;
 }
 
+gboolean
+network_response_may_need_challenge(const struct MemoryStruct *chunk, long response_code)
+{
+    if (response_code == 429 || response_code == 403 || response_code == 400) {
+        return TRUE;
+    }
+
+    // Otherwise only a small JSON object with top-level "challenge" and
+    // "token" members is one. Feeds are arrays or far larger, so they are
+    // rejected by the first byte or the size without being parsed.
+    if (!chunk->memory || chunk->size > CHALLENGE_MAX_BODY_BYTES) return FALSE;
+
+    const gchar *body = chunk->memory;
+    while (g_ascii_isspace(*body)) body++;
+    if (*body != '{') return FALSE;
+
+    return strstr(body, "\"challenge\"") != NULL && strstr(body, "\"token\"") != NULL;
+}
+
 gboolean
 fetch_url(const gchar *url, struct MemoryStruct *chunk, const gchar *post_data, const gchar *method)
 {
     long response_code = 0;
-    chunk->memory = NULL;
-    chunk->size = 0;
+    memory_struct_init(chunk);
 
     if (!fetch_url_internal(url, chunk, post_data, method, &response_code)) {
         return FALSE;
     }
 
+    if (!network_response_may_need_challenge(chunk, response_code)) {
+        return TRUE;
+    }
+    return fetch_url_resolve_challenge(url, chunk, post_data, method, &response_code);
+}
+
+gboolean
+fetch_url_resolve_challenge(const gchar *url, struct MemoryStruct *chunk, const gchar *post_data, const gchar *method, long *response_code)
+{
     // Check if the response contains a challenge
     gchar *cap_token = check_and_solve_challenge(chunk->memory);
     if (cap_token) {
@@ -136,14 +475,14 @@ fetch_url(const gchar *url, struct MemoryStruct *chunk, const gchar *post_data,
             g_object_unref(builder);
         }
 
-        gboolean success = fetch_url_internal(url, chunk, new_post_data, method ? method : "POST", &response_code);
+        gboolean success = fetch_url_internal(url, chunk, new_post_data, method ? method : "POST", response_code);
         g_free(new_post_data);
         g_free(cap_token);
         return success;
     }
 
     // If it was a 429 or 403 with "Challenge token is required", we should explicitly get a challenge
-    if (response_code == 429 || response_code == 403 || response_code == 400) {
+    if (*response_code == 429 || *response_code == 403 || *response_code == 400) {
         gboolean needs_cap = FALSE;
         JsonParser *parser = json_parser_new();
         if (json_parser_load_from_data(parser, chunk->memory, -1, NULL)) {
@@ -154,7 +493,7 @@ fetch_url(const gchar *url, struct MemoryStruct *chunk, const gchar *post_data,
                     const gchar *error_msg = json_object_get_string_member(obj, "error");
                     if (g_str_has_prefix(error_msg, "Challenge token is required") || 
                         g_str_has_prefix(error_msg, "Rate limit exceeded") ||
-                        response_code == 429) {
+                        *response_code == 429) {
                         needs_cap = TRUE;
                     }
                 }
@@ -163,54 +502,49 @@ fetch_url(const gchar *url, struct MemoryStruct *chunk, const gchar *post_data,
         g_object_unref(parser);
 
         if (needs_cap) {
-            g_message("Challenge token required. Fetching new challenge.");
-            struct MemoryStruct challenge_chunk;
-            challenge_chunk.memory = NULL;
-            challenge_chunk.size = 0;
-            if (fetch_url_internal(CAP_CHALLENGE_URL, &challenge_chunk, "{}", "POST", &response_code)) {
-                cap_token = check_and_solve_challenge(challenge_chunk.memory);
-                free(challenge_chunk.memory);
-                
-                if (cap_token) {
-                    g_message("Fetched and solved new challenge. Retrying original request.");
-                    
-                    // If it was a ratelimit, we might need to call rate-limit-bypass first
-                    if (response_code == 429) {
-                        struct MemoryStruct bypass_chunk;
-                        bypass_chunk.memory = NULL;
-                        bypass_chunk.size = 0;
-                        gchar *bypass_data = g_strdup_printf("{\"capToken\": \"%s\"}", cap_token);
-                        fetch_url_internal(API_BASE_URL "/auth/cap/rate-limit-bypass", &bypass_chunk, bypass_data, "POST", &response_code);
-                        g_free(bypass_data);
-                        if (bypass_chunk.memory) free(bypass_chunk.memory);
-                    }
+            long original_code = *response_code;
+            g_message("Challenge token required.");
+
+            // Usually ready in the pool; otherwise fetched and solved now
+            cap_token = cap_tokens_take();
+            if (cap_token) {
+                g_message("Got a solved Cap token. Retrying original request.");
 
-                    gchar *new_post_data = NULL;
-                    if (post_data) {
-                        JsonParser *parser2 = json_parser_new();
-                        if (json_parser_load_from_data(parser2, post_data, -1, NULL)) {
-                            JsonNode *root = json_parser_get_root(parser2);
-                            if (JSON_NODE_HOLDS_OBJECT(root)) {
-                                JsonObject *obj = json_node_get_object(root);
-                                json_object_set_string_member(obj, "capToken", cap_token);
-                                JsonGenerator *gen = json_generator_new();
-                                json_generator_set_root(gen, root);
-                                new_post_data = json_generator_to_data(gen, NULL);
-                                g_object_unref(gen);
-                            }
+                // If it was a ratelimit, we might need to call rate-limit-bypass first
+                if (original_code == 429) {
+                    struct MemoryStruct bypass_chunk;
+                    memory_struct_init(&bypass_chunk);
+                    gchar *bypass_data = g_strdup_printf("{\"capToken\": \"%s\"}", cap_token);
+                    fetch_url_internal(API_BASE_URL "/auth/cap/rate-limit-bypass", &bypass_chunk, bypass_data, "POST", response_code);
+                    g_free(bypass_data);
+                    memory_struct_release(&bypass_chunk);
+                }
+
+                gchar *new_post_data = NULL;
+                if (post_data) {
+                    JsonParser *parser2 = json_parser_new();
+                    if (json_parser_load_from_data(parser2, post_data, -1, NULL)) {
+                        JsonNode *root = json_parser_get_root(parser2);
+                        if (JSON_NODE_HOLDS_OBJECT(root)) {
+                            JsonObject *obj = json_node_get_object(root);
+                            json_object_set_string_member(obj, "capToken", cap_token);
+                            JsonGenerator *gen = json_generator_new();
+                            json_generator_set_root(gen, root);
+                            new_post_data = json_generator_to_data(gen, NULL);
+                            g_object_unref(gen);
                         }
-                        g_object_unref(parser2);
-                    } else {
-                         // Even for GET, if it's ratelimited, we might need to pass capToken
-                         // but standard practice is POST for these.
-                         // For now, let's just try adding it if we can.
                     }
-
-                    gboolean success = fetch_url_internal(url, chunk, new_post_data, method, &response_code);
-                    g_free(new_post_data);
-                    g_free(cap_token);
-                    return success;
+                    g_object_unref(parser2);
+                } else {
+                     // Even for GET, if it's ratelimited, we might need to pass capToken
+                     // but standard practice is POST for these.
+                     // For now, let's just try adding it if we can.
                 }
+
+                gboolean success = fetch_url_internal(url, chunk, new_post_data, method, response_code);
+                g_free(new_post_data);
+                g_free(cap_token);
+                return success;
             }
         }
     }
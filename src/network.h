@@ -2,9 +2,37 @@
 #define NETWORK_H
 
 #include <glib.h>
+#include <curl/curl.h>
 #include "types.h"
 
 gboolean fetch_url(const gchar *url, struct MemoryStruct *chunk, const gchar *post_data, const gchar *method);
 gboolean fetch_url_internal(const gchar *url, struct MemoryStruct *chunk, const gchar *post_data, const gchar *method, long *response_code);
+gboolean fetch_url_resolve_challenge(const gchar *url, struct MemoryStruct *chunk, const gchar *post_data, const gchar *method, long *response_code);
+/**
+ * Cheap pre-check, run before any JSON parsing, for responses that may carry
+ * a Cap challenge or ask for a token.
+ */
+gboolean network_response_may_need_challenge(const struct MemoryStruct *chunk, long response_code);
+/**
+ * Stores a cacheable 200 response, or turns a 304 into a 200 carrying the
+ * cached body.
+ * @return FALSE for a 304 whose cached copy was evicted after the validators
+ *         were sent. @chunk holds no body then, and the request has to be
+ *         repeated unconditionally.
+ */
+gboolean network_cache_update(CURL *curl_handle, const gchar *url, const gchar *post_data, const gchar *method,
+                              struct MemoryStruct *chunk, long *response_code);
+void network_observe_rate_limit(CURL *curl_handle, long response_code);
+void network_record_transfer(CURL *curl_handle, const gchar *url, const struct MemoryStruct *chunk);
+/**
+ * @param conditional Whether to send the cached entry's validators, if any.
+ */
+struct curl_slist *network_prepare_handle(CURL *curl_handle, const gchar *url, struct MemoryStruct *chunk, const gchar *post_data, const gchar *method,
+                                          gboolean conditional);
+
+CURL *network_pool_acquire(void);
+void network_pool_release(CURL *handle);
+void network_get_pool_stats(guint64 *hits, guint64 *misses);
+void network_cleanup(void);
 
 #endif // NETWORK_H
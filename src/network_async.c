@@ -0,0 +1,648 @@
+#include <curl/curl.h>
+#include <glib.h>
+#ifdef G_OS_UNIX
+#include <glib-unix.h>
+#endif
+#include <string.h>
+#include <stdlib.h>
+#include "network_async.h"
+#include "network.h"
+#include "constants.h"
+#include "executor.h"
+#include "memory_pool.h"
+#include "network_cache.h"
+#include "network_stats.h"
+#include "globals.h"
+
+// One in-flight request on the multi handle
+struct AsyncRequest {
+    CURL *handle;
+    struct curl_slist *headers;
+    struct MemoryStruct chunk;
+    gchar *url;
+    gchar *post_data;
+    gchar *method;
+    long response_code;
+    gboolean success;
+    gboolean unconditional;  // Repeated without validators after a 304 for an evicted entry
+    RequestPriority priority;
+    gchar *host;          // Scheduling bucket for the per-host limit
+    gchar *coalesce_key;  // Set while other callers may attach to this request
+    GSList *waiters;      // struct Waiter*, newest first; the first caller is the last entry
+};
+
+// A caller waiting for the result of a request. Several callers share one
+// request when identical GETs are coalesced.
+struct Waiter {
+    FetchCallback callback;
+    gpointer user_data;
+    GCancellable *cancellable;
+};
+
+// GLib watch for a socket curl asked us to poll
+struct SocketWatch {
+    curl_socket_t fd;
+    guint source_id;
+};
+
+static CURLM *multi = NULL;
+static guint timer_source = 0;
+static int running_handles = 0;
+static GHashTable *in_flight = NULL;  // Requests added to the multi handle
+static GQueue pending[REQUEST_PRIORITY_COUNT]; // Requests waiting for a slot, per class
+static GHashTable *host_running = NULL; // gchar* host -> number of requests in flight
+static GHashTable *coalescing = NULL; // gchar* coalesce key -> struct AsyncRequest*
+static guint max_concurrent_streams = MAX_CONCURRENT_STREAMS;
+
+static void check_multi_info(void);
+static void schedule_pending(void);
+
+static void
+free_waiter(gpointer data)
+{
+    struct Waiter *waiter = (struct Waiter *)data;
+    g_clear_object(&waiter->cancellable);
+    g_free(waiter);
+}
+
+static void
+add_waiter(struct AsyncRequest *req, FetchCallback callback, gpointer user_data, GCancellable *cancellable)
+{
+    struct Waiter *waiter = g_new0(struct Waiter, 1);
+    waiter->callback = callback;
+    waiter->user_data = user_data;
+    waiter->cancellable = cancellable ? g_object_ref(cancellable) : NULL;
+    req->waiters = g_slist_prepend(req->waiters, waiter);
+}
+
+// A transfer is only worth finishing while someone still wants the result
+static gboolean
+all_waiters_cancelled(struct AsyncRequest *req)
+{
+    if (!req->waiters) return FALSE;
+
+    for (GSList *l = req->waiters; l != NULL; l = l->next) {
+        struct Waiter *waiter = (struct Waiter *)l->data;
+        if (!waiter->cancellable || !g_cancellable_is_cancelled(waiter->cancellable)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static void
+free_request(struct AsyncRequest *req)
+{
+    if (req->handle) {
+        network_pool_release(req->handle);
+    }
+    curl_slist_free_all(req->headers);
+    memory_struct_release(&req->chunk);
+    g_free(req->url);
+    g_free(req->post_data);
+    g_free(req->method);
+    g_free(req->host);
+    g_free(req->coalesce_key);
+    g_slist_free_full(req->waiters, free_waiter);
+    g_free(req);
+}
+
+// Identical GETs by the same user share one transfer. Anything with a body
+// or side effects is never coalesced.
+static gchar*
+make_coalesce_key(const gchar *url, const gchar *post_data, const gchar *method)
+{
+    if (!network_cache_is_cacheable_request(post_data, method)) return NULL;
+    return g_strconcat("GET ", url, "\n", g_auth_token ? g_auth_token : "", NULL);
+}
+
+// Late callers must start a new transfer from here on
+static void
+stop_coalescing(struct AsyncRequest *req)
+{
+    if (req->coalesce_key && coalescing && g_hash_table_lookup(coalescing, req->coalesce_key) == req) {
+        g_hash_table_remove(coalescing, req->coalesce_key);
+    }
+}
+
+static void
+deliver_request(struct AsyncRequest *req)
+{
+    stop_coalescing(req);
+
+    struct MemoryStruct *chunk = req->success ? &req->chunk : NULL;
+    long response_code = req->success ? req->response_code : 0;
+
+    gint64 callback_start = g_get_monotonic_time();
+    req->waiters = g_slist_reverse(req->waiters);
+    for (GSList *l = req->waiters; l != NULL; l = l->next) {
+        struct Waiter *waiter = (struct Waiter *)l->data;
+        if (!waiter->callback) continue;
+
+        // Cancelled callers only get the chance to free their user_data
+        if (waiter->cancellable && g_cancellable_is_cancelled(waiter->cancellable)) {
+            waiter->callback(NULL, 0, waiter->user_data);
+        } else {
+            waiter->callback(chunk, response_code, waiter->user_data);
+        }
+    }
+    // Time spent parsing the response and building widgets from it
+    if (chunk) {
+        network_stats_record_phase(req->url, NETWORK_PHASE_CALLBACK,
+                                   (guint64)(g_get_monotonic_time() - callback_start));
+    }
+    free_request(req);
+}
+
+static gboolean
+on_deliver_idle(gpointer data)
+{
+    deliver_request((struct AsyncRequest *)data);
+    return G_SOURCE_REMOVE;
+}
+
+// Callbacks always run from the main loop, never from inside
+// fetch_url_async(). Results known before a transfer starts (cache hits,
+// failures to start, requests cancelled while queued) go through an idle.
+static void
+deliver_later(struct AsyncRequest *req)
+{
+    stop_coalescing(req);
+    g_idle_add(on_deliver_idle, req);
+}
+
+static void
+on_challenge_resolved(gpointer data)
+{
+    deliver_request((struct AsyncRequest *)data);
+}
+
+// Solving a challenge means a PoW search plus several blocking round trips,
+// so it runs on the executor's I/O lane. This only happens for rate-limited
+// or challenged responses, not for regular traffic.
+static void
+resolve_challenge_task(gpointer data)
+{
+    struct AsyncRequest *req = (struct AsyncRequest *)data;
+
+    req->success = fetch_url_resolve_challenge(req->url, &req->chunk, req->post_data,
+                                               req->method, &req->response_code);
+}
+
+static gchar*
+host_of_url(const gchar *url)
+{
+    const gchar *scheme_end = strstr(url, "://");
+    const gchar *host_start = scheme_end ? scheme_end + 3 : url;
+    return g_strndup(host_start, strcspn(host_start, "/?#"));
+}
+
+static guint
+running_for_host(const gchar *host)
+{
+    return GPOINTER_TO_UINT(g_hash_table_lookup(host_running, host));
+}
+
+static void
+mark_running(struct AsyncRequest *req, gboolean running)
+{
+    guint count = running_for_host(req->host);
+    count = running ? count + 1 : count - 1;
+
+    if (running) {
+        g_hash_table_add(in_flight, req);
+    } else {
+        g_hash_table_remove(in_flight, req);
+    }
+
+    if (count > 0) {
+        g_hash_table_insert(host_running, g_strdup(req->host), GUINT_TO_POINTER(count));
+    } else {
+        g_hash_table_remove(host_running, req->host);
+    }
+}
+
+static void
+complete_request(struct AsyncRequest *req, CURLcode result)
+{
+    mark_running(req, FALSE);
+
+    if (result == CURLE_ABORTED_BY_CALLBACK) {
+        g_debug("Async request to %s cancelled", req->url);
+        req->success = FALSE;
+        deliver_request(req);
+        return;
+    }
+
+    if (result != CURLE_OK) {
+        g_critical("Async request to %s failed: %s", req->url, curl_easy_strerror(result));
+        req->success = FALSE;
+        deliver_request(req);
+        return;
+    }
+
+    curl_easy_getinfo(req->handle, CURLINFO_RESPONSE_CODE, &req->response_code);
+    network_record_transfer(req->handle, req->url, &req->chunk);
+    network_observe_rate_limit(req->handle, req->response_code);
+    gboolean served = network_cache_update(req->handle, req->url, req->post_data, req->method,
+                                           &req->chunk, &req->response_code);
+    network_pool_release(req->handle);
+    req->handle = NULL;
+    curl_slist_free_all(req->headers);
+    req->headers = NULL;
+
+    if (!served) {
+        // A 304 for an entry evicted after the validators were sent has no
+        // body to serve, so ask once more without them. The retry waits for
+        // its turn like any other request; check_multi_info() schedules it.
+        memory_struct_release(&req->chunk);
+        if (!req->unconditional && memory_struct_reserve(&req->chunk, 0)) {
+            req->unconditional = TRUE;
+            g_queue_push_head(&pending[req->priority], req);
+            return;
+        }
+        g_critical("Got 304 for %s with nothing cached", req->url);
+        req->success = FALSE;
+        deliver_request(req);
+        return;
+    }
+    req->success = TRUE;
+
+    if (!all_waiters_cancelled(req) &&
+        network_response_may_need_challenge(&req->chunk, req->response_code)) {
+        executor_submit_full(EXECUTOR_LANE_IO, resolve_challenge_task, on_challenge_resolved, req);
+        return;
+    }
+
+    deliver_request(req);
+}
+
+static void
+check_multi_info(void)
+{
+    CURLMsg *msg;
+    int pending;
+
+    while ((msg = curl_multi_info_read(multi, &pending)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) continue;
+
+        CURL *easy = msg->easy_handle;
+        CURLcode result = msg->data.result;
+        struct AsyncRequest *req = NULL;
+
+        curl_easy_getinfo(easy, CURLINFO_PRIVATE, (char **)&req);
+        curl_multi_remove_handle(multi, easy);
+        complete_request(req, result);
+    }
+
+    schedule_pending();
+}
+
+static void
+socket_ready(curl_socket_t fd, GIOCondition condition)
+{
+    int action = 0;
+
+    if (condition & G_IO_IN) action |= CURL_CSELECT_IN;
+    if (condition & G_IO_OUT) action |= CURL_CSELECT_OUT;
+    if (condition & (G_IO_ERR | G_IO_HUP)) action |= CURL_CSELECT_ERR;
+
+    // The watch may be freed by on_socket() during this call, so it must not
+    // be touched afterwards. Returning CONTINUE on a removed source is a no-op.
+    curl_multi_socket_action(multi, fd, action, &running_handles);
+    check_multi_info();
+}
+
+#ifdef G_OS_UNIX
+static gboolean
+on_socket_ready(gint fd, GIOCondition condition, gpointer user_data)
+{
+    (void)user_data;
+    socket_ready(fd, condition);
+    return G_SOURCE_CONTINUE;
+}
+#else
+// Winsock sockets are not file descriptors, so they are polled through a
+// socket channel instead of g_unix_fd_add()
+static gboolean
+on_channel_ready(GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+    (void)channel;
+    socket_ready((curl_socket_t)GPOINTER_TO_SIZE(user_data), condition);
+    return G_SOURCE_CONTINUE;
+}
+#endif
+
+static guint
+add_socket_watch(curl_socket_t s, GIOCondition condition)
+{
+#ifdef G_OS_UNIX
+    return g_unix_fd_add(s, condition, on_socket_ready, NULL);
+#else
+    // The watch holds its own reference to the channel
+    GIOChannel *channel = g_io_channel_win32_new_socket((gint)s);
+    guint source_id = g_io_add_watch(channel, condition, on_channel_ready, GSIZE_TO_POINTER(s));
+    g_io_channel_unref(channel);
+    return source_id;
+#endif
+}
+
+static int
+on_socket(CURL *easy, curl_socket_t s, int what, void *userp, void *socketp)
+{
+    (void)easy;
+    (void)userp;
+    struct SocketWatch *watch = (struct SocketWatch *)socketp;
+
+    if (what == CURL_POLL_REMOVE) {
+        if (watch) {
+            g_source_remove(watch->source_id);
+            g_free(watch);
+            curl_multi_assign(multi, s, NULL);
+        }
+        return 0;
+    }
+
+    GIOCondition condition = G_IO_ERR | G_IO_HUP;
+    if (what & CURL_POLL_IN) condition |= G_IO_IN;
+    if (what & CURL_POLL_OUT) condition |= G_IO_OUT;
+
+    if (watch) {
+        g_source_remove(watch->source_id);
+    } else {
+        watch = g_new0(struct SocketWatch, 1);
+        watch->fd = s;
+        curl_multi_assign(multi, s, watch);
+    }
+    watch->source_id = add_socket_watch(s, condition);
+    return 0;
+}
+
+static gboolean
+on_timeout(gpointer user_data)
+{
+    (void)user_data;
+    timer_source = 0;
+    curl_multi_socket_action(multi, CURL_SOCKET_TIMEOUT, 0, &running_handles);
+    check_multi_info();
+    return G_SOURCE_REMOVE;
+}
+
+static int
+on_timer(CURLM *multi_handle, long timeout_ms, void *userp)
+{
+    (void)multi_handle;
+    (void)userp;
+
+    if (timer_source) {
+        g_source_remove(timer_source);
+        timer_source = 0;
+    }
+    if (timeout_ms >= 0) {
+        timer_source = g_timeout_add((guint)timeout_ms, on_timeout, NULL);
+    }
+    return 0;
+}
+
+// Called by curl at least once a second during a transfer, and whenever data
+// arrives. Returning non-zero aborts the transfer with CURLE_ABORTED_BY_CALLBACK.
+static int
+on_transfer_progress(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+{
+    (void)dltotal;
+    (void)dlnow;
+    (void)ultotal;
+    (void)ulnow;
+    return all_waiters_cancelled((struct AsyncRequest *)clientp) ? 1 : 0;
+}
+
+static gboolean
+ensure_multi(void)
+{
+    if (multi) return TRUE;
+
+    multi = curl_multi_init();
+    if (!multi) {
+        g_critical("curl_multi_init() failed");
+        return FALSE;
+    }
+    curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, on_socket);
+    curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, on_timer);
+
+    // Multiplex everything over a few HTTP/2 connections instead of opening
+    // one connection per image. Requests beyond the per-host limit wait for
+    // a free stream on an existing connection.
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)MAX_HOST_CONNECTIONS);
+    curl_multi_setopt(multi, CURLMOPT_MAX_CONCURRENT_STREAMS, (long)max_concurrent_streams);
+    in_flight = g_hash_table_new(g_direct_hash, g_direct_equal);
+    host_running = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    for (int priority = 0; priority < REQUEST_PRIORITY_COUNT; priority++) {
+        g_queue_init(&pending[priority]);
+    }
+    coalescing = g_hash_table_new(g_str_hash, g_str_equal);
+    return TRUE;
+}
+
+// Acquires a handle for a queued request and hands it to the multi handle
+static void
+start_request(struct AsyncRequest *req)
+{
+    if (!(req->handle = network_pool_acquire())) {
+        req->success = FALSE;
+        deliver_later(req);
+        return;
+    }
+
+    req->headers = network_prepare_handle(req->handle, req->url, &req->chunk, req->post_data, req->method,
+                                          !req->unconditional);
+    curl_easy_setopt(req->handle, CURLOPT_PRIVATE, req);
+    // Prefer waiting for a multiplexed stream over opening a new connection
+    curl_easy_setopt(req->handle, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(req->handle, CURLOPT_XFERINFOFUNCTION, on_transfer_progress);
+    curl_easy_setopt(req->handle, CURLOPT_XFERINFODATA, req);
+    curl_easy_setopt(req->handle, CURLOPT_NOPROGRESS, 0L);
+
+    mark_running(req, TRUE);
+    CURLMcode rc = curl_multi_add_handle(multi, req->handle);
+    if (rc != CURLM_OK) {
+        g_critical("curl_multi_add_handle() failed: %s", curl_multi_strerror(rc));
+        mark_running(req, FALSE);
+        req->success = FALSE;
+        deliver_later(req);
+    }
+}
+
+// Takes the most urgent queued request that may run now: one nobody wants
+// any more, an interactive one, or one whose host is below its limit.
+// Classes are scanned in order, so a lower class never overtakes a higher
+// one waiting for the same host.
+static struct AsyncRequest*
+pop_runnable(void)
+{
+    for (int priority = 0; priority < REQUEST_PRIORITY_COUNT; priority++) {
+        for (GList *l = pending[priority].head; l != NULL; l = l->next) {
+            struct AsyncRequest *req = (struct AsyncRequest *)l->data;
+            if (all_waiters_cancelled(req) || priority == REQUEST_PRIORITY_INTERACTIVE ||
+                running_for_host(req->host) < MAX_REQUESTS_PER_HOST) {
+                g_queue_delete_link(&pending[priority], l);
+                return req;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Rescans after every start because callbacks may queue new requests
+static void
+schedule_pending(void)
+{
+    struct AsyncRequest *req;
+
+    while ((req = pop_runnable()) != NULL) {
+        if (all_waiters_cancelled(req)) {
+            req->success = FALSE;
+            deliver_later(req);
+        } else {
+            start_request(req);
+        }
+    }
+}
+
+// Moves a queued request up to @priority. Never lowers it.
+static void
+raise_priority(struct AsyncRequest *req, RequestPriority priority)
+{
+    if (priority >= req->priority) return;
+
+    // Requests already on the multi handle are no longer queued
+    if (g_queue_remove(&pending[req->priority], req)) {
+        g_queue_push_tail(&pending[priority], req);
+    }
+    req->priority = priority;
+}
+
+void
+fetch_url_async(const gchar *url, const gchar *post_data, const gchar *method,
+                FetchCallback callback, gpointer user_data)
+{
+    fetch_url_async_full(url, post_data, method, REQUEST_PRIORITY_FEED, NULL, callback, user_data);
+}
+
+void
+fetch_url_async_full(const gchar *url, const gchar *post_data, const gchar *method,
+                     RequestPriority priority, GCancellable *cancellable,
+                     FetchCallback callback, gpointer user_data)
+{
+    gchar *coalesce_key = make_coalesce_key(url, post_data, method);
+    struct AsyncRequest *leader = coalesce_key && coalescing ? g_hash_table_lookup(coalescing, coalesce_key) : NULL;
+    if (leader) {
+        add_waiter(leader, callback, user_data, cancellable);
+        raise_priority(leader, priority);
+        schedule_pending();
+        network_stats_record_coalesced(url);
+        g_free(coalesce_key);
+        return;
+    }
+
+    struct AsyncRequest *req = g_new0(struct AsyncRequest, 1);
+    req->url = g_strdup(url);
+    req->post_data = g_strdup(post_data);
+    req->method = g_strdup(method);
+    req->priority = priority;
+    req->host = host_of_url(url);
+    add_waiter(req, callback, user_data, cancellable);
+    req->coalesce_key = coalesce_key;
+    memory_struct_init(&req->chunk);
+
+    if (network_cache_is_cacheable_request(post_data, method) && network_cache_lookup_fresh(req->url, &req->chunk)) {
+        req->response_code = 200;
+        req->success = TRUE;
+        deliver_later(req);
+        return;
+    }
+
+    if (!memory_struct_reserve(&req->chunk, 0) || !ensure_multi()) {
+        req->success = FALSE;
+        deliver_later(req);
+        return;
+    }
+
+    if (req->coalesce_key) {
+        g_hash_table_insert(coalescing, req->coalesce_key, req);
+    }
+    g_queue_push_tail(&pending[priority], req);
+    schedule_pending();
+}
+
+void
+network_async_set_priority(const gchar *url, RequestPriority priority)
+{
+    gchar *coalesce_key = make_coalesce_key(url, NULL, "GET");
+    struct AsyncRequest *req = coalescing ? g_hash_table_lookup(coalescing, coalesce_key) : NULL;
+    if (req) {
+        raise_priority(req, priority);
+        schedule_pending();
+    }
+    g_free(coalesce_key);
+}
+
+guint
+network_async_get_queued_count(void)
+{
+    guint count = 0;
+    for (int priority = 0; priority < REQUEST_PRIORITY_COUNT; priority++) {
+        count += g_queue_get_length(&pending[priority]);
+    }
+    return count;
+}
+
+void
+network_async_set_max_streams(guint max_streams)
+{
+    max_concurrent_streams = CLAMP(max_streams, 1, 256);
+    if (multi) {
+        // Only affects connections opened after this point
+        curl_multi_setopt(multi, CURLMOPT_MAX_CONCURRENT_STREAMS, (long)max_concurrent_streams);
+    }
+}
+
+guint
+network_async_get_max_streams(void)
+{
+    return max_concurrent_streams;
+}
+
+void
+network_async_cleanup(void)
+{
+    if (!multi) return;
+
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, in_flight);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        struct AsyncRequest *req = (struct AsyncRequest *)key;
+        curl_multi_remove_handle(multi, req->handle);
+        free_request(req);
+    }
+    g_hash_table_destroy(in_flight);
+    in_flight = NULL;
+    for (int priority = 0; priority < REQUEST_PRIORITY_COUNT; priority++) {
+        struct AsyncRequest *req;
+        while ((req = g_queue_pop_head(&pending[priority])) != NULL) {
+            free_request(req);
+        }
+    }
+    g_hash_table_destroy(host_running);
+    host_running = NULL;
+    g_hash_table_destroy(coalescing);
+    coalescing = NULL;
+
+    if (timer_source) {
+        g_source_remove(timer_source);
+        timer_source = 0;
+    }
+    curl_multi_cleanup(multi);
+    multi = NULL;
+}
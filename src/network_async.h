@@ -0,0 +1,75 @@
+#ifndef NETWORK_ASYNC_H
+#define NETWORK_ASYNC_H
+
+#include <glib.h>
+#include <gio/gio.h>
+#include "types.h"
+
+// Scheduling classes, most urgent first. Interactive requests (actions the
+// user just triggered) always start immediately. The others wait for a free
+// slot under the per-host limit, MAX_REQUESTS_PER_HOST.
+typedef enum {
+    REQUEST_PRIORITY_INTERACTIVE,
+    REQUEST_PRIORITY_FEED,      // Timelines, profiles, lists
+    REQUEST_PRIORITY_MEDIA,     // Images that are on screen
+    REQUEST_PRIORITY_PREFETCH,  // Images not shown yet, speculative loads
+    REQUEST_PRIORITY_COUNT
+} RequestPriority;
+
+/**
+ * Completion callback for fetch_url_async(). Always invoked on the main loop,
+ * never from inside the fetch_url_async() call that registered it.
+ * @param chunk The response body, or NULL if the transfer failed. It is owned
+ *              by the network layer and only valid until the callback returns.
+ * @param response_code The HTTP status code, or 0 if the transfer failed.
+ * @param user_data The pointer passed to fetch_url_async().
+ */
+typedef void (*FetchCallback)(struct MemoryStruct *chunk, long response_code, gpointer user_data);
+
+/**
+ * Starts a non-blocking request on the shared curl multi handle.
+ * Must be called from the main thread. Sockets and timers are driven by the
+ * GLib main loop, so no thread is created per request. Challenge responses
+ * are solved and retried before the callback runs, like fetch_url().
+ * @param callback Invoked exactly once with the result. May be NULL.
+ */
+void fetch_url_async(const gchar *url, const gchar *post_data, const gchar *method,
+                     FetchCallback callback, gpointer user_data);
+
+/**
+ * Like fetch_url_async() (which uses REQUEST_PRIORITY_FEED), but with an
+ * explicit scheduling class, and the request can be cancelled. Once every caller
+ * sharing the transfer has cancelled, it is aborted mid-flight. A cancelled
+ * caller's callback still runs exactly once, with a NULL chunk, so that it
+ * can free @user_data.
+ * @param cancellable May be NULL.
+ */
+void fetch_url_async_full(const gchar *url, const gchar *post_data, const gchar *method,
+                          RequestPriority priority, GCancellable *cancellable,
+                          FetchCallback callback, gpointer user_data);
+
+/**
+ * Raises the class of a queued GET for @url, e.g. when an image scrolls into
+ * view. Never lowers it. Does nothing if the request already started.
+ */
+void network_async_set_priority(const gchar *url, RequestPriority priority);
+
+/**
+ * Number of requests waiting for a slot under the per-host limit.
+ */
+guint network_async_get_queued_count(void);
+
+/**
+ * Sets the maximum number of concurrent HTTP/2 streams per connection.
+ * Clamped to 1..256. Defaults to MAX_CONCURRENT_STREAMS.
+ */
+void network_async_set_max_streams(guint max_streams);
+guint network_async_get_max_streams(void);
+
+/**
+ * Aborts every in-flight request without invoking callbacks and frees the
+ * multi handle. Called once on shutdown.
+ */
+void network_async_cleanup(void);
+
+#endif // NETWORK_ASYNC_H
@@ -0,0 +1,218 @@
+#include <string.h>
+#include "network_cache.h"
+#include "memory_pool.h"
+#include "constants.h"
+#include "globals.h"
+
+struct CacheEntry {
+    gchar *key;
+    gchar *etag;
+    gchar *last_modified;
+    gint64 expires_at;  // Monotonic time in microseconds
+    gchar *body;
+    gsize size;
+    GList link;         // Position in lru, most recently used first
+};
+
+static GMutex cache_mutex;
+static GHashTable *entries = NULL; // gchar* key -> struct CacheEntry*
+static GQueue lru = G_QUEUE_INIT;
+static gsize cached_bytes = 0;
+static guint64 stat_fresh_hits = 0;
+static guint64 stat_not_modified = 0;
+
+// Responses differ per user, so the token is part of the key
+static gchar*
+make_key(const gchar *url)
+{
+    return g_strconcat(url, "\n", g_auth_token ? g_auth_token : "", NULL);
+}
+
+static void
+free_entry(struct CacheEntry *entry)
+{
+    g_free(entry->key);
+    g_free(entry->etag);
+    g_free(entry->last_modified);
+    g_free(entry->body);
+    g_free(entry);
+}
+
+static void
+remove_entry(struct CacheEntry *entry)
+{
+    g_queue_unlink(&lru, &entry->link);
+    cached_bytes -= entry->size;
+    g_hash_table_remove(entries, entry->key);
+    free_entry(entry);
+}
+
+// Looks up an entry and marks it as most recently used. Caller holds the lock.
+static struct CacheEntry*
+lookup_entry(const gchar *url)
+{
+    if (!entries) return NULL;
+
+    gchar *key = make_key(url);
+    struct CacheEntry *entry = g_hash_table_lookup(entries, key);
+    g_free(key);
+
+    if (entry) {
+        g_queue_unlink(&lru, &entry->link);
+        g_queue_push_head_link(&lru, &entry->link);
+    }
+    return entry;
+}
+
+static gint64
+expiry_from_max_age(gint64 max_age)
+{
+    return max_age > 0 ? g_get_monotonic_time() + max_age * G_USEC_PER_SEC : 0;
+}
+
+static void
+copy_body(const struct CacheEntry *entry, struct MemoryStruct *chunk)
+{
+    memory_struct_release(chunk);
+    memory_struct_reserve(chunk, entry->size);
+    memory_struct_append(chunk, entry->body, entry->size);
+}
+
+gboolean
+network_cache_is_cacheable_request(const gchar *post_data, const gchar *method)
+{
+    return post_data == NULL && (method == NULL || g_ascii_strcasecmp(method, "GET") == 0);
+}
+
+gboolean
+network_cache_lookup_fresh(const gchar *url, struct MemoryStruct *chunk)
+{
+    gboolean found = FALSE;
+
+    g_mutex_lock(&cache_mutex);
+    struct CacheEntry *entry = lookup_entry(url);
+    if (entry && entry->expires_at > g_get_monotonic_time()) {
+        copy_body(entry, chunk);
+        stat_fresh_hits++;
+        found = TRUE;
+    }
+    g_mutex_unlock(&cache_mutex);
+
+    return found;
+}
+
+gboolean
+network_cache_get_validators(const gchar *url, gchar **etag, gchar **last_modified)
+{
+    *etag = NULL;
+    *last_modified = NULL;
+
+    g_mutex_lock(&cache_mutex);
+    struct CacheEntry *entry = lookup_entry(url);
+    if (entry) {
+        *etag = g_strdup(entry->etag);
+        *last_modified = g_strdup(entry->last_modified);
+    }
+    g_mutex_unlock(&cache_mutex);
+
+    return *etag != NULL || *last_modified != NULL;
+}
+
+void
+network_cache_store(const gchar *url, const gchar *etag, const gchar *last_modified,
+                    gint64 max_age, const gchar *body, gsize size)
+{
+    if (!etag && !last_modified && max_age <= 0) return;
+    // A single huge body would push out everything else
+    if (size > HTTP_CACHE_MAX_BYTES / 4) return;
+
+    struct CacheEntry *entry = g_new0(struct CacheEntry, 1);
+    entry->key = make_key(url);
+    entry->etag = g_strdup(etag);
+    entry->last_modified = g_strdup(last_modified);
+    entry->expires_at = expiry_from_max_age(max_age);
+    entry->body = g_memdup2(body, size);
+    entry->size = size;
+    entry->link.data = entry;
+
+    g_mutex_lock(&cache_mutex);
+    if (!entries) {
+        entries = g_hash_table_new(g_str_hash, g_str_equal);
+    }
+
+    struct CacheEntry *old = g_hash_table_lookup(entries, entry->key);
+    if (old) {
+        remove_entry(old);
+    }
+
+    g_hash_table_insert(entries, entry->key, entry);
+    g_queue_push_head_link(&lru, &entry->link);
+    cached_bytes += size;
+
+    while (cached_bytes > HTTP_CACHE_MAX_BYTES && lru.tail) {
+        remove_entry((struct CacheEntry *)lru.tail->data);
+    }
+    g_mutex_unlock(&cache_mutex);
+}
+
+gboolean
+network_cache_revalidated(const gchar *url, gint64 max_age, struct MemoryStruct *chunk)
+{
+    gboolean found = FALSE;
+
+    g_mutex_lock(&cache_mutex);
+    struct CacheEntry *entry = lookup_entry(url);
+    if (entry) {
+        entry->expires_at = expiry_from_max_age(max_age);
+        copy_body(entry, chunk);
+        stat_not_modified++;
+        found = TRUE;
+    }
+    g_mutex_unlock(&cache_mutex);
+
+    return found;
+}
+
+gint64
+network_cache_parse_max_age(const gchar *cache_control, gboolean *no_store)
+{
+    gint64 max_age = 0;
+    gboolean no_cache = FALSE;
+
+    *no_store = FALSE;
+    if (!cache_control) return 0;
+
+    gchar **directives = g_strsplit(cache_control, ",", -1);
+    for (int i = 0; directives[i] != NULL; i++) {
+        gchar *directive = g_strstrip(directives[i]);
+        if (g_ascii_strcasecmp(directive, "no-store") == 0) {
+            *no_store = TRUE;
+        } else if (g_ascii_strcasecmp(directive, "no-cache") == 0) {
+            no_cache = TRUE;
+        } else if (g_ascii_strncasecmp(directive, "max-age=", 8) == 0) {
+            max_age = g_ascii_strtoll(directive + 8, NULL, 10);
+        }
+    }
+    g_strfreev(directives);
+
+    return no_cache || max_age < 0 ? 0 : max_age;
+}
+
+void
+network_cache_get_stats(guint64 *fresh_hits, guint64 *not_modified)
+{
+    g_mutex_lock(&cache_mutex);
+    if (fresh_hits) *fresh_hits = stat_fresh_hits;
+    if (not_modified) *not_modified = stat_not_modified;
+    g_mutex_unlock(&cache_mutex);
+}
+
+void
+network_cache_clear(void)
+{
+    g_mutex_lock(&cache_mutex);
+    while (lru.head) {
+        remove_entry((struct CacheEntry *)lru.head->data);
+    }
+    g_mutex_unlock(&cache_mutex);
+}
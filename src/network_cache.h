@@ -0,0 +1,56 @@
+#ifndef NETWORK_CACHE_H
+#define NETWORK_CACHE_H
+
+#include <glib.h>
+#include "types.h"
+
+// In-memory HTTP cache for GET responses, keyed by URL and the current auth
+// token. Entries are evicted least-recently-used once HTTP_CACHE_MAX_BYTES
+// of bodies are held. All functions are safe to call from any thread.
+
+/**
+ * Whether a request with this body and method may be served from the cache.
+ */
+gboolean network_cache_is_cacheable_request(const gchar *post_data, const gchar *method);
+
+/**
+ * Copies a cached body into @chunk if its max-age has not expired yet, so no
+ * request needs to be made at all.
+ * @return TRUE if @chunk was filled.
+ */
+gboolean network_cache_lookup_fresh(const gchar *url, struct MemoryStruct *chunk);
+
+/**
+ * Looks up the validators to send with a conditional request.
+ * @param etag Set to a newly allocated ETag, or NULL.
+ * @param last_modified Set to a newly allocated Last-Modified date, or NULL.
+ * @return TRUE if an entry with at least one validator exists.
+ */
+gboolean network_cache_get_validators(const gchar *url, gchar **etag, gchar **last_modified);
+
+/**
+ * Stores a 200 response. Does nothing if there is neither a validator nor a
+ * positive @max_age, or if the body is too large to be worth caching.
+ * @param max_age Freshness lifetime in seconds from Cache-Control.
+ */
+void network_cache_store(const gchar *url, const gchar *etag, const gchar *last_modified,
+                         gint64 max_age, const gchar *body, gsize size);
+
+/**
+ * Handles a 304 Not Modified: refreshes the entry's lifetime and replaces the
+ * contents of @chunk with the cached body.
+ * @return FALSE if the entry was evicted in the meantime.
+ */
+gboolean network_cache_revalidated(const gchar *url, gint64 max_age, struct MemoryStruct *chunk);
+
+/**
+ * Parses a Cache-Control header value.
+ * @param no_store Set to TRUE if the response must not be cached.
+ * @return The max-age in seconds, or 0 if absent or if no-cache is given.
+ */
+gint64 network_cache_parse_max_age(const gchar *cache_control, gboolean *no_store);
+
+void network_cache_get_stats(guint64 *fresh_hits, guint64 *not_modified);
+void network_cache_clear(void);
+
+#endif // NETWORK_CACHE_H
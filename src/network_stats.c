@@ -0,0 +1,343 @@
+#include <string.h>
+#include <json-glib/json-glib.h>
+#include "network_stats.h"
+#include "constants.h"
+
+static const gchar *phase_names[NETWORK_PHASE_COUNT] = {
+    "dns", "connect", "tls", "server", "download", "total", "callback"
+};
+
+// Path segments whose child segment is an identifier (tweet id, username,
+// conversation id...) rather than a fixed route component.
+static const gchar *id_collections[] = {
+    "tweets", "profile", "conversations", "users", "posts", "fact-check", NULL
+};
+
+static GMutex stats_mutex;
+static GHashTable *endpoint_stats = NULL; // gchar* endpoint -> struct EndpointStats*
+
+static gboolean
+is_id_collection(const gchar *segment)
+{
+    for (int i = 0; id_collections[i] != NULL; i++) {
+        if (strcmp(segment, id_collections[i]) == 0) return TRUE;
+    }
+    return FALSE;
+}
+
+static gboolean
+is_numeric(const gchar *segment)
+{
+    if (*segment == '\0') return FALSE;
+    for (const gchar *p = segment; *p; p++) {
+        if (!g_ascii_isdigit(*p)) return FALSE;
+    }
+    return TRUE;
+}
+
+gchar*
+network_stats_normalize_endpoint(const gchar *url)
+{
+    const gchar *path = url;
+    gchar *host = NULL;
+
+    const gchar *scheme_end = strstr(url, "://");
+    if (scheme_end) {
+        const gchar *host_start = scheme_end + 3;
+        const gchar *host_end = strchr(host_start, '/');
+        host = host_end ? g_strndup(host_start, host_end - host_start) : g_strdup(host_start);
+        path = host_end ? host_end : "/";
+    }
+
+    // Media on other hosts gets one bucket per host
+    if (host && g_strcmp0(host, strstr(BASE_DOMAIN, "://") + 3) != 0) {
+        gchar *endpoint = g_strdup_printf("%s/*", host);
+        g_free(host);
+        return endpoint;
+    }
+    g_free(host);
+
+    gsize path_len = strcspn(path, "?#");
+    gchar *bare_path = g_strndup(path, path_len);
+    gchar **segments = g_strsplit(bare_path, "/", -1);
+    GString *endpoint = g_string_new("");
+
+    const gchar *previous = "";
+    for (int i = 0; segments[i] != NULL; i++) {
+        const gchar *segment = segments[i];
+        if (i > 0) g_string_append_c(endpoint, '/');
+
+        if (*segment && strcmp(previous, "uploads") == 0) {
+            g_string_append(endpoint, "{file}");
+        } else if (*segment && (is_id_collection(previous) || is_numeric(segment))) {
+            g_string_append(endpoint, "{id}");
+        } else {
+            g_string_append(endpoint, segment);
+        }
+        previous = segment;
+    }
+
+    g_strfreev(segments);
+    g_free(bare_path);
+    return g_string_free(endpoint, FALSE);
+}
+
+// Returns the counters for @endpoint, creating them if needed. Takes
+// ownership of @endpoint. Caller holds stats_mutex.
+static struct EndpointStats*
+lookup_or_create(gchar *endpoint)
+{
+    if (!endpoint_stats) {
+        endpoint_stats = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    }
+    struct EndpointStats *stats = g_hash_table_lookup(endpoint_stats, endpoint);
+    if (!stats) {
+        stats = g_new0(struct EndpointStats, 1);
+        g_hash_table_insert(endpoint_stats, endpoint, stats);
+    } else {
+        g_free(endpoint);
+    }
+    return stats;
+}
+
+void
+network_stats_record_transfer(const gchar *url, guint64 wire_bytes, guint64 decoded_bytes)
+{
+    gchar *endpoint = network_stats_normalize_endpoint(url);
+
+    g_mutex_lock(&stats_mutex);
+    struct EndpointStats *stats = lookup_or_create(endpoint);
+    stats->requests++;
+    stats->wire_bytes += wire_bytes;
+    stats->decoded_bytes += decoded_bytes;
+    g_mutex_unlock(&stats_mutex);
+}
+
+void
+network_stats_histogram_add(struct LatencyHistogram *histogram, guint64 duration_us)
+{
+    guint64 ms = duration_us / 1000;
+    int bucket = 0;
+    while (ms > 0 && bucket < NETWORK_HISTOGRAM_BUCKETS - 1) {
+        ms >>= 1;
+        bucket++;
+    }
+
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->sum_us += duration_us;
+    histogram->max_us = MAX(histogram->max_us, duration_us);
+}
+
+void
+network_stats_record_timings(const gchar *url, guint64 sent_bytes,
+                             const guint64 phase_us[NETWORK_PHASE_COUNT], gboolean new_connection)
+{
+    gchar *endpoint = network_stats_normalize_endpoint(url);
+
+    g_mutex_lock(&stats_mutex);
+    struct EndpointStats *stats = lookup_or_create(endpoint);
+    stats->sent_bytes += sent_bytes;
+    for (int phase = 0; phase < NETWORK_PHASE_CALLBACK; phase++) {
+        gboolean handshake = phase == NETWORK_PHASE_DNS || phase == NETWORK_PHASE_CONNECT ||
+                             phase == NETWORK_PHASE_TLS;
+        if (handshake && !new_connection) continue;
+        network_stats_histogram_add(&stats->phases[phase], phase_us[phase]);
+    }
+    g_mutex_unlock(&stats_mutex);
+}
+
+void
+network_stats_record_phase(const gchar *url, NetworkPhase phase, guint64 duration_us)
+{
+    gchar *endpoint = network_stats_normalize_endpoint(url);
+
+    g_mutex_lock(&stats_mutex);
+    struct EndpointStats *stats = lookup_or_create(endpoint);
+    network_stats_histogram_add(&stats->phases[phase], duration_us);
+    g_mutex_unlock(&stats_mutex);
+}
+
+void
+network_stats_record_coalesced(const gchar *url)
+{
+    gchar *endpoint = network_stats_normalize_endpoint(url);
+
+    g_mutex_lock(&stats_mutex);
+    struct EndpointStats *stats = lookup_or_create(endpoint);
+    stats->coalesced++;
+    g_mutex_unlock(&stats_mutex);
+}
+
+gboolean
+network_stats_get(const gchar *endpoint, struct EndpointStats *stats)
+{
+    gboolean found = FALSE;
+
+    g_mutex_lock(&stats_mutex);
+    struct EndpointStats *entry = endpoint_stats ? g_hash_table_lookup(endpoint_stats, endpoint) : NULL;
+    if (entry) {
+        *stats = *entry;
+        found = TRUE;
+    }
+    g_mutex_unlock(&stats_mutex);
+
+    return found;
+}
+
+GList*
+network_stats_list_endpoints(void)
+{
+    GList *endpoints = NULL;
+    GHashTableIter iter;
+    gpointer key;
+
+    g_mutex_lock(&stats_mutex);
+    if (endpoint_stats) {
+        g_hash_table_iter_init(&iter, endpoint_stats);
+        while (g_hash_table_iter_next(&iter, &key, NULL)) {
+            endpoints = g_list_prepend(endpoints, g_strdup((const gchar *)key));
+        }
+    }
+    g_mutex_unlock(&stats_mutex);
+
+    return g_list_sort(endpoints, (GCompareFunc)g_strcmp0);
+}
+
+guint64
+network_stats_histogram_percentile(const struct LatencyHistogram *histogram, gdouble fraction)
+{
+    if (histogram->count == 0) return 0;
+
+    guint64 rank = (guint64)(fraction * histogram->count + 0.5);
+    guint64 seen = 0;
+    rank = CLAMP(rank, 1, histogram->count);
+
+    for (int bucket = 0; bucket < NETWORK_HISTOGRAM_BUCKETS; bucket++) {
+        seen += histogram->buckets[bucket];
+        if (seen >= rank) {
+            guint64 upper_us = ((guint64)1 << bucket) * 1000;
+            return MIN(upper_us, histogram->max_us);
+        }
+    }
+    return histogram->max_us;
+}
+
+const gchar*
+network_stats_phase_name(NetworkPhase phase)
+{
+    return phase < NETWORK_PHASE_COUNT ? phase_names[phase] : "unknown";
+}
+
+static void
+add_histogram_json(JsonBuilder *builder, const struct LatencyHistogram *histogram)
+{
+    json_builder_begin_object(builder);
+    json_builder_set_member_name(builder, "count");
+    json_builder_add_int_value(builder, histogram->count);
+    json_builder_set_member_name(builder, "mean_ms");
+    json_builder_add_double_value(builder, histogram->count ? histogram->sum_us / 1000.0 / histogram->count : 0.0);
+    json_builder_set_member_name(builder, "p50_ms");
+    json_builder_add_double_value(builder, network_stats_histogram_percentile(histogram, 0.5) / 1000.0);
+    json_builder_set_member_name(builder, "p95_ms");
+    json_builder_add_double_value(builder, network_stats_histogram_percentile(histogram, 0.95) / 1000.0);
+    json_builder_set_member_name(builder, "max_ms");
+    json_builder_add_double_value(builder, histogram->max_us / 1000.0);
+    json_builder_set_member_name(builder, "buckets");
+    json_builder_begin_array(builder);
+    for (int bucket = 0; bucket < NETWORK_HISTOGRAM_BUCKETS; bucket++) {
+        json_builder_add_int_value(builder, histogram->buckets[bucket]);
+    }
+    json_builder_end_array(builder);
+    json_builder_end_object(builder);
+}
+
+gchar*
+network_stats_to_json(void)
+{
+    GList *endpoints = network_stats_list_endpoints();
+    JsonBuilder *builder = json_builder_new();
+
+    json_builder_begin_object(builder);
+    json_builder_set_member_name(builder, "bucket_bounds_ms");
+    json_builder_begin_array(builder);
+    for (int bucket = 0; bucket < NETWORK_HISTOGRAM_BUCKETS - 1; bucket++) {
+        json_builder_add_int_value(builder, (gint64)1 << bucket);
+    }
+    json_builder_end_array(builder);
+
+    json_builder_set_member_name(builder, "endpoints");
+    json_builder_begin_array(builder);
+    for (GList *l = endpoints; l != NULL; l = l->next) {
+        struct EndpointStats stats;
+        if (!network_stats_get((const gchar *)l->data, &stats)) continue;
+
+        json_builder_begin_object(builder);
+        json_builder_set_member_name(builder, "endpoint");
+        json_builder_add_string_value(builder, (const gchar *)l->data);
+        json_builder_set_member_name(builder, "requests");
+        json_builder_add_int_value(builder, stats.requests);
+        json_builder_set_member_name(builder, "coalesced");
+        json_builder_add_int_value(builder, stats.coalesced);
+        json_builder_set_member_name(builder, "wire_bytes");
+        json_builder_add_int_value(builder, stats.wire_bytes);
+        json_builder_set_member_name(builder, "decoded_bytes");
+        json_builder_add_int_value(builder, stats.decoded_bytes);
+        json_builder_set_member_name(builder, "sent_bytes");
+        json_builder_add_int_value(builder, stats.sent_bytes);
+
+        json_builder_set_member_name(builder, "phases");
+        json_builder_begin_object(builder);
+        for (int phase = 0; phase < NETWORK_PHASE_COUNT; phase++) {
+            json_builder_set_member_name(builder, phase_names[phase]);
+            add_histogram_json(builder, &stats.phases[phase]);
+        }
+        json_builder_end_object(builder);
+        json_builder_end_object(builder);
+    }
+    json_builder_end_array(builder);
+    json_builder_end_object(builder);
+
+    JsonGenerator *gen = json_generator_new();
+    json_generator_set_pretty(gen, TRUE);
+    JsonNode *root = json_builder_get_root(builder);
+    json_generator_set_root(gen, root);
+    gchar *json = json_generator_to_data(gen, NULL);
+
+    json_node_free(root);
+    g_object_unref(gen);
+    g_object_unref(builder);
+    g_list_free_full(endpoints, g_free);
+    return json;
+}
+
+void
+network_stats_log_summary(void)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_mutex_lock(&stats_mutex);
+    if (endpoint_stats) {
+        g_hash_table_iter_init(&iter, endpoint_stats);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            struct EndpointStats *stats = value;
+            gdouble ratio = stats->wire_bytes > 0 ? (gdouble)stats->decoded_bytes / stats->wire_bytes : 1.0;
+            g_message("%s: %" G_GUINT64_FORMAT " requests, %" G_GUINT64_FORMAT " bytes on the wire, %"
+                      G_GUINT64_FORMAT " bytes decoded (%.1fx), %" G_GUINT64_FORMAT " coalesced",
+                      (const gchar *)key, stats->requests, stats->wire_bytes, stats->decoded_bytes, ratio,
+                      stats->coalesced);
+        }
+    }
+    g_mutex_unlock(&stats_mutex);
+}
+
+void
+network_stats_reset(void)
+{
+    g_mutex_lock(&stats_mutex);
+    if (endpoint_stats) {
+        g_hash_table_remove_all(endpoint_stats);
+    }
+    g_mutex_unlock(&stats_mutex);
+}
@@ -0,0 +1,113 @@
+#ifndef NETWORK_STATS_H
+#define NETWORK_STATS_H
+
+#include <glib.h>
+
+// Where the time of a request goes. The curl phases are derived from
+// CURLINFO_*_TIME_T and do not overlap.
+typedef enum {
+    NETWORK_PHASE_DNS,       // Name lookup, new connections only
+    NETWORK_PHASE_CONNECT,   // TCP connect, new connections only
+    NETWORK_PHASE_TLS,       // TLS handshake, new connections only
+    NETWORK_PHASE_SERVER,    // Request sent until the first response byte
+    NETWORK_PHASE_DOWNLOAD,  // First until last response byte
+    NETWORK_PHASE_TOTAL,     // The whole transfer as seen by curl
+    NETWORK_PHASE_CALLBACK,  // Completion callback on the main loop (widgets, small parses)
+    NETWORK_PHASE_COUNT
+} NetworkPhase;
+
+// Bucket 0 counts samples under 1 ms, bucket i counts [2^(i-1), 2^i) ms and
+// the last bucket everything slower.
+#define NETWORK_HISTOGRAM_BUCKETS 18
+
+struct LatencyHistogram {
+    guint64 count;
+    guint64 sum_us;
+    guint64 max_us;
+    guint64 buckets[NETWORK_HISTOGRAM_BUCKETS];
+};
+
+// Aggregated counters for one normalized endpoint
+struct EndpointStats {
+    guint64 requests;
+    guint64 wire_bytes;     // Body bytes as received, before content decoding
+    guint64 decoded_bytes;  // Body bytes after decompression
+    guint64 sent_bytes;     // Request body bytes
+    guint64 coalesced;      // Requests that shared an identical in-flight transfer
+    struct LatencyHistogram phases[NETWORK_PHASE_COUNT];
+};
+
+/**
+ * Maps a request URL to its endpoint bucket, e.g.
+ * "https://tweeta.tiago.zip/api/tweets/123/like?x=1" -> "/api/tweets/{id}/like".
+ * @return A newly allocated string.
+ */
+gchar* network_stats_normalize_endpoint(const gchar *url);
+
+/**
+ * Records a finished transfer. Safe to call from any thread.
+ */
+void network_stats_record_transfer(const gchar *url, guint64 wire_bytes, guint64 decoded_bytes);
+
+/**
+ * Records curl's timing breakdown of a finished transfer.
+ * @param phase_us Durations in microseconds for every phase before
+ *                 NETWORK_PHASE_CALLBACK.
+ * @param new_connection Whether DNS/connect/TLS happened at all. On a reused
+ *                       connection those phases are not recorded.
+ */
+void network_stats_record_timings(const gchar *url, guint64 sent_bytes,
+                                  const guint64 phase_us[NETWORK_PHASE_COUNT], gboolean new_connection);
+
+/**
+ * Adds a single sample to one phase histogram.
+ */
+void network_stats_record_phase(const gchar *url, NetworkPhase phase, guint64 duration_us);
+
+/**
+ * Counts a request that was answered by an identical in-flight transfer
+ * instead of going to the network.
+ */
+void network_stats_record_coalesced(const gchar *url);
+
+/**
+ * Copies the counters for a normalized endpoint into @stats.
+ * @return FALSE if nothing has been recorded for the endpoint.
+ */
+gboolean network_stats_get(const gchar *endpoint, struct EndpointStats *stats);
+
+/**
+ * @return The sorted list of endpoints with recorded data. Free with
+ *         g_list_free_full(list, g_free).
+ */
+GList* network_stats_list_endpoints(void);
+
+/**
+ * Adds a sample to @histogram. The caller does any locking.
+ */
+void network_stats_histogram_add(struct LatencyHistogram *histogram, guint64 duration_us);
+
+/**
+ * Estimates a percentile from a histogram.
+ * @param fraction e.g. 0.95 for the 95th percentile.
+ * @return The upper bound of the bucket holding the percentile, in
+ *         microseconds, capped at the largest sample. 0 if empty.
+ */
+guint64 network_stats_histogram_percentile(const struct LatencyHistogram *histogram, gdouble fraction);
+
+const gchar* network_stats_phase_name(NetworkPhase phase);
+
+/**
+ * Serializes every endpoint's counters and histograms.
+ * @return A newly allocated, pretty-printed JSON document.
+ */
+gchar* network_stats_to_json(void);
+
+/**
+ * Logs one line per endpoint with its compression savings.
+ */
+void network_stats_log_summary(void);
+
+void network_stats_reset(void);
+
+#endif // NETWORK_STATS_H
@@ -0,0 +1,426 @@
+#include <gio/gio.h>
+#include <json-glib/json-glib.h>
+#include "outbox.h"
+#include "constants.h"
+#include "globals.h"
+#include "memory_pool.h"
+#include "session.h"
+
+struct OutboxEntry {
+    gchar *url;
+    gchar *method;
+    gchar *body;
+    gchar *key;
+    OutboxCoalesce coalesce;
+    guint attempts;      // Times the server refused it with 429 or 5xx
+    gint64 queued_at;    // Wall-clock time in microseconds
+    gboolean restored;   // Loaded from the journal, so no caller is waiting
+    gboolean dropped;    // Cleared while being sent
+    FetchCallback callback;
+    gpointer user_data;
+};
+
+static GQueue entries = G_QUEUE_INIT;   // struct OutboxEntry*, oldest first
+static struct OutboxEntry *sending = NULL;
+static guint retry_source_id = 0;
+static guint retry_attempts = 0;        // Consecutive failed attempts
+static guint save_source_id = 0;        // Pending write of the journal
+static OutboxChangedFunc changed_handler = NULL;
+static gpointer changed_user_data = NULL;
+
+static void send_next(void);
+
+static void
+free_entry(struct OutboxEntry *entry)
+{
+    g_free(entry->url);
+    g_free(entry->method);
+    g_free(entry->body);
+    g_free(entry->key);
+    g_free(entry);
+}
+
+struct DiscardedCallback {
+    FetchCallback callback;
+    gpointer user_data;
+};
+
+static gboolean
+run_discarded_callback(gpointer user_data)
+{
+    struct DiscardedCallback *discarded = user_data;
+    discarded->callback(NULL, 0, discarded->user_data);
+    g_free(discarded);
+    return G_SOURCE_REMOVE;
+}
+
+// Tells the caller that @callback's write will never be sent. Deferred, so
+// the caller may be in the middle of outbox_enqueue().
+static void
+defer_discarded_callback(FetchCallback callback, gpointer user_data)
+{
+    if (!callback) return;
+
+    struct DiscardedCallback *discarded = g_new(struct DiscardedCallback, 1);
+    discarded->callback = callback;
+    discarded->user_data = user_data;
+    g_idle_add(run_discarded_callback, discarded);
+}
+
+static void
+discard_entry(struct OutboxEntry *entry)
+{
+    defer_discarded_callback(entry->callback, entry->user_data);
+    free_entry(entry);
+}
+
+static void
+notify_changed(void)
+{
+    if (changed_handler) {
+        changed_handler(outbox_get_pending_count(), retry_source_id != 0, changed_user_data);
+    }
+}
+
+// Rewrites the whole journal. It only holds writes not yet delivered, so it
+// stays small, and g_file_set_contents() replaces it atomically.
+static void
+save_journal(void)
+{
+    JsonBuilder *builder = json_builder_new();
+    json_builder_begin_array(builder);
+
+    for (GList *l = entries.head; l; l = l->next) {
+        struct OutboxEntry *entry = l->data;
+        if (entry->dropped) continue;
+
+        json_builder_begin_object(builder);
+        json_builder_set_member_name(builder, "url");
+        json_builder_add_string_value(builder, entry->url);
+        json_builder_set_member_name(builder, "method");
+        json_builder_add_string_value(builder, entry->method);
+        if (entry->body) {
+            json_builder_set_member_name(builder, "body");
+            json_builder_add_string_value(builder, entry->body);
+        }
+        if (entry->key) {
+            json_builder_set_member_name(builder, "key");
+            json_builder_add_string_value(builder, entry->key);
+        }
+        json_builder_set_member_name(builder, "coalesce");
+        json_builder_add_int_value(builder, entry->coalesce);
+        json_builder_set_member_name(builder, "attempts");
+        json_builder_add_int_value(builder, entry->attempts);
+        json_builder_set_member_name(builder, "queued_at");
+        json_builder_add_int_value(builder, entry->queued_at);
+        json_builder_end_object(builder);
+    }
+
+    json_builder_end_array(builder);
+
+    JsonGenerator *gen = json_generator_new();
+    json_generator_set_root(gen, json_builder_get_root(builder));
+    gchar *data = json_generator_to_data(gen, NULL);
+
+    gchar *path = get_config_file_path("outbox.json");
+    GError *error = NULL;
+    if (!g_file_set_contents(path, data, -1, &error)) {
+        g_warning("Failed to save outbox: %s", error->message);
+        g_error_free(error);
+    }
+
+    g_free(path);
+    g_free(data);
+    g_object_unref(gen);
+    g_object_unref(builder);
+}
+
+static gboolean
+on_save_due(gpointer user_data)
+{
+    (void)user_data;
+    save_source_id = 0;
+    save_journal();
+    return G_SOURCE_REMOVE;
+}
+
+// Writing the journal fsyncs it on the main loop, so a burst of changes
+// (clicking through likes) is written once, OUTBOX_SAVE_DELAY_MS later
+static void
+schedule_save(void)
+{
+    if (!save_source_id) {
+        save_source_id = g_timeout_add(OUTBOX_SAVE_DELAY_MS, on_save_due, NULL);
+    }
+}
+
+static void
+load_journal(void)
+{
+    gchar *path = get_config_file_path("outbox.json");
+    gchar *data = NULL;
+
+    if (g_file_get_contents(path, &data, NULL, NULL)) {
+        JsonParser *parser = json_parser_new();
+        if (json_parser_load_from_data(parser, data, -1, NULL) &&
+            JSON_NODE_HOLDS_ARRAY(json_parser_get_root(parser))) {
+            JsonArray *array = json_node_get_array(json_parser_get_root(parser));
+            for (guint i = 0; i < json_array_get_length(array); i++) {
+                JsonObject *obj = json_array_get_object_element(array, i);
+                if (!obj || !json_object_has_member(obj, "url") || !json_object_has_member(obj, "method")) {
+                    continue;
+                }
+
+                struct OutboxEntry *entry = g_new0(struct OutboxEntry, 1);
+                entry->url = g_strdup(json_object_get_string_member(obj, "url"));
+                entry->method = g_strdup(json_object_get_string_member(obj, "method"));
+                if (json_object_has_member(obj, "body")) {
+                    entry->body = g_strdup(json_object_get_string_member(obj, "body"));
+                }
+                if (json_object_has_member(obj, "key")) {
+                    entry->key = g_strdup(json_object_get_string_member(obj, "key"));
+                }
+                if (json_object_has_member(obj, "coalesce")) {
+                    entry->coalesce = json_object_get_int_member(obj, "coalesce");
+                }
+                if (json_object_has_member(obj, "attempts")) {
+                    entry->attempts = json_object_get_int_member(obj, "attempts");
+                }
+                // Journals written before entries were dated start their age now
+                entry->queued_at = json_object_has_member(obj, "queued_at") ?
+                                   json_object_get_int_member(obj, "queued_at") : g_get_real_time();
+                entry->restored = TRUE;
+                g_queue_push_tail(&entries, entry);
+            }
+        }
+        g_object_unref(parser);
+        g_free(data);
+    }
+    g_free(path);
+}
+
+// The newest entry with @key, if it can still cancel out against a new one
+static GList*
+find_cancellable(const gchar *key)
+{
+    for (GList *l = entries.tail; l; l = l->prev) {
+        struct OutboxEntry *entry = l->data;
+        if (g_strcmp0(entry->key, key) == 0) {
+            if (entry == sending || entry->restored || entry->dropped ||
+                entry->coalesce != OUTBOX_TOGGLE) {
+                return NULL;
+            }
+            return l;
+        }
+    }
+    return NULL;
+}
+
+static gboolean
+should_retry(struct MemoryStruct *chunk, long response_code)
+{
+    return !chunk || response_code == 0 || response_code == 429 || response_code >= 500;
+}
+
+// Whether a failed entry should be given up on. Only refusals by the server
+// count as attempts; while offline, entries are kept until they get too old.
+static gboolean
+entry_expired(struct OutboxEntry *entry)
+{
+    return entry->attempts >= OUTBOX_MAX_ATTEMPTS ||
+           g_get_real_time() - entry->queued_at > (gint64)OUTBOX_MAX_AGE_SECONDS * G_USEC_PER_SEC;
+}
+
+static gboolean
+on_retry_elapsed(gpointer user_data)
+{
+    (void)user_data;
+    retry_source_id = 0;
+    send_next();
+    notify_changed();
+    return G_SOURCE_REMOVE;
+}
+
+static void
+schedule_retry(void)
+{
+    guint delay = OUTBOX_RETRY_MIN_SECONDS;
+    for (guint i = 1; i < retry_attempts && delay < OUTBOX_RETRY_MAX_SECONDS; i++) {
+        delay *= 2;
+    }
+    delay = MIN(delay, OUTBOX_RETRY_MAX_SECONDS);
+
+    g_debug("Outbox: %u entries pending, retrying in %u s", outbox_get_pending_count(), delay);
+    retry_source_id = g_timeout_add_seconds(delay, on_retry_elapsed, NULL);
+}
+
+static void
+on_entry_sent(struct MemoryStruct *chunk, long response_code, gpointer user_data)
+{
+    struct OutboxEntry *entry = user_data;
+    sending = NULL;
+
+    if (should_retry(chunk, response_code) && !entry->dropped) {
+        if (chunk && response_code != 0) {
+            entry->attempts++;
+        }
+        if (!entry_expired(entry)) {
+            // Keep it at the head so later writes still follow it
+            retry_attempts++;
+            schedule_retry();
+            schedule_save();
+            notify_changed();
+            return;
+        }
+
+        // Otherwise it would hold up every later write, across restarts too
+        g_warning("Outbox: giving up on %s %s after %u refusals", entry->method, entry->url, entry->attempts);
+        g_queue_remove(&entries, entry);
+        retry_attempts = 0;
+        discard_entry(entry);
+        schedule_save();
+        notify_changed();
+        send_next();
+        return;
+    }
+
+    g_queue_remove(&entries, entry);
+    retry_attempts = 0;
+    if (response_code >= 400 && !should_retry(chunk, response_code)) {
+        g_warning("Outbox: %s %s rejected (HTTP %ld), dropping it", entry->method, entry->url, response_code);
+    }
+
+    if (entry->callback) {
+        entry->callback(should_retry(chunk, response_code) ? NULL : chunk, response_code, entry->user_data);
+    }
+    free_entry(entry);
+    schedule_save();
+    notify_changed();
+    send_next();
+}
+
+static void
+send_next(void)
+{
+    if (sending || retry_source_id || !g_auth_token || !entries.head) return;
+
+    sending = entries.head->data;
+    fetch_url_async_full(sending->url, sending->body, sending->method, REQUEST_PRIORITY_INTERACTIVE, NULL,
+                         on_entry_sent, sending);
+}
+
+static void
+on_network_changed(GNetworkMonitor *monitor, gboolean available, gpointer user_data)
+{
+    (void)monitor;
+    (void)user_data;
+    if (available && retry_source_id) {
+        g_source_remove(retry_source_id);
+        retry_source_id = 0;
+        send_next();
+        notify_changed();
+    }
+}
+
+void
+outbox_init(void)
+{
+    load_journal();
+    g_signal_connect(g_network_monitor_get_default(), "network-changed", G_CALLBACK(on_network_changed), NULL);
+    notify_changed();
+    send_next();
+}
+
+void
+outbox_enqueue(const gchar *url, const gchar *method, const gchar *body,
+               const gchar *key, OutboxCoalesce coalesce,
+               FetchCallback callback, gpointer user_data)
+{
+    GList *cancelled = key && coalesce == OUTBOX_TOGGLE ? find_cancellable(key) : NULL;
+    if (cancelled) {
+        discard_entry(cancelled->data);
+        g_queue_delete_link(&entries, cancelled);
+        defer_discarded_callback(callback, user_data);
+        schedule_save();
+        notify_changed();
+        return;
+    }
+
+    struct OutboxEntry *entry = g_new0(struct OutboxEntry, 1);
+    entry->url = g_strdup(url);
+    entry->method = g_strdup(method);
+    entry->body = g_strdup(body);
+    entry->key = g_strdup(key);
+    entry->coalesce = coalesce;
+    entry->queued_at = g_get_real_time();
+    entry->callback = callback;
+    entry->user_data = user_data;
+    g_queue_push_tail(&entries, entry);
+
+    schedule_save();
+    notify_changed();
+    send_next();
+}
+
+void
+outbox_resume(void)
+{
+    if (retry_source_id) {
+        g_source_remove(retry_source_id);
+        retry_source_id = 0;
+    }
+    send_next();
+    notify_changed();
+}
+
+guint
+outbox_get_pending_count(void)
+{
+    guint count = 0;
+    for (GList *l = entries.head; l; l = l->next) {
+        if (!((struct OutboxEntry *)l->data)->dropped) count++;
+    }
+    return count;
+}
+
+void
+outbox_set_changed_handler(OutboxChangedFunc handler, gpointer user_data)
+{
+    changed_handler = handler;
+    changed_user_data = user_data;
+}
+
+void
+outbox_flush(void)
+{
+    if (save_source_id) {
+        g_source_remove(save_source_id);
+        save_source_id = 0;
+        save_journal();
+    }
+}
+
+void
+outbox_clear(void)
+{
+    GList *l = entries.head;
+    while (l) {
+        GList *next = l->next;
+        struct OutboxEntry *entry = l->data;
+        if (entry == sending) {
+            entry->dropped = TRUE;
+        } else {
+            discard_entry(entry);
+            g_queue_delete_link(&entries, l);
+        }
+        l = next;
+    }
+
+    if (retry_source_id) {
+        g_source_remove(retry_source_id);
+        retry_source_id = 0;
+    }
+    retry_attempts = 0;
+    schedule_save();
+    notify_changed();
+}
@@ -0,0 +1,72 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <glib.h>
+#include "network_async.h"
+
+// Durable queue for the writes users make while browsing: posts, replies,
+// quotes, DMs, reactions and the like/retweet/bookmark toggles. Mark-read,
+// admin actions and fact-check notes are sent directly and not journaled.
+// Entries are journaled to outbox.json next to session.json and sent one at
+// a time, in order, while logged in. Transfer failures, 429 and 5xx
+// responses are retried with backoff from OUTBOX_RETRY_MIN_SECONDS up to
+// OUTBOX_RETRY_MAX_SECONDS, and at once when the network monitor reports
+// connectivity again. An entry refused OUTBOX_MAX_ATTEMPTS times, or still
+// failing OUTBOX_MAX_AGE_SECONDS after it was queued, is dropped. Entries
+// still queued at exit are sent on the next start. Main thread only.
+
+typedef enum {
+    OUTBOX_APPEND,   // Always sent (posts, DMs, reactions)
+    OUTBOX_TOGGLE    // Cancels out against a queued entry with the same key (like then unlike)
+} OutboxCoalesce;
+
+typedef void (*OutboxChangedFunc)(guint pending, gboolean retrying, gpointer user_data);
+
+/**
+ * Loads the journal and starts sending what it contains.
+ */
+void outbox_init(void);
+
+/**
+ * Queues a write. @callback runs once the server has accepted (2xx) or
+ * rejected (other 4xx) it. Entries that cancel out, are given up on after
+ * too many retries or are removed by outbox_clear() get their callback from
+ * an idle handler with a NULL chunk, like a cancelled request. The entry
+ * being sent and entries restored from the journal never cancel out.
+ * @param key Identifies what the write changes, e.g. "like:<id>". May be
+ *            NULL for OUTBOX_APPEND.
+ */
+void outbox_enqueue(const gchar *url, const gchar *method, const gchar *body,
+                    const gchar *key, OutboxCoalesce coalesce,
+                    FetchCallback callback, gpointer user_data);
+
+/**
+ * Sends the next entry now if one is waiting, e.g. after logging in.
+ */
+void outbox_resume(void);
+
+/**
+ * @return Number of entries not yet accepted or rejected by the server.
+ */
+guint outbox_get_pending_count(void);
+
+/**
+ * Sets the function told about every change of the pending count or retry
+ * state. Only one handler is kept.
+ */
+void outbox_set_changed_handler(OutboxChangedFunc handler, gpointer user_data);
+
+/**
+ * Writes the journal now if a change is still waiting to be saved. Changes
+ * are saved OUTBOX_SAVE_DELAY_MS after the first one of a burst, so call
+ * this before exiting.
+ */
+void outbox_flush(void);
+
+/**
+ * Drops every entry and empties the journal, e.g. on logout. An entry being
+ * sent still completes, but is not retried if it fails.
+ */
+void outbox_clear(void);
+
+#endif // OUTBOX_H
@@ -0,0 +1,203 @@
+#include "posting.h"
+#include "actions.h"
+#include "constants.h"
+#include "globals.h"
+#include "json_utils.h"
+#include "memory_pool.h"
+#include "outbox.h"
+#include "string_intern.h"
+#include "ui_components.h"
+
+struct PendingPost {
+    GtkWidget *echo_row;      // Weak pointer, NULL once the row is destroyed
+    gchar *reply_to_id;
+    gchar *conversation_id;   // DMs only
+    gchar *content;           // DMs only, restored into the entry on failure
+                              // if the conversation is still open
+};
+
+static void
+free_pending_post(struct PendingPost *pending)
+{
+    if (pending->echo_row) {
+        g_object_remove_weak_pointer(G_OBJECT(pending->echo_row), (gpointer *)&pending->echo_row);
+    }
+    g_free(pending->reply_to_id);
+    g_free(pending->conversation_id);
+    g_free(pending->content);
+    g_free(pending);
+}
+
+// Inserts @widget as a greyed-out row and tracks it from @pending
+static void
+insert_echo(struct PendingPost *pending, GtkListBox *list_box, GtkWidget *widget, gint position)
+{
+    gtk_widget_show_all(widget);
+    gtk_list_box_insert(list_box, widget, position);
+
+    pending->echo_row = gtk_widget_get_parent(widget);
+    gtk_widget_set_sensitive(pending->echo_row, FALSE);
+    g_object_add_weak_pointer(G_OBJECT(pending->echo_row), (gpointer *)&pending->echo_row);
+}
+
+// Replaces the echo row with @widget, or just removes it if @widget is NULL
+static void
+replace_echo(struct PendingPost *pending, GtkWidget *widget)
+{
+    GtkWidget *row = pending->echo_row;
+    if (!row) return;
+
+    GtkListBox *list_box = GTK_LIST_BOX(gtk_widget_get_parent(row));
+    gint position = gtk_list_box_row_get_index(GTK_LIST_BOX_ROW(row));
+    gtk_widget_destroy(row);
+
+    if (widget) {
+        gtk_widget_show_all(widget);
+        gtk_list_box_insert(list_box, widget, position);
+    }
+}
+
+static void
+show_send_error(const gchar *message)
+{
+    GtkWidget *toplevel = g_stack ? gtk_widget_get_toplevel(g_stack) : NULL;
+    GtkWindow *window = GTK_IS_WINDOW(toplevel) ? GTK_WINDOW(toplevel) : NULL;
+    GtkWidget *error_dialog = gtk_message_dialog_new(window,
+                             GTK_DIALOG_DESTROY_WITH_PARENT,
+                             GTK_MESSAGE_ERROR,
+                             GTK_BUTTONS_CLOSE,
+                             "%s", message);
+    g_signal_connect(error_dialog, "response", G_CALLBACK(gtk_widget_destroy), NULL);
+    gtk_widget_show(error_dialog);
+}
+
+static gboolean
+response_succeeded(struct MemoryStruct *chunk, long response_code)
+{
+    return chunk && response_code >= 200 && response_code < 300;
+}
+
+// The outbox was cleared (logout) or gave up on the write before it went through
+static gboolean
+write_discarded(struct PendingPost *pending, struct MemoryStruct *chunk)
+{
+    if (chunk) return FALSE;
+
+    replace_echo(pending, NULL);
+    free_pending_post(pending);
+    return TRUE;
+}
+
+static void
+on_tweet_posted(struct MemoryStruct *chunk, long response_code, gpointer user_data)
+{
+    struct PendingPost *pending = user_data;
+
+    if (write_discarded(pending, chunk)) return;
+    if (!response_succeeded(chunk, response_code)) {
+        g_warning("Posting failed (HTTP %ld)", response_code);
+        replace_echo(pending, NULL);
+        show_send_error(pending->reply_to_id ? "Failed to post reply." : "Failed to post tweet.");
+        free_pending_post(pending);
+        return;
+    }
+
+    struct TweetPage *page = parse_posted_tweet(chunk->memory);
+    if (page) {
+        replace_echo(pending, create_tweet_widget(g_ptr_array_index(page->tweets, 0)));
+        tweet_page_unref(page);
+    } else if (pending->echo_row) {
+        // The response does not include the post; fetch the list instead
+        GtkWidget *list_box = gtk_widget_get_parent(pending->echo_row);
+        if (list_box == g_conversation_list && pending->reply_to_id) {
+            show_tweet(pending->reply_to_id);
+        } else {
+            start_loading_tweets(GTK_LIST_BOX(list_box));
+        }
+    }
+
+    free_pending_post(pending);
+}
+
+void
+posting_send_tweet(const gchar *content, const gchar *reply_to_id, const gchar *quote_id,
+                   GtkListBox *echo_list, gint position)
+{
+    struct PendingPost *pending = g_new0(struct PendingPost, 1);
+    pending->reply_to_id = g_strdup(reply_to_id);
+
+    if (echo_list) {
+        struct Tweet echo = {0};
+        echo.content = (gchar *)content;
+        echo.author_name = string_intern(g_current_username);
+        echo.author_username = echo.author_name;
+        insert_echo(pending, echo_list, create_tweet_widget(&echo), position);
+    }
+
+    gchar *post_data = construct_post_payload(content, reply_to_id, quote_id);
+    outbox_enqueue(POST_TWEET_URL, "POST", post_data, NULL, OUTBOX_APPEND, on_tweet_posted, pending);
+    g_free(post_data);
+}
+
+// Whether the DM view still shows @conversation_id, so its entry is the one
+// the message was typed into
+static gboolean
+conversation_is_open(const gchar *conversation_id)
+{
+    const gchar *open_id = g_object_get_data(G_OBJECT(g_dm_messages_list), "conversation_id");
+    return g_strcmp0(gtk_stack_get_visible_child_name(GTK_STACK(g_stack)), "dm_messages") == 0 &&
+           g_strcmp0(open_id, conversation_id) == 0;
+}
+
+static void
+on_dm_sent(struct MemoryStruct *chunk, long response_code, gpointer user_data)
+{
+    struct PendingPost *pending = user_data;
+
+    if (write_discarded(pending, chunk)) return;
+    if (!response_succeeded(chunk, response_code)) {
+        g_warning("Sending message failed (HTTP %ld)", response_code);
+        replace_echo(pending, NULL);
+        if (conversation_is_open(pending->conversation_id)) {
+            const gchar *current = gtk_entry_get_text(GTK_ENTRY(g_dm_entry));
+            if (!current || !*current) {
+                gtk_entry_set_text(GTK_ENTRY(g_dm_entry), pending->content);
+            }
+        }
+        show_send_error("Failed to send message.");
+        free_pending_post(pending);
+        return;
+    }
+
+    struct DirectMessage *msg = parse_sent_message(chunk->memory);
+    if (msg) {
+        replace_echo(pending, create_message_widget(msg));
+        free_message(msg);
+    } else if (pending->echo_row) {
+        start_loading_messages(GTK_LIST_BOX(g_dm_messages_list), pending->conversation_id);
+    }
+
+    free_pending_post(pending);
+}
+
+void
+posting_send_dm(const gchar *conversation_id, const gchar *content)
+{
+    struct PendingPost *pending = g_new0(struct PendingPost, 1);
+    pending->conversation_id = g_strdup(conversation_id);
+    pending->content = g_strdup(content);
+
+    struct DirectMessage echo = {0};
+    echo.content = (gchar *)content;
+    echo.username = g_current_username;
+    echo.name = g_current_username;
+    echo.created_at = "sending…";
+    insert_echo(pending, GTK_LIST_BOX(g_dm_messages_list), create_message_widget(&echo), -1);
+    scroll_list_to_end(GTK_LIST_BOX(g_dm_messages_list));
+
+    gchar *url = g_strdup_printf(DM_SEND_MESSAGE_URL, conversation_id);
+    gchar *post_data = construct_dm_payload(content);
+    outbox_enqueue(url, "POST", post_data, NULL, OUTBOX_APPEND, on_dm_sent, pending);
+    g_free(post_data);
+    g_free(url);
+}
@@ -0,0 +1,28 @@
+#ifndef POSTING_H
+#define POSTING_H
+
+#include <gtk/gtk.h>
+
+// New posts, replies, quotes and DMs, sent through the outbox so the main
+// loop never waits for them. A greyed-out local echo is shown in the list
+// right away. It stays while the write waits for the network, is replaced
+// by the server's copy when the response arrives, and is removed if the
+// server rejects the write. Main thread only.
+
+/**
+ * Posts a tweet in the background.
+ * @param reply_to_id Tweet being replied to, or NULL.
+ * @param quote_id Tweet being quoted, or NULL.
+ * @param echo_list List to show the local echo in, or NULL for none.
+ * @param position Where the echo goes in @echo_list, -1 for the end.
+ */
+void posting_send_tweet(const gchar *content, const gchar *reply_to_id, const gchar *quote_id,
+                        GtkListBox *echo_list, gint position);
+
+/**
+ * Sends a DM in the background, echoed at the end of g_dm_messages_list.
+ * On failure the text is put back into g_dm_entry if it is still empty.
+ */
+void posting_send_dm(const gchar *conversation_id, const gchar *content);
+
+#endif // POSTING_H
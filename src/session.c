@@ -4,7 +4,7 @@
 #include "globals.h"
 
 gchar*
-get_config_path()
+get_config_file_path(const gchar *filename)
 {
     const gchar *config_dir = g_get_user_config_dir();
     gchar *app_dir = g_build_filename(config_dir, "tweeta-desktop", NULL);
@@ -13,11 +13,17 @@ get_config_path()
         g_warning("Failed to create config directory: %s", app_dir);
     }
 
-    gchar *config_path = g_build_filename(app_dir, "session.json", NULL);
+    gchar *config_path = g_build_filename(app_dir, filename, NULL);
     g_free(app_dir);
     return config_path;
 }
 
+gchar*
+get_config_path()
+{
+    return get_config_file_path("session.json");
+}
+
 void
 save_session(const gchar *token, const gchar *username, gboolean is_admin)
 {
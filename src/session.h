@@ -3,6 +3,11 @@
 
 #include <glib.h>
 
+/**
+ * @return Path of @filename in the application's config directory, which is
+ *         created if needed.
+ */
+gchar* get_config_file_path(const gchar *filename);
 gchar* get_config_path();
 void save_session(const gchar *token, const gchar *username, gboolean is_admin);
 void clear_session();
@@ -0,0 +1,306 @@
+#include <string.h>
+#include "sha256.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA256_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+static const guint32 round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+void
+sha256_compress(guint32 state[8], const guint8 block[SHA256_BLOCK_SIZE])
+{
+    guint32 w[64];
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((guint32)block[i * 4] << 24) | ((guint32)block[i * 4 + 1] << 16) |
+               ((guint32)block[i * 4 + 2] << 8) | (guint32)block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        guint32 s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        guint32 s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    guint32 a = state[0], b = state[1], c = state[2], d = state[3];
+    guint32 e = state[4], f = state[5], g = state[6], h = state[7];
+
+    // Eight rounds per iteration with the variables renamed instead of
+    // shifted, which saves six moves per round
+#define ROUND(a, b, c, d, e, f, g, h, i)                                         \
+    do {                                                                         \
+        guint32 t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) +              \
+                     ((e & f) ^ (~e & g)) + round_constants[i] + w[i];           \
+        guint32 t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) +                  \
+                     ((a & b) ^ (a & c) ^ (b & c));                              \
+        d += t1;                                                                 \
+        h = t1 + t2;                                                             \
+    } while (0)
+
+    for (int i = 0; i < 64; i += 8) {
+        ROUND(a, b, c, d, e, f, g, h, i);
+        ROUND(h, a, b, c, d, e, f, g, i + 1);
+        ROUND(g, h, a, b, c, d, e, f, i + 2);
+        ROUND(f, g, h, a, b, c, d, e, i + 3);
+        ROUND(e, f, g, h, a, b, c, d, i + 4);
+        ROUND(d, e, f, g, h, a, b, c, i + 5);
+        ROUND(c, d, e, f, g, h, a, b, i + 6);
+        ROUND(b, c, d, e, f, g, h, a, i + 7);
+    }
+#undef ROUND
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void
+sha256_init(struct Sha256 *ctx)
+{
+    static const guint32 initial_state[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    memcpy(ctx->state, initial_state, sizeof(initial_state));
+    ctx->length = 0;
+    ctx->block_len = 0;
+}
+
+void
+sha256_update(struct Sha256 *ctx, const void *data, gsize len)
+{
+    const guint8 *bytes = (const guint8 *)data;
+    ctx->length += len;
+
+    if (ctx->block_len > 0) {
+        gsize take = MIN(len, SHA256_BLOCK_SIZE - ctx->block_len);
+        memcpy(ctx->block + ctx->block_len, bytes, take);
+        ctx->block_len += take;
+        bytes += take;
+        len -= take;
+        if (ctx->block_len < SHA256_BLOCK_SIZE) return;
+        sha256_compress(ctx->state, ctx->block);
+        ctx->block_len = 0;
+    }
+
+    while (len >= SHA256_BLOCK_SIZE) {
+        sha256_compress(ctx->state, bytes);
+        bytes += SHA256_BLOCK_SIZE;
+        len -= SHA256_BLOCK_SIZE;
+    }
+
+    memcpy(ctx->block, bytes, len);
+    ctx->block_len = len;
+}
+
+void
+sha256_final(struct Sha256 *ctx, guint8 digest[SHA256_DIGEST_SIZE])
+{
+    guint64 bit_length = ctx->length * 8;
+
+    ctx->block[ctx->block_len++] = 0x80;
+    if (ctx->block_len > SHA256_BLOCK_SIZE - 8) {
+        memset(ctx->block + ctx->block_len, 0, SHA256_BLOCK_SIZE - ctx->block_len);
+        sha256_compress(ctx->state, ctx->block);
+        ctx->block_len = 0;
+    }
+    memset(ctx->block + ctx->block_len, 0, SHA256_BLOCK_SIZE - 8 - ctx->block_len);
+    for (int i = 0; i < 8; i++) {
+        ctx->block[SHA256_BLOCK_SIZE - 1 - i] = (guint8)(bit_length >> (8 * i));
+    }
+    sha256_compress(ctx->state, ctx->block);
+
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = (guint8)(ctx->state[i] >> 24);
+        digest[i * 4 + 1] = (guint8)(ctx->state[i] >> 16);
+        digest[i * 4 + 2] = (guint8)(ctx->state[i] >> 8);
+        digest[i * 4 + 3] = (guint8)ctx->state[i];
+    }
+}
+
+static void
+compress_scalar(guint32 (*states)[8], const guint8 *const *blocks)
+{
+    sha256_compress(states[0], blocks[0]);
+}
+
+#ifdef SHA256_X86_KERNELS
+
+#define LANES_FUNC compress_sse2
+#define LANES_VEC Sha256VecSse2
+#define LANES_COUNT 4
+#define LANES_TARGET "sse2"
+#include "sha256_lanes.h"
+
+#define LANES_FUNC compress_avx2
+#define LANES_VEC Sha256VecAvx2
+#define LANES_COUNT 8
+#define LANES_TARGET "avx2"
+#include "sha256_lanes.h"
+
+#define LANES_FUNC compress_avx512
+#define LANES_VEC Sha256VecAvx512
+#define LANES_COUNT 16
+#define LANES_TARGET "avx512f"
+#include "sha256_lanes.h"
+
+// SHA extensions: two rounds per instruction on a single block. The state
+// is kept as ABEF/CDGH register pairs, which is what sha256rnds2 expects.
+static __attribute__((target("sha,sse4.1"))) void
+compress_shani(guint32 (*states)[8], const guint8 *const *blocks)
+{
+    guint32 *state = states[0];
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i m[4];
+
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    __m128i abef_save = state0;
+    __m128i cdgh_save = state1;
+
+    for (int i = 0; i < 4; i++) {
+        m[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(blocks[0] + i * 16)), byte_swap);
+    }
+
+    // Four rounds per iteration. m[] holds the last 16 schedule words; the
+    // group used now is replaced by the one needed four iterations later.
+    for (int g = 0; g < 16; g++) {
+        __m128i msg = _mm_add_epi32(m[g & 3], _mm_loadu_si128((const __m128i *)&round_constants[g * 4]));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+
+        if (g < 12) {
+            __m128i next = _mm_sha256msg1_epu32(m[g & 3], m[(g + 1) & 3]);
+            next = _mm_add_epi32(next, _mm_alignr_epi8(m[(g + 3) & 3], m[(g + 2) & 3], 4));
+            m[g & 3] = _mm_sha256msg2_epu32(next, m[(g + 3) & 3]);
+        }
+    }
+
+    state0 = _mm_add_epi32(state0, abef_save);
+    state1 = _mm_add_epi32(state1, cdgh_save);
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, state1, 0xF0));
+    _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+#endif // SHA256_X86_KERNELS
+
+static const struct Sha256Kernel all_kernels[] = {
+#ifdef SHA256_X86_KERNELS
+    { "avx512", 16, compress_avx512 },
+    { "avx2", 8, compress_avx2 },
+    { "sha-ni", 1, compress_shani },
+    { "sse2", 4, compress_sse2 },
+#endif
+    { "scalar", 1, compress_scalar },
+};
+
+static gboolean
+kernel_supported(const struct Sha256Kernel *kernel)
+{
+#ifdef SHA256_X86_KERNELS
+    __builtin_cpu_init();
+    if (kernel->compress == compress_avx512) return __builtin_cpu_supports("avx512f");
+    if (kernel->compress == compress_avx2) return __builtin_cpu_supports("avx2");
+    if (kernel->compress == compress_shani) {
+        return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+    }
+    if (kernel->compress == compress_sse2) return __builtin_cpu_supports("sse2");
+#endif
+    return kernel->compress == compress_scalar;
+}
+
+const struct Sha256Kernel*
+sha256_get_supported_kernels(guint *n_kernels)
+{
+    static struct Sha256Kernel supported[G_N_ELEMENTS(all_kernels)];
+    static gsize count = 0;
+
+    if (g_once_init_enter(&count)) {
+        gsize found = 0;
+        for (gsize i = 0; i < G_N_ELEMENTS(all_kernels); i++) {
+            if (kernel_supported(&all_kernels[i])) {
+                supported[found++] = all_kernels[i];
+            }
+        }
+        g_once_init_leave(&count, found);
+    }
+
+    *n_kernels = (guint)count;
+    return supported;
+}
+
+// Blocks hashed per kernel while picking the fastest one
+#define CALIBRATION_BLOCKS 4096
+
+static gdouble
+measure_kernel(const struct Sha256Kernel *kernel)
+{
+    guint32 states[SHA256_MAX_LANES][8];
+    guint8 block[SHA256_BLOCK_SIZE];
+    const guint8 *blocks[SHA256_MAX_LANES];
+
+    memset(states, 0, sizeof(states));
+    memset(block, 0x5a, sizeof(block));
+    for (guint i = 0; i < SHA256_MAX_LANES; i++) {
+        blocks[i] = block;
+    }
+
+    gint64 started = g_get_monotonic_time();
+    for (guint done = 0; done < CALIBRATION_BLOCKS; done += kernel->lanes) {
+        kernel->compress(states, blocks);
+    }
+    gint64 elapsed = MAX(g_get_monotonic_time() - started, 1);
+
+    return (gdouble)CALIBRATION_BLOCKS / elapsed;
+}
+
+const struct Sha256Kernel*
+sha256_get_kernel(void)
+{
+    static gsize best = 0;  // Index of the chosen kernel plus one
+    guint n_kernels;
+    const struct Sha256Kernel *kernels = sha256_get_supported_kernels(&n_kernels);
+
+    if (g_once_init_enter(&best)) {
+        guint fastest = 0;
+        gdouble fastest_rate = 0;
+
+        for (guint i = 0; i < n_kernels; i++) {
+            measure_kernel(&kernels[i]);  // Warm up caches and clocks
+            gdouble rate = measure_kernel(&kernels[i]);
+            g_debug("SHA-256 kernel %s: %.0f blocks/ms", kernels[i].name, rate * 1000);
+            if (rate > fastest_rate) {
+                fastest = i;
+                fastest_rate = rate;
+            }
+        }
+
+        g_debug("Using SHA-256 kernel %s", kernels[fastest].name);
+        g_once_init_leave(&best, fastest + 1);
+    }
+
+    return &kernels[best - 1];
+}
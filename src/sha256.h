@@ -0,0 +1,56 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <glib.h>
+
+#define SHA256_BLOCK_SIZE 64
+#define SHA256_DIGEST_SIZE 32
+
+// Plain SHA-256 (FIPS 180-4) with no heap use, so a context can be copied
+// by value. The Cap solver hashes its constant salt once and copies that
+// midstate for every nonce instead of rehashing the salt.
+struct Sha256 {
+    guint32 state[8];
+    guint64 length;                   // Bytes absorbed so far
+    guint8 block[SHA256_BLOCK_SIZE];  // Pending input, block_len bytes used
+    gsize block_len;
+};
+
+void sha256_init(struct Sha256 *ctx);
+void sha256_update(struct Sha256 *ctx, const void *data, gsize len);
+
+/**
+ * Pads and writes the digest. @ctx must be re-initialized (or overwritten
+ * with a saved midstate) before it is used again.
+ */
+void sha256_final(struct Sha256 *ctx, guint8 digest[SHA256_DIGEST_SIZE]);
+
+/**
+ * Processes one 64-byte block into @state.
+ */
+void sha256_compress(guint32 state[8], const guint8 block[SHA256_BLOCK_SIZE]);
+
+#define SHA256_MAX_LANES 16
+
+// A compression function that processes one block for each of @lanes
+// independent states at once (SIMD lanes), or a single block for the
+// one-lane kernels.
+struct Sha256Kernel {
+    const gchar *name;
+    guint lanes;
+    void (*compress)(guint32 (*states)[8], const guint8 *const *blocks);
+};
+
+/**
+ * Kernels usable on this CPU, always including the portable "scalar" one.
+ * @param n_kernels Set to the number of kernels returned.
+ */
+const struct Sha256Kernel *sha256_get_supported_kernels(guint *n_kernels);
+
+/**
+ * The kernel with the highest throughput on this CPU. Chosen once, on the
+ * first call, by timing every supported kernel for a few milliseconds.
+ */
+const struct Sha256Kernel *sha256_get_kernel(void);
+
+#endif // SHA256_H
@@ -0,0 +1,74 @@
+// Template for a multi-buffer compression function, included by sha256.c
+// once per instruction set. Each element of a GCC vector holds one lane, so
+// LANES_COUNT independent blocks are compressed with the same instructions.
+//
+// Define before including:
+//   LANES_FUNC    name of the function to generate
+//   LANES_VEC     name of the vector type to generate
+//   LANES_COUNT   number of 32-bit lanes in the vector
+//   LANES_TARGET  target attribute string, e.g. "avx2"
+
+typedef guint32 LANES_VEC __attribute__((vector_size(LANES_COUNT * 4)));
+
+static __attribute__((target(LANES_TARGET))) void
+LANES_FUNC(guint32 (*states)[8], const guint8 *const *blocks)
+{
+    LANES_VEC w[16];
+    LANES_VEC s[8];
+
+    for (int j = 0; j < LANES_COUNT; j++) {
+        for (int i = 0; i < 16; i++) {
+            const guint8 *p = blocks[j] + i * 4;
+            w[i][j] = ((guint32)p[0] << 24) | ((guint32)p[1] << 16) | ((guint32)p[2] << 8) | (guint32)p[3];
+        }
+        for (int i = 0; i < 8; i++) {
+            s[i][j] = states[j][i];
+        }
+    }
+
+    LANES_VEC a = s[0], b = s[1], c = s[2], d = s[3];
+    LANES_VEC e = s[4], f = s[5], g = s[6], h = s[7];
+
+    for (int i = 0; i < 64; i++) {
+        // The schedule only ever needs the last 16 words
+        if (i >= 16) {
+            LANES_VEC w15 = w[(i - 15) & 15];
+            LANES_VEC w2 = w[(i - 2) & 15];
+            w[i & 15] += (ROTR(w15, 7) ^ ROTR(w15, 18) ^ (w15 >> 3)) + w[(i - 7) & 15] +
+                         (ROTR(w2, 17) ^ ROTR(w2, 19) ^ (w2 >> 10));
+        }
+
+        LANES_VEC t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) +
+                       round_constants[i] + w[i & 15];
+        LANES_VEC t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    s[0] += a;
+    s[1] += b;
+    s[2] += c;
+    s[3] += d;
+    s[4] += e;
+    s[5] += f;
+    s[6] += g;
+    s[7] += h;
+
+    for (int j = 0; j < LANES_COUNT; j++) {
+        for (int i = 0; i < 8; i++) {
+            states[j][i] = s[i][j];
+        }
+    }
+}
+
+#undef LANES_FUNC
+#undef LANES_VEC
+#undef LANES_COUNT
+#undef LANES_TARGET
@@ -0,0 +1,61 @@
+#include <string.h>
+#include "string_intern.h"
+#include "memory_pool.h"
+
+// Keys are the interned strings themselves, which live in intern_arena
+static GHashTable *intern_table;
+static struct MemoryArena intern_arena;
+static struct StringInternStats intern_stats;
+static GMutex intern_mutex;     // Guards everything above
+
+const gchar*
+string_intern(const gchar *str)
+{
+    if (!str) return NULL;
+
+    g_mutex_lock(&intern_mutex);
+    if (!intern_table) {
+        intern_table = g_hash_table_new(g_str_hash, g_str_equal);
+        memory_arena_init(&intern_arena);
+    }
+
+    intern_stats.lookups++;
+    const gchar *interned = g_hash_table_lookup(intern_table, str);
+    if (interned) {
+        intern_stats.hits++;
+    } else {
+        gsize length = strlen(str);
+        interned = memory_arena_strndup(&intern_arena, str, length);
+        g_hash_table_add(intern_table, (gpointer)interned);
+        intern_stats.strings++;
+        intern_stats.bytes += length + 1;
+    }
+    g_mutex_unlock(&intern_mutex);
+
+    return interned;
+}
+
+const gchar*
+string_intern_len(const gchar *str, gsize length)
+{
+    // Names and URLs fit on the stack, so a lookup that hits allocates nothing
+    gchar buffer[256];
+    gchar *key = length < sizeof(buffer) ? buffer : g_malloc(length + 1);
+
+    memcpy(key, str, length);
+    key[length] = '\0';
+    const gchar *interned = string_intern(key);
+
+    if (key != buffer) {
+        g_free(key);
+    }
+    return interned;
+}
+
+void
+string_intern_get_stats(struct StringInternStats *stats)
+{
+    g_mutex_lock(&intern_mutex);
+    *stats = intern_stats;
+    g_mutex_unlock(&intern_mutex);
+}
@@ -0,0 +1,35 @@
+#ifndef STRING_INTERN_H
+#define STRING_INTERN_H
+
+#include <glib.h>
+
+// Process-wide table of the strings that repeat across responses: author
+// names, usernames and avatar URLs. Each distinct value is stored once, so two
+// interned strings are equal exactly when their pointers are. Interned strings
+// are never freed and must not be modified.
+
+struct StringInternStats {
+    guint strings;      // Distinct strings stored
+    gsize bytes;        // Their size, NUL terminators included
+    guint64 lookups;
+    guint64 hits;       // Lookups that found the string already stored
+};
+
+/**
+ * Safe to call from any thread.
+ * @return The canonical copy of @str, or NULL if @str is NULL.
+ */
+const gchar* string_intern(const gchar *str);
+
+/**
+ * Like string_intern() for the first @length bytes of @str, which need not be
+ * NUL-terminated.
+ */
+const gchar* string_intern_len(const gchar *str, gsize length);
+
+/**
+ * Copies the counters of the table into @stats.
+ */
+void string_intern_get_stats(struct StringInternStats *stats);
+
+#endif // STRING_INTERN_H
@@ -13,9 +13,9 @@ struct Attachment {
 // Represents a single tweet
 struct Tweet {
   gchar *content;
-  gchar *author_name;
-  gchar *author_username;
-  gchar *author_avatar;
+  const gchar *author_name;      // Author fields are interned, see string_intern.h
+  const gchar *author_username;
+  const gchar *author_avatar;
   gchar *id;
   gchar *note;
   gchar *note_severity;
@@ -98,16 +98,33 @@ struct AdminStats {
 struct MemoryStruct {
   char *memory;
   size_t size;
+  size_t capacity; // Allocated bytes, managed by memory_pool.c
 };
 
-// Data to pass between threads
+// Bump allocator for data that is freed all at once, managed by memory_pool.c
+struct MemoryArena {
+  char *block;     // Current block, linked to the ones before it
+  gsize used;
+  gsize capacity;
+};
+
+// A parsed page of posts. The tweets, their strings and attachments all live
+// in the page's arena, so dropping the last reference frees the whole page at
+// once.
+struct TweetPage {
+  gint ref_count;
+  GPtrArray *tweets;       // struct Tweet*, in display order; never NULL
+  struct MemoryArena arena;
+};
+
+// Context carried through an asynchronous request to its completion callback
 struct AsyncData {
     GtkListBox *list_box;
-    GList *tweets;
-    GList *users;
-    GList *notifications;
-    GList *conversations;
-    GList *messages;
+    struct TweetPage *page;
+    GPtrArray *users;
+    GPtrArray *notifications;
+    GPtrArray *conversations;
+    GPtrArray *messages;
     gboolean success;
     struct Profile *profile;
     gchar *username;
@@ -120,8 +137,10 @@ struct AsyncData {
 
 struct AvatarData {
     GtkWidget *image;
-    gchar *url;
     int size;
+    GCancellable *cancellable;  // Cancelled when the image is destroyed
+    GBytes *body;               // Downloaded image, decoded on the executor
+    GdkPixbuf *pixbuf;          // Decoded and scaled result
 };
 
 struct ReplyContext {
@@ -140,11 +159,22 @@ struct NoteContext {
     gchar *severity;
 };
 
+typedef enum {
+    INTERACTION_LIKE,
+    INTERACTION_RETWEET,
+    INTERACTION_BOOKMARK
+} InteractionKind;
+
+// Optimistic state of a like/retweet/bookmark button (interactions.c)
 struct InteractionData {
     gchar *tweet_id;
-    GtkWidget *button;
-    gboolean *state_ptr;
-    int *count_ptr;
+    GtkWidget *button;      // NULL once the button has been destroyed
+    InteractionKind kind;
+    gboolean state;         // What the button shows
+    gboolean confirmed;     // What the server last acknowledged
+    gboolean queued;        // What the server will have once the outbox is sent
+    guint pending;          // Requests in the outbox
+    guint debounce_id;      // Pending send, 0 if none
 };
 
 struct ReactionContext {
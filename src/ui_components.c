@@ -2,10 +2,12 @@
 #include "ui_components.h"
 #include "ui_utils.h"
 #include "json_utils.h"
-#include "network.h"
+#include "network_async.h"
 #include "constants.h"
 #include "globals.h"
 #include "actions.h"
+#include "interactions.h"
+#include "posting.h"
 
 static void
 on_like_clicked(GtkWidget *widget, gpointer user_data)
@@ -15,17 +17,7 @@ on_like_clicked(GtkWidget *widget, gpointer user_data)
         return;
     }
 
-    const gchar *tweet_id = g_object_get_data(G_OBJECT(widget), "tweet_id");
-    gboolean *liked = g_object_get_data(G_OBJECT(widget), "liked_state");
-
-    if (perform_like(tweet_id)) {
-        *liked = !(*liked);
-        if (*liked) {
-            gtk_button_set_label(GTK_BUTTON(widget), "♥ Liked");
-        } else {
-            gtk_button_set_label(GTK_BUTTON(widget), "♡ Like");
-        }
-    }
+    interaction_button_toggle(widget);
 }
 
 static void
@@ -36,17 +28,7 @@ on_retweet_clicked(GtkWidget *widget, gpointer user_data)
         return;
     }
 
-    const gchar *tweet_id = g_object_get_data(G_OBJECT(widget), "tweet_id");
-    gboolean *retweeted = g_object_get_data(G_OBJECT(widget), "retweeted_state");
-
-    if (perform_retweet(tweet_id)) {
-        *retweeted = !(*retweeted);
-        if (*retweeted) {
-            gtk_button_set_label(GTK_BUTTON(widget), "↻ Retweeted");
-        } else {
-            gtk_button_set_label(GTK_BUTTON(widget), "↻ Retweet");
-        }
-    }
+    interaction_button_toggle(widget);
 }
 
 static void
@@ -61,29 +43,7 @@ on_quote_response(GtkDialog *dialog, gint response_id, gpointer user_data)
         gchar *content = gtk_text_buffer_get_text(buffer, &start, &end, FALSE);
 
         if (content && strlen(content) > 0) {
-            JsonBuilder *builder = json_builder_new();
-            json_builder_begin_object(builder);
-            json_builder_set_member_name(builder, "content");
-            json_builder_add_string_value(builder, content);
-            json_builder_set_member_name(builder, "source");
-            json_builder_add_string_value(builder, "Tweeta Desktop");
-            json_builder_set_member_name(builder, "quote_tweet_id");
-            json_builder_add_string_value(builder, ctx->quote_id);
-            json_builder_end_object(builder);
-
-            JsonGenerator *gen = json_generator_new();
-            json_generator_set_root(gen, json_builder_get_root(builder));
-            gchar *post_data = json_generator_to_data(gen, NULL);
-
-            struct MemoryStruct chunk;
-            if (fetch_url(POST_TWEET_URL, &chunk, post_data, "POST")) {
-                start_loading_tweets(GTK_LIST_BOX(g_main_list_box));
-                free(chunk.memory);
-            }
-
-            g_free(post_data);
-            g_object_unref(gen);
-            g_object_unref(builder);
+            posting_send_tweet(content, NULL, ctx->quote_id, GTK_LIST_BOX(g_main_list_box), 0);
         }
         g_free(content);
     }
@@ -175,17 +135,7 @@ on_bookmark_clicked(GtkWidget *widget, gpointer user_data)
         return;
     }
 
-    const gchar *tweet_id = g_object_get_data(G_OBJECT(widget), "tweet_id");
-    gboolean *bookmarked = g_object_get_data(G_OBJECT(widget), "bookmarked_state");
-
-    if (perform_bookmark(tweet_id, !(*bookmarked))) {
-        *bookmarked = !(*bookmarked);
-        if (*bookmarked) {
-            gtk_button_set_label(GTK_BUTTON(widget), "★ Saved");
-        } else {
-            gtk_button_set_label(GTK_BUTTON(widget), "☆ Bookmark");
-        }
-    }
+    interaction_button_toggle(widget);
 }
 
 static void
@@ -206,12 +156,35 @@ on_emoji_selected(GtkFlowBoxChild *child, gpointer user_data)
     const gchar *emoji_name = g_object_get_data(G_OBJECT(child), "emoji_name");
 
     if (emoji_name && ctx && ctx->tweet_id) {
-        perform_reaction(ctx->tweet_id, emoji_name);
+        interaction_send_reaction(ctx->tweet_id, emoji_name);
     }
 
     gtk_widget_destroy(dialog);
 }
 
+static void
+on_emojis_fetched(GPtrArray *emojis, gpointer user_data)
+{
+    GtkWidget *flowbox = GTK_WIDGET(user_data);
+
+    // The picker may have been closed while the list was loading
+    for (guint i = 0; emojis && gtk_widget_get_parent(flowbox) && i < emojis->len; i++) {
+        struct Emoji *emoji = g_ptr_array_index(emojis, i);
+        GtkWidget *emoji_image = gtk_image_new();
+        load_image(emoji_image, emoji->file_url, 24);
+
+        GtkWidget *child_widget = gtk_flow_box_child_new();
+        gtk_container_add(GTK_CONTAINER(child_widget), emoji_image);
+        g_object_set_data_full(G_OBJECT(child_widget), "emoji_name", g_strdup(emoji->name), g_free);
+        gtk_widget_set_tooltip_text(child_widget, emoji->name);
+        gtk_container_add(GTK_CONTAINER(flowbox), child_widget);
+        gtk_widget_show_all(child_widget);
+    }
+
+    free_emojis(emojis);
+    g_object_unref(flowbox);
+}
+
 static void
 on_reaction_clicked(GtkWidget *widget, gpointer user_data)
 {
@@ -280,20 +253,8 @@ on_reaction_clicked(GtkWidget *widget, gpointer user_data)
         gtk_container_add(GTK_CONTAINER(flowbox), child_widget);
     }
 
-    GList *emojis = fetch_emojis();
-    for (GList *l = emojis; l != NULL; l = l->next) {
-        struct Emoji *emoji = l->data;
-        GtkWidget *emoji_image = gtk_image_new();
-        load_avatar(emoji_image, emoji->file_url, 24);
-
-        GtkWidget *child_widget = gtk_flow_box_child_new();
-        gtk_container_add(GTK_CONTAINER(child_widget), emoji_image);
-        g_object_set_data_full(G_OBJECT(child_widget), "emoji_name", g_strdup(emoji->name), g_free);
-        gtk_widget_set_tooltip_text(child_widget, emoji->name);
-        gtk_container_add(GTK_CONTAINER(flowbox), child_widget);
-    }
-
-    free_emojis(emojis);
+    // The custom emojis are appended once they arrive
+    fetch_emojis(on_emojis_fetched, g_object_ref(flowbox));
 
     g_signal_connect(flowbox, "child-activated", G_CALLBACK(on_emoji_selected), dialog);
 
@@ -304,22 +265,6 @@ on_reaction_clicked(GtkWidget *widget, gpointer user_data)
     g_signal_connect_swapped(dialog, "response", G_CALLBACK(gtk_widget_destroy), dialog);
 }
 
-static gboolean
-perform_post_tweet(const gchar *content, const gchar *reply_to_id)
-{
-    struct MemoryStruct chunk;
-    gboolean success = FALSE;
-    gchar *post_data = construct_tweet_payload(content, reply_to_id);
-
-    if (fetch_url(POST_TWEET_URL, &chunk, post_data, "POST")) {
-        success = TRUE;
-        free(chunk.memory);
-    }
-    
-    g_free(post_data);
-    return success;
-}
-
 static void
 on_reply_response(GtkDialog *dialog, gint response_id, gpointer user_data)
 {
@@ -332,22 +277,12 @@ on_reply_response(GtkDialog *dialog, gint response_id, gpointer user_data)
         gchar *content = gtk_text_buffer_get_text(buffer, &start, &end, FALSE);
 
         if (content && strlen(content) > 0) {
-             if (perform_post_tweet(content, ctx->reply_to_id)) {
-                const gchar *current_view = gtk_stack_get_visible_child_name(GTK_STACK(g_stack));
-                if (g_strcmp0(current_view, "conversation") == 0 && ctx->reply_to_id) {
-                    show_tweet(ctx->reply_to_id);
-                } else {
-                    start_loading_tweets(GTK_LIST_BOX(g_main_list_box));
-                }
-             } else {
-                GtkWidget *error_dialog = gtk_message_dialog_new(GTK_WINDOW(dialog),
-                                         GTK_DIALOG_DESTROY_WITH_PARENT,
-                                         GTK_MESSAGE_ERROR,
-                                         GTK_BUTTONS_CLOSE,
-                                         "Failed to post reply.");
-                gtk_dialog_run(GTK_DIALOG(error_dialog));
-                gtk_widget_destroy(error_dialog);
-             }
+            const gchar *current_view = gtk_stack_get_visible_child_name(GTK_STACK(g_stack));
+            if (g_strcmp0(current_view, "conversation") == 0 && ctx->reply_to_id) {
+                posting_send_tweet(content, ctx->reply_to_id, NULL, GTK_LIST_BOX(g_conversation_list), -1);
+            } else {
+                posting_send_tweet(content, ctx->reply_to_id, NULL, GTK_LIST_BOX(g_main_list_box), 0);
+            }
         }
         g_free(content);
     }
@@ -431,7 +366,7 @@ add_attachments_to_box(GtkBox *box, GList *attachments)
         struct Attachment *attach = l->data;
         if (attach->file_type && g_str_has_prefix(attach->file_type, "image/")) {
             GtkWidget *image = gtk_image_new();
-            load_avatar(image, attach->file_url, MEDIA_SIZE);
+            load_image(image, attach->file_url, MEDIA_SIZE);
             gtk_box_pack_start(box, image, FALSE, FALSE, 5);
         } else if (attach->file_type && g_str_has_prefix(attach->file_type, "video/")) {
             GtkWidget *video_btn = gtk_button_new_with_label("Play Video ▶");
@@ -567,12 +502,13 @@ create_tweet_widget_full(struct Tweet *tweet, const gchar *op_username)
     gtk_label_set_attributes(GTK_LABEL(label), attrs);
     pango_attr_list_unref(attrs);
 
-    g_object_set_data_full(G_OBJECT(author_btn), "username", g_strdup(tweet->author_username), g_free);
+    g_object_set_data(G_OBJECT(author_btn), "username", (gpointer)tweet->author_username);
     g_signal_connect(author_btn, "clicked", G_CALLBACK(on_author_clicked), NULL);
 
     gtk_box_pack_start(GTK_BOX(author_hbox), author_btn, FALSE, FALSE, 0);
 
-    if (op_username && g_strcmp0(tweet->author_username, op_username) == 0) {
+    // Both come from the intern table, so the pointers are equal if the names are
+    if (op_username && tweet->author_username == op_username) {
         GtkWidget *op_label = gtk_label_new("OP");
         GtkStyleContext *context = gtk_widget_get_style_context(op_label);
         gtk_style_context_add_class(context, "op-badge");
@@ -648,34 +584,28 @@ create_tweet_widget_full(struct Tweet *tweet, const gchar *op_username)
     gtk_widget_set_halign(button_box, GTK_ALIGN_START);
     gtk_container_set_border_width(GTK_CONTAINER(button_box), 5);
 
-    gboolean *liked_state = g_new(gboolean, 1);
-    *liked_state = tweet->liked;
-    GtkWidget *like_btn = gtk_button_new_with_label(tweet->liked ? "♥ Liked" : "♡ Like");
+    GtkWidget *like_btn = gtk_button_new();
     gtk_button_set_relief(GTK_BUTTON(like_btn), GTK_RELIEF_NONE);
     g_object_set_data_full(G_OBJECT(like_btn), "tweet_id", g_strdup(tweet->id), g_free);
-    g_object_set_data_full(G_OBJECT(like_btn), "liked_state", liked_state, g_free);
+    interaction_attach(like_btn, tweet->id, INTERACTION_LIKE, tweet->liked);
     g_signal_connect(like_btn, "clicked", G_CALLBACK(on_like_clicked), NULL);
 
-    gboolean *retweeted_state = g_new(gboolean, 1);
-    *retweeted_state = tweet->retweeted;
-    GtkWidget *retweet_btn = gtk_button_new_with_label(tweet->retweeted ? "↻ Retweeted" : "↻ Retweet");
+    GtkWidget *retweet_btn = gtk_button_new();
     gtk_button_set_relief(GTK_BUTTON(retweet_btn), GTK_RELIEF_NONE);
     g_object_set_data_full(G_OBJECT(retweet_btn), "tweet_id", g_strdup(tweet->id), g_free);
-    g_object_set_data_full(G_OBJECT(retweet_btn), "retweeted_state", retweeted_state, g_free);
+    interaction_attach(retweet_btn, tweet->id, INTERACTION_RETWEET, tweet->retweeted);
     g_signal_connect(retweet_btn, "clicked", G_CALLBACK(on_retweet_button_clicked), NULL);
 
     GtkWidget *reply_btn = gtk_button_new_with_label("↩ Reply");
     gtk_button_set_relief(GTK_BUTTON(reply_btn), GTK_RELIEF_NONE);
     g_object_set_data_full(G_OBJECT(reply_btn), "tweet_id", g_strdup(tweet->id), g_free);
-    g_object_set_data_full(G_OBJECT(reply_btn), "username", g_strdup(tweet->author_username), g_free);
+    g_object_set_data(G_OBJECT(reply_btn), "username", (gpointer)tweet->author_username);
     g_signal_connect(reply_btn, "clicked", G_CALLBACK(on_reply_clicked), NULL);
 
-    gboolean *bookmarked_state = g_new(gboolean, 1);
-    *bookmarked_state = tweet->bookmarked;
-    GtkWidget *bookmark_btn = gtk_button_new_with_label(tweet->bookmarked ? "★ Saved" : "☆ Bookmark");
+    GtkWidget *bookmark_btn = gtk_button_new();
     gtk_button_set_relief(GTK_BUTTON(bookmark_btn), GTK_RELIEF_NONE);
     g_object_set_data_full(G_OBJECT(bookmark_btn), "tweet_id", g_strdup(tweet->id), g_free);
-    g_object_set_data_full(G_OBJECT(bookmark_btn), "bookmarked_state", bookmarked_state, g_free);
+    interaction_attach(bookmark_btn, tweet->id, INTERACTION_BOOKMARK, tweet->bookmarked);
     g_signal_connect(bookmark_btn, "clicked", G_CALLBACK(on_bookmark_clicked), NULL);
 
     GtkWidget *reaction_btn = gtk_button_new_with_label("😀 React");
@@ -706,7 +636,7 @@ create_tweet_widget_full(struct Tweet *tweet, const gchar *op_username)
 }
 
 void
-populate_tweet_list(GtkListBox *list_box, GList *tweets)
+populate_tweet_list(GtkListBox *list_box, GPtrArray *tweets)
 {
     GList *children, *iter;
     children = gtk_container_get_children(GTK_CONTAINER(list_box));
@@ -714,8 +644,8 @@ populate_tweet_list(GtkListBox *list_box, GList *tweets)
         gtk_widget_destroy(GTK_WIDGET(iter->data));
     g_list_free(children);
 
-    for (GList *l = tweets; l != NULL; l = l->next) {
-        GtkWidget *tweet_widget = create_tweet_widget(l->data);
+    for (guint i = 0; tweets && i < tweets->len; i++) {
+        GtkWidget *tweet_widget = create_tweet_widget(g_ptr_array_index(tweets, i));
         gtk_widget_show_all(tweet_widget);
         gtk_list_box_insert(list_box, tweet_widget, -1);
     }
@@ -732,7 +662,7 @@ create_user_widget(struct Profile *user)
     GtkWidget *avatar_image = gtk_image_new_from_icon_name("avatar-default", GTK_ICON_SIZE_DIALOG);
     gtk_widget_set_size_request(avatar_image, AVATAR_SIZE, AVATAR_SIZE);
     gtk_widget_set_valign(avatar_image, GTK_ALIGN_START);
-    load_avatar(avatar_image, user->avatar, AVATAR_SIZE);
+    load_image(avatar_image, user->avatar, AVATAR_SIZE);
 
     gchar *user_str = g_strdup_printf("%s (@%s)", user->name, user->username);
 
@@ -777,7 +707,7 @@ create_user_widget(struct Profile *user)
 }
 
 void
-populate_user_list(GtkListBox *list_box, GList *users)
+populate_user_list(GtkListBox *list_box, GPtrArray *users)
 {
     GList *children, *iter;
     children = gtk_container_get_children(GTK_CONTAINER(list_box));
@@ -785,18 +715,18 @@ populate_user_list(GtkListBox *list_box, GList *users)
         gtk_widget_destroy(GTK_WIDGET(iter->data));
     g_list_free(children);
 
-    for (GList *l = users; l != NULL; l = l->next) {
-        GtkWidget *user_widget = create_user_widget(l->data);
+    for (guint i = 0; users && i < users->len; i++) {
+        GtkWidget *user_widget = create_user_widget(g_ptr_array_index(users, i));
         gtk_widget_show_all(user_widget);
         gtk_list_box_insert(list_box, user_widget, -1);
     }
 }
 
 void
-append_tweets_to_list(GtkListBox *list_box, GList *tweets)
+append_tweets_to_list(GtkListBox *list_box, GPtrArray *tweets)
 {
-    for (GList *l = tweets; l != NULL; l = l->next) {
-        GtkWidget *tweet_widget = create_tweet_widget(l->data);
+    for (guint i = 0; tweets && i < tweets->len; i++) {
+        GtkWidget *tweet_widget = create_tweet_widget(g_ptr_array_index(tweets, i));
         gtk_widget_show_all(tweet_widget);
         gtk_list_box_insert(list_box, tweet_widget, -1);
     }
@@ -841,7 +771,7 @@ create_notification_widget(struct Notification *notif)
     gtk_widget_set_size_request(avatar_image, 32, 32);
     gtk_widget_set_valign(avatar_image, GTK_ALIGN_START);
     if (notif->actor_avatar) {
-        load_avatar(avatar_image, notif->actor_avatar, 32);
+        load_image(avatar_image, notif->actor_avatar, 32);
     }
 
     GtkWidget *avatar_btn = gtk_button_new();
@@ -906,7 +836,7 @@ create_notification_widget(struct Notification *notif)
 }
 
 void
-populate_notification_list(GtkListBox *list_box, GList *notifications)
+populate_notification_list(GtkListBox *list_box, GPtrArray *notifications)
 {
     GList *children, *iter;
     children = gtk_container_get_children(GTK_CONTAINER(list_box));
@@ -914,8 +844,8 @@ populate_notification_list(GtkListBox *list_box, GList *notifications)
         gtk_widget_destroy(GTK_WIDGET(iter->data));
     g_list_free(children);
 
-    for (GList *l = notifications; l != NULL; l = l->next) {
-        GtkWidget *notif_widget = create_notification_widget(l->data);
+    for (guint i = 0; notifications && i < notifications->len; i++) {
+        GtkWidget *notif_widget = create_notification_widget(g_ptr_array_index(notifications, i));
         gtk_widget_show_all(notif_widget);
         gtk_list_box_insert(list_box, notif_widget, -1);
     }
@@ -934,12 +864,9 @@ on_conversation_clicked(GtkWidget *widget, gpointer user_data)
         g_object_set_data_full(G_OBJECT(g_dm_messages_list), "conversation_id", g_strdup(conv_id), g_free);
         start_loading_messages(GTK_LIST_BOX(g_dm_messages_list), conv_id);
 
-        // Mark as read
+        // Mark as read. Nothing waits for the answer.
         gchar *url = g_strdup_printf(DM_MARK_READ_URL, conv_id);
-        struct MemoryStruct chunk;
-        if (fetch_url(url, &chunk, "", "PATCH")) {
-            free(chunk.memory);
-        }
+        fetch_url_async(url, "", "PATCH", NULL, NULL);
         g_free(url);
     }
 }
@@ -954,7 +881,7 @@ create_conversation_widget(struct Conversation *conv)
     GtkWidget *avatar_image = gtk_image_new_from_icon_name("avatar-default", GTK_ICON_SIZE_DIALOG);
     gtk_widget_set_size_request(avatar_image, 48, 48);
     if (conv->display_avatar) {
-        load_avatar(avatar_image, conv->display_avatar, 48);
+        load_image(avatar_image, conv->display_avatar, 48);
     }
 
     GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 2);
@@ -997,7 +924,7 @@ create_conversation_widget(struct Conversation *conv)
 }
 
 void
-populate_conversation_list(GtkListBox *list_box, GList *conversations)
+populate_conversation_list(GtkListBox *list_box, GPtrArray *conversations)
 {
     GList *children, *iter;
     children = gtk_container_get_children(GTK_CONTAINER(list_box));
@@ -1005,8 +932,8 @@ populate_conversation_list(GtkListBox *list_box, GList *conversations)
         gtk_widget_destroy(GTK_WIDGET(iter->data));
     g_list_free(children);
 
-    for (GList *l = conversations; l != NULL; l = l->next) {
-        GtkWidget *conv_widget = create_conversation_widget(l->data);
+    for (guint i = 0; conversations && i < conversations->len; i++) {
+        GtkWidget *conv_widget = create_conversation_widget(g_ptr_array_index(conversations, i));
         gtk_widget_show_all(conv_widget);
         gtk_list_box_insert(list_box, conv_widget, -1);
     }
@@ -1023,7 +950,7 @@ create_message_widget(struct DirectMessage *msg)
     GtkWidget *avatar_image = gtk_image_new_from_icon_name("avatar-default", GTK_ICON_SIZE_MENU);
     gtk_widget_set_size_request(avatar_image, 32, 32);
     if (msg->avatar) {
-        load_avatar(avatar_image, msg->avatar, 32);
+        load_image(avatar_image, msg->avatar, 32);
     }
 
     gchar *header_text = g_strdup_printf("<b>%s</b> (@%s) · %s", msg->name, msg->username, msg->created_at);
@@ -1049,7 +976,20 @@ create_message_widget(struct DirectMessage *msg)
 }
 
 void
-populate_message_list(GtkListBox *list_box, GList *messages)
+scroll_list_to_end(GtkListBox *list_box)
+{
+    GtkWidget *scrolled = gtk_widget_get_parent(GTK_WIDGET(list_box));
+    if (GTK_IS_VIEWPORT(scrolled)) {
+        scrolled = gtk_widget_get_parent(scrolled);
+    }
+    if (GTK_IS_SCROLLED_WINDOW(scrolled)) {
+        GtkAdjustment *adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(scrolled));
+        gtk_adjustment_set_value(adj, gtk_adjustment_get_upper(adj) - gtk_adjustment_get_page_size(adj));
+    }
+}
+
+void
+populate_message_list(GtkListBox *list_box, GPtrArray *messages)
 {
     GList *children, *iter;
     children = gtk_container_get_children(GTK_CONTAINER(list_box));
@@ -1058,19 +998,11 @@ populate_message_list(GtkListBox *list_box, GList *messages)
     g_list_free(children);
 
     // Messages come in descending order from API, we want to show them in order
-    for (GList *l = g_list_last(messages); l != NULL; l = l->prev) {
-        GtkWidget *msg_widget = create_message_widget(l->data);
+    for (guint i = messages ? messages->len : 0; i > 0; i--) {
+        GtkWidget *msg_widget = create_message_widget(g_ptr_array_index(messages, i - 1));
         gtk_widget_show_all(msg_widget);
         gtk_list_box_insert(list_box, msg_widget, -1);
     }
     
-    // Scroll to bottom
-    GtkWidget *scrolled = gtk_widget_get_parent(GTK_WIDGET(list_box));
-    if (GTK_IS_VIEWPORT(scrolled)) {
-        scrolled = gtk_widget_get_parent(scrolled);
-    }
-    if (GTK_IS_SCROLLED_WINDOW(scrolled)) {
-        GtkAdjustment *adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(scrolled));
-        gtk_adjustment_set_value(adj, gtk_adjustment_get_upper(adj) - gtk_adjustment_get_page_size(adj));
-    }
+    scroll_list_to_end(list_box);
 }
@@ -5,17 +5,22 @@
 #include "types.h"
 
 GtkWidget* create_tweet_widget(struct Tweet *tweet);
+/**
+ * @param op_username Interned username of the thread's author, whose posts get
+ *        an OP badge, or NULL.
+ */
 GtkWidget* create_tweet_widget_full(struct Tweet *tweet, const gchar *op_username);
-void populate_tweet_list(GtkListBox *list_box, GList *tweets);
-void append_tweets_to_list(GtkListBox *list_box, GList *tweets);
+void populate_tweet_list(GtkListBox *list_box, GPtrArray *tweets);
+void append_tweets_to_list(GtkListBox *list_box, GPtrArray *tweets);
 GtkWidget* create_user_widget(struct Profile *user);
-void populate_user_list(GtkListBox *list_box, GList *users);
+void populate_user_list(GtkListBox *list_box, GPtrArray *users);
 GtkWidget* create_notification_widget(struct Notification *notif);
-void populate_notification_list(GtkListBox *list_box, GList *notifications);
+void populate_notification_list(GtkListBox *list_box, GPtrArray *notifications);
 
 GtkWidget* create_conversation_widget(struct Conversation *conv);
-void populate_conversation_list(GtkListBox *list_box, GList *conversations);
+void populate_conversation_list(GtkListBox *list_box, GPtrArray *conversations);
 GtkWidget* create_message_widget(struct DirectMessage *msg);
-void populate_message_list(GtkListBox *list_box, GList *messages);
+void populate_message_list(GtkListBox *list_box, GPtrArray *messages);
+void scroll_list_to_end(GtkListBox *list_box);
 
 #endif // UI_COMPONENTS_H
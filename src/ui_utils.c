@@ -1,71 +1,148 @@
 #include <stdlib.h>
 #include "ui_utils.h"
 #include "network.h"
+#include "network_async.h"
 #include "constants.h"
+#include "executor.h"
 #include "globals.h"
+#include "string_intern.h"
 
-static gboolean
-set_image_pixbuf(gpointer data)
+static void
+free_avatar_data(struct AvatarData *avatar_data)
 {
-    GdkPixbuf *pixbuf = (GdkPixbuf *)((gpointer *)data)[0];
-    GtkWidget *image = (GtkWidget *)((gpointer *)data)[1];
-
-    if (GTK_IS_IMAGE(image)) {
-        gtk_image_set_from_pixbuf(GTK_IMAGE(image), pixbuf);
+    if (avatar_data->image) {
+        g_object_remove_weak_pointer(G_OBJECT(avatar_data->image), (gpointer *)&avatar_data->image);
     }
-
-    g_object_unref(pixbuf);
-    if (G_IS_OBJECT(image)) {
-        g_object_unref(image);
+    if (avatar_data->body) {
+        g_bytes_unref(avatar_data->body);
     }
-    g_free(data);
-    return G_SOURCE_REMOVE;
+    if (avatar_data->pixbuf) {
+        g_object_unref(avatar_data->pixbuf);
+    }
+    g_object_unref(avatar_data->cancellable);
+    g_free(avatar_data);
 }
 
-static gpointer
-fetch_avatar_thread(gpointer data)
+// Runs on the executor's CPU lane and only touches body, size and pixbuf
+static void
+decode_avatar(gpointer data)
 {
     struct AvatarData *avatar_data = (struct AvatarData *)data;
-    struct MemoryStruct chunk;
-    
-    gchar *full_url;
-    if (g_str_has_prefix(avatar_data->url, "http")) {
-        full_url = g_strdup(avatar_data->url);
-    } else {
-        full_url = g_strdup_printf("%s%s", BASE_DOMAIN, avatar_data->url);
+    GInputStream *stream = g_memory_input_stream_new_from_bytes(avatar_data->body);
+
+    avatar_data->pixbuf = gdk_pixbuf_new_from_stream_at_scale(stream, avatar_data->size, avatar_data->size,
+                                                              TRUE, NULL, NULL);
+    g_object_unref(stream);
+}
+
+static void
+on_avatar_decoded(gpointer data)
+{
+    struct AvatarData *avatar_data = (struct AvatarData *)data;
+
+    // The image may have been destroyed while the download or the decode
+    // was in flight, in which case the weak pointer has been cleared.
+    if (avatar_data->pixbuf && avatar_data->image) {
+        gtk_image_set_from_pixbuf(GTK_IMAGE(avatar_data->image), avatar_data->pixbuf);
     }
+    free_avatar_data(avatar_data);
+}
+
+static void
+on_avatar_fetched(struct MemoryStruct *chunk, long response_code, gpointer data)
+{
+    (void)response_code;
+    struct AvatarData *avatar_data = (struct AvatarData *)data;
 
-    if (fetch_url(full_url, &chunk, NULL, "GET")) {
-        GInputStream *stream = g_memory_input_stream_new_from_data(chunk.memory, chunk.size, NULL);
-        GdkPixbuf *pixbuf = gdk_pixbuf_new_from_stream_at_scale(stream, avatar_data->size, avatar_data->size, TRUE, NULL, NULL);
-        
-        if (pixbuf) {
-            gpointer *params = g_new(gpointer, 2);
-            params[0] = pixbuf; // Already has ref from creation
-            params[1] = G_IS_OBJECT(avatar_data->image) ? g_object_ref(avatar_data->image) : NULL;
-            g_idle_add(set_image_pixbuf, params);
-        }
-        g_object_unref(stream);
-        free(chunk.memory);
+    if (chunk && avatar_data->image) {
+        // Decoding and scaling is the expensive part, keep it off the main loop
+        avatar_data->body = g_bytes_new(chunk->memory, chunk->size);
+        executor_submit_full(EXECUTOR_LANE_CPU, decode_avatar, on_avatar_decoded, avatar_data);
+        return;
     }
+    free_avatar_data(avatar_data);
+}
 
-    g_free(full_url);
-    g_free(avatar_data->url);
-    g_free(avatar_data);
-    return NULL;
+static void
+on_avatar_mapped(GtkWidget *image, gpointer user_data)
+{
+    (void)image;
+    network_async_set_priority((const gchar *)user_data, REQUEST_PRIORITY_MEDIA);
 }
 
-void
-load_avatar(GtkWidget *image, const gchar *url, int size)
+static void
+free_mapped_url(gpointer data, GClosure *closure)
+{
+    (void)closure;
+    g_free(data);
+}
+
+// Absolute form of an image URL from the API, newly allocated
+static gchar*
+absolute_image_url(const gchar *url)
+{
+    return g_str_has_prefix(url, "http") ? g_strdup(url) : g_strconcat(BASE_DOMAIN, url, NULL);
+}
+
+// Absolute form of a post author's avatar URL. The same few avatars appear on
+// every row, so it is interned and callers can hold it without a copy.
+static const gchar*
+resolve_avatar_url(const gchar *url)
+{
+    if (g_str_has_prefix(url, "http")) return string_intern(url);
+
+    gchar *joined = g_strconcat(BASE_DOMAIN, url, NULL);
+    const gchar *full_url = string_intern(joined);
+    g_free(joined);
+    return full_url;
+}
+
+// Only author avatars are interned. Attachments are unique per post and the
+// other images are not shown often enough to be worth keeping forever.
+static void
+load_image_full(GtkWidget *image, const gchar *url, int size, gboolean author_avatar)
 {
     if (!url || strlen(url) == 0) return;
 
     struct AvatarData *data = g_new(struct AvatarData, 1);
     data->image = image;
-    data->url = g_strdup(url);
     data->size = size;
+    data->body = NULL;
+    data->pixbuf = NULL;
+    data->cancellable = g_cancellable_new();
+    g_object_add_weak_pointer(G_OBJECT(image), (gpointer *)&data->image);
+    // Rows scrolled away or replaced by a refresh abort their downloads. The
+    // handler goes away by itself once the cancellable is finalized.
+    g_signal_connect_object(image, "destroy", G_CALLBACK(g_cancellable_cancel),
+                            data->cancellable, G_CONNECT_SWAPPED);
 
-    g_thread_new("avatar-loader", fetch_avatar_thread, data);
+    gchar *owned_url = author_avatar ? NULL : absolute_image_url(url);
+    const gchar *full_url = author_avatar ? resolve_avatar_url(url) : owned_url;
+
+    // Images built for rows that are not on screen yet only get prefetch
+    // priority until they are mapped
+    RequestPriority priority = gtk_widget_get_mapped(image) ? REQUEST_PRIORITY_MEDIA : REQUEST_PRIORITY_PREFETCH;
+    if (priority == REQUEST_PRIORITY_PREFETCH && author_avatar) {
+        g_signal_connect(image, "map", G_CALLBACK(on_avatar_mapped), (gpointer)full_url);
+    } else if (priority == REQUEST_PRIORITY_PREFETCH) {
+        g_signal_connect_data(image, "map", G_CALLBACK(on_avatar_mapped), g_strdup(full_url),
+                              free_mapped_url, 0);
+    }
+
+    fetch_url_async_full(full_url, NULL, "GET", priority, data->cancellable, on_avatar_fetched, data);
+    g_free(owned_url);
+}
+
+void
+load_avatar(GtkWidget *image, const gchar *url, int size)
+{
+    load_image_full(image, url, size, TRUE);
+}
+
+void
+load_image(GtkWidget *image, const gchar *url, int size)
+{
+    load_image_full(image, url, size, FALSE);
 }
 
 void
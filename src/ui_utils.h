@@ -3,7 +3,16 @@
 
 #include <gtk/gtk.h>
 
+/**
+ * Downloads a post author's avatar into @image, scaled to @size. The URL is
+ * interned, like the author fields of struct Tweet.
+ */
 void load_avatar(GtkWidget *image, const gchar *url, int size);
+/**
+ * Like load_avatar() for any other image (attachments, emojis, avatars in
+ * user, notification and message lists), without interning its URL.
+ */
+void load_image(GtkWidget *image, const gchar *url, int size);
 void on_author_clicked(GtkButton *button, gpointer user_data);
 void show_profile(const gchar *username);
 
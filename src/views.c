@@ -5,6 +5,12 @@
 #include "constants.h"
 #include "json_utils.h"
 #include "network.h"
+#include "memory_pool.h"
+#include "network_async.h"
+#include "network_stats.h"
+#include "executor.h"
+#include "outbox.h"
+#include "posting.h"
 
 GtkWidget*
 create_profile_view()
@@ -133,18 +139,8 @@ on_dm_send_clicked(GtkWidget *widget, gpointer user_data)
     const gchar *conv_id = g_object_get_data(G_OBJECT(g_dm_messages_list), "conversation_id");
 
     if (content && strlen(content) > 0 && conv_id) {
-        gchar *url = g_strdup_printf(DM_SEND_MESSAGE_URL, conv_id);
-        gchar *post_data = construct_dm_payload(content);
-        struct MemoryStruct chunk;
-
-        if (fetch_url(url, &chunk, post_data, "POST")) {
-            gtk_entry_set_text(GTK_ENTRY(g_dm_entry), "");
-            start_loading_messages(GTK_LIST_BOX(g_dm_messages_list), conv_id);
-            free(chunk.memory);
-        }
-        
-        g_free(post_data);
-        g_free(url);
+        posting_send_dm(conv_id, content);
+        gtk_entry_set_text(GTK_ENTRY(g_dm_entry), "");
     }
 }
 
@@ -196,6 +192,103 @@ create_dm_messages_view()
     return box;
 }
 
+static void
+on_max_streams_changed(GtkSpinButton *spin, gpointer user_data)
+{
+    (void)user_data;
+    network_async_set_max_streams(gtk_spin_button_get_value_as_int(spin));
+}
+
+static void
+refresh_network_stats(GtkTextView *text_view)
+{
+    GString *text = g_string_new(NULL);
+    GList *endpoints = network_stats_list_endpoints();
+
+    if (!endpoints) {
+        g_string_append(text, "No requests recorded yet.");
+    }
+
+    for (GList *l = endpoints; l != NULL; l = l->next) {
+        struct EndpointStats stats;
+        if (!network_stats_get((const gchar *)l->data, &stats)) continue;
+
+        g_string_append_printf(text, "%s  (%" G_GUINT64_FORMAT " requests, %" G_GUINT64_FORMAT " coalesced, %"
+                               G_GUINT64_FORMAT " KiB received)\n",
+                               (const gchar *)l->data, stats.requests, stats.coalesced, stats.wire_bytes / 1024);
+        for (int phase = 0; phase < NETWORK_PHASE_COUNT; phase++) {
+            const struct LatencyHistogram *histogram = &stats.phases[phase];
+            if (histogram->count == 0) continue;
+
+            g_string_append_printf(text, "    %-9s n=%-6" G_GUINT64_FORMAT " p50 %8.1f ms   p95 %8.1f ms   max %8.1f ms\n",
+                                   network_stats_phase_name(phase), histogram->count,
+                                   network_stats_histogram_percentile(histogram, 0.5) / 1000.0,
+                                   network_stats_histogram_percentile(histogram, 0.95) / 1000.0,
+                                   histogram->max_us / 1000.0);
+        }
+    }
+
+    for (int lane = 0; lane < EXECUTOR_LANE_COUNT; lane++) {
+        struct ExecutorStats stats;
+        executor_get_stats(lane, &stats);
+
+        g_string_append_printf(text, "\nexecutor %s  (%u workers, %u queued, %u running, max queue depth %u)\n",
+                               executor_lane_name(lane), stats.workers, stats.queued, stats.running,
+                               stats.max_queued);
+        const struct LatencyHistogram *histograms[] = { &stats.wait, &stats.run };
+        const gchar *names[] = { "wait", "run" };
+        for (int i = 0; i < 2; i++) {
+            if (histograms[i]->count == 0) continue;
+
+            g_string_append_printf(text, "    %-9s n=%-6" G_GUINT64_FORMAT " p50 %8.1f ms   p95 %8.1f ms   max %8.1f ms\n",
+                                   names[i], histograms[i]->count,
+                                   network_stats_histogram_percentile(histograms[i], 0.5) / 1000.0,
+                                   network_stats_histogram_percentile(histograms[i], 0.95) / 1000.0,
+                                   histograms[i]->max_us / 1000.0);
+        }
+    }
+
+    gtk_text_buffer_set_text(gtk_text_view_get_buffer(text_view), text->str, -1);
+    g_list_free_full(endpoints, g_free);
+    g_string_free(text, TRUE);
+}
+
+static void
+on_network_stats_refresh(GtkWidget *widget, gpointer user_data)
+{
+    (void)widget;
+    refresh_network_stats(GTK_TEXT_VIEW(user_data));
+}
+
+static void
+on_network_stats_save_clicked(GtkButton *button, gpointer user_data)
+{
+    (void)user_data;
+    GtkWidget *toplevel = gtk_widget_get_toplevel(GTK_WIDGET(button));
+    GtkWidget *dialog = gtk_file_chooser_dialog_new("Save Network Statistics", GTK_WINDOW(toplevel),
+                                                    GTK_FILE_CHOOSER_ACTION_SAVE,
+                                                    "_Cancel", GTK_RESPONSE_CANCEL,
+                                                    "_Save", GTK_RESPONSE_ACCEPT,
+                                                    NULL);
+    gtk_file_chooser_set_do_overwrite_confirmation(GTK_FILE_CHOOSER(dialog), TRUE);
+    gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(dialog), "network-stats.json");
+
+    if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
+        gchar *path = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
+        gchar *json = network_stats_to_json();
+        GError *error = NULL;
+
+        if (!g_file_set_contents(path, json, -1, &error)) {
+            g_warning("Failed to save network statistics: %s", error->message);
+            g_error_free(error);
+        }
+        g_free(json);
+        g_free(path);
+    }
+
+    gtk_widget_destroy(dialog);
+}
+
 GtkWidget*
 create_settings_view()
 {
@@ -210,9 +303,51 @@ create_settings_view()
     pango_attr_list_unref(attrs);
     gtk_box_pack_start(GTK_BOX(box), title, FALSE, FALSE, 0);
 
-    GtkWidget *placeholder_label = gtk_label_new("Settings are currently under development.\nCheck back soon for theme, notification, and account options!");
+    GtkWidget *network_grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID(network_grid), 5);
+    gtk_grid_set_column_spacing(GTK_GRID(network_grid), 10);
+    gtk_widget_set_halign(network_grid, GTK_ALIGN_CENTER);
+
+    GtkWidget *streams_label = gtk_label_new("Max concurrent HTTP/2 streams:");
+    gtk_widget_set_halign(streams_label, GTK_ALIGN_START);
+    GtkWidget *streams_spin = gtk_spin_button_new_with_range(1, 256, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(streams_spin), network_async_get_max_streams());
+    g_signal_connect(streams_spin, "value-changed", G_CALLBACK(on_max_streams_changed), NULL);
+
+    gtk_grid_attach(GTK_GRID(network_grid), streams_label, 0, 0, 1, 1);
+    gtk_grid_attach(GTK_GRID(network_grid), streams_spin, 1, 0, 1, 1);
+    gtk_box_pack_start(GTK_BOX(box), network_grid, FALSE, FALSE, 0);
+
+    // Per-endpoint latency breakdown, refreshed whenever the view is shown
+    GtkWidget *stats_frame = gtk_frame_new("Network statistics");
+    GtkWidget *stats_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_container_set_border_width(GTK_CONTAINER(stats_box), 5);
+
+    GtkWidget *stats_scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(stats_scrolled), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    GtkWidget *stats_view = gtk_text_view_new();
+    gtk_text_view_set_editable(GTK_TEXT_VIEW(stats_view), FALSE);
+    gtk_text_view_set_cursor_visible(GTK_TEXT_VIEW(stats_view), FALSE);
+    gtk_text_view_set_monospace(GTK_TEXT_VIEW(stats_view), TRUE);
+    gtk_container_add(GTK_CONTAINER(stats_scrolled), stats_view);
+    g_signal_connect(stats_view, "map", G_CALLBACK(on_network_stats_refresh), stats_view);
+    gtk_box_pack_start(GTK_BOX(stats_box), stats_scrolled, TRUE, TRUE, 0);
+
+    GtkWidget *stats_buttons = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    GtkWidget *refresh_btn = gtk_button_new_with_label("Refresh");
+    g_signal_connect(refresh_btn, "clicked", G_CALLBACK(on_network_stats_refresh), stats_view);
+    GtkWidget *save_btn = gtk_button_new_with_label("Save as JSON...");
+    g_signal_connect(save_btn, "clicked", G_CALLBACK(on_network_stats_save_clicked), NULL);
+    gtk_box_pack_end(GTK_BOX(stats_buttons), save_btn, FALSE, FALSE, 0);
+    gtk_box_pack_end(GTK_BOX(stats_buttons), refresh_btn, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(stats_box), stats_buttons, FALSE, FALSE, 0);
+
+    gtk_container_add(GTK_CONTAINER(stats_frame), stats_box);
+    gtk_box_pack_start(GTK_BOX(box), stats_frame, TRUE, TRUE, 0);
+
+    GtkWidget *placeholder_label = gtk_label_new("More settings are currently under development.\nCheck back soon for theme, notification, and account options!");
     gtk_label_set_justify(GTK_LABEL(placeholder_label), GTK_JUSTIFY_CENTER);
-    gtk_box_pack_start(GTK_BOX(box), placeholder_label, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(box), placeholder_label, FALSE, FALSE, 0);
 
     return box;
 }
@@ -291,6 +426,23 @@ create_admin_view()
     return box;
 }
 
+static void
+on_outbox_changed(guint pending, gboolean retrying, gpointer user_data)
+{
+    GtkWidget *label = GTK_WIDGET(user_data);
+
+    if (pending == 0) {
+        gtk_widget_hide(label);
+        return;
+    }
+
+    gchar *text = g_strdup_printf(retrying ? "%u waiting for network" : "Sending %u…", pending);
+    gtk_label_set_text(GTK_LABEL(label), text);
+    gtk_widget_set_tooltip_text(label, retrying ? "Offline changes are kept and sent when the connection returns." : NULL);
+    gtk_widget_show(label);
+    g_free(text);
+}
+
 GtkWidget*
 create_window()
 {
@@ -359,6 +511,13 @@ create_window()
     g_user_label = gtk_label_new("Not logged in");
     gtk_header_bar_pack_end(GTK_HEADER_BAR(header), g_user_label);
 
+    // Outbox Label, shown while writes are waiting to be sent
+    GtkWidget *outbox_label = gtk_label_new(NULL);
+    gtk_style_context_add_class(gtk_widget_get_style_context(outbox_label), "dim-label");
+    gtk_widget_set_no_show_all(outbox_label, TRUE);
+    gtk_header_bar_pack_end(GTK_HEADER_BAR(header), outbox_label);
+    outbox_set_changed_handler(on_outbox_changed, outbox_label);
+
     g_stack = gtk_stack_new();
     gtk_stack_set_transition_type(GTK_STACK(g_stack), GTK_STACK_TRANSITION_TYPE_SLIDE_LEFT_RIGHT);
     gtk_container_add(GTK_CONTAINER(window), g_stack);
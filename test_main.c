@@ -7,9 +7,19 @@
 #include "json_utils.h"
 #include "session.h"
 #include "network.h"
+#include "network_async.h"
+#include "network_stats.h"
+#include "memory_pool.h"
+#include "network_cache.h"
 #include "actions.h"
 #include "constants.h"
 #include "challenge.h"
+#include "sha256.h"
+#include "cap_tokens.h"
+#include "interactions.h"
+#include "outbox.h"
+#include "executor.h"
+#include "string_intern.h"
 
 // We need to declare internal functions if they are not in headers but needed for tests.
 // Actually most of them ARE in headers now.
@@ -22,55 +32,63 @@
 
 static void test_parse_tweets() {
     const char *json_input = "{\"posts\": [{\"id\": \"123\", \"content\": \"Hello world\", \"author\": {\"name\": \"Test User\", \"username\": \"testuser\", \"avatar\": \"/api/uploads/avatar.png\"}}]}";
-    GList *tweets = parse_tweets(json_input);
+    struct TweetPage *page = parse_tweets(json_input);
 
+    g_assert_nonnull(page);
+    GPtrArray *tweets = page->tweets;
     g_assert_nonnull(tweets);
-    g_assert_cmpint(g_list_length(tweets), ==, 1);
+    g_assert_cmpint(tweets->len, ==, 1);
 
-    struct Tweet *t = (struct Tweet *)tweets->data;
+    struct Tweet *t = (struct Tweet *)g_ptr_array_index(tweets, 0);
     g_assert_cmpstr(t->content, ==, "Hello world");
     g_assert_cmpstr(t->author_name, ==, "Test User");
     g_assert_cmpstr(t->author_username, ==, "testuser");
     g_assert_cmpstr(t->author_avatar, ==, "/api/uploads/avatar.png");
     g_assert_cmpstr(t->id, ==, "123");
 
-    free_tweets(tweets);
+    tweet_page_unref(page);
 }
 
 static void test_parse_tweets_with_note() {
     const char *json_input = "{\"posts\": [{\"id\": \"123\", \"content\": \"Fake news\", \"author\": {\"name\": \"User\", \"username\": \"u\"}, \"fact_check\": {\"note\": \"This is false.\", \"severity\": \"warning\"}}]}";
-    GList *tweets = parse_tweets(json_input);
+    struct TweetPage *page = parse_tweets(json_input);
 
+    g_assert_nonnull(page);
+    GPtrArray *tweets = page->tweets;
     g_assert_nonnull(tweets);
-    struct Tweet *t = (struct Tweet *)tweets->data;
+    struct Tweet *t = (struct Tweet *)g_ptr_array_index(tweets, 0);
     g_assert_cmpstr(t->content, ==, "Fake news");
     g_assert_nonnull(t->note);
     g_assert_cmpstr(t->note, ==, "This is false.");
     g_assert_cmpstr(t->note_severity, ==, "warning");
 
-    free_tweets(tweets);
+    tweet_page_unref(page);
 }
 
 static void test_parse_tweets_with_danger_note() {
     const char *json_input = "{\"posts\": [{\"id\": \"124\", \"content\": \"Very fake news\", \"author\": {\"name\": \"User\", \"username\": \"u\"}, \"fact_check\": {\"note\": \"Danger!\", \"severity\": \"danger\"}}]}";
-    GList *tweets = parse_tweets(json_input);
+    struct TweetPage *page = parse_tweets(json_input);
 
+    g_assert_nonnull(page);
+    GPtrArray *tweets = page->tweets;
     g_assert_nonnull(tweets);
-    struct Tweet *t = (struct Tweet *)tweets->data;
+    struct Tweet *t = (struct Tweet *)g_ptr_array_index(tweets, 0);
     g_assert_cmpstr(t->note_severity, ==, "danger");
 
-    free_tweets(tweets);
+    tweet_page_unref(page);
 }
 
 static void test_parse_tweets_with_info_note() {
     const char *json_input = "{\"posts\": [{\"id\": \"125\", \"content\": \"Context needed\", \"author\": {\"name\": \"User\", \"username\": \"u\"}, \"fact_check\": {\"note\": \"Some info.\", \"severity\": \"info\"}}]}";
-    GList *tweets = parse_tweets(json_input);
+    struct TweetPage *page = parse_tweets(json_input);
 
+    g_assert_nonnull(page);
+    GPtrArray *tweets = page->tweets;
     g_assert_nonnull(tweets);
-    struct Tweet *t = (struct Tweet *)tweets->data;
+    struct Tweet *t = (struct Tweet *)g_ptr_array_index(tweets, 0);
     g_assert_cmpstr(t->note_severity, ==, "info");
 
-    free_tweets(tweets);
+    tweet_page_unref(page);
 }
 
 static void test_parse_login_response() {
@@ -161,6 +179,42 @@ static void test_construct_tweet_payload() {
     
     g_object_unref(parser);
     g_free(payload);
+
+    // Test with quote
+    payload = construct_post_payload("Quote text", NULL, "678");
+    parser = json_parser_new();
+    json_parser_load_from_data(parser, payload, -1, &error);
+    g_assert_no_error(error);
+    obj = json_node_get_object(json_parser_get_root(parser));
+    g_assert_false(json_object_has_member(obj, "reply_to"));
+    g_assert_cmpstr(json_object_get_string_member(obj, "quote_tweet_id"), ==, "678");
+
+    g_object_unref(parser);
+    g_free(payload);
+}
+
+static void test_parse_created_objects() {
+    struct TweetPage *page = parse_posted_tweet("{\"success\": true, \"tweet\": {\"id\": \"t1\", \"content\": \"New post\", \"author\": {\"name\": \"User\", \"username\": \"user\"}}}");
+    g_assert_nonnull(page);
+    g_assert_cmpint(page->tweets->len, ==, 1);
+    struct Tweet *tweet = g_ptr_array_index(page->tweets, 0);
+    g_assert_cmpstr(tweet->id, ==, "t1");
+    g_assert_cmpstr(tweet->author_username, ==, "user");
+    tweet_page_unref(page);
+
+    // Bare objects are accepted, responses without the object are not
+    page = parse_posted_tweet("{\"id\": \"t2\", \"content\": \"Bare\", \"author\": {\"name\": \"User\", \"username\": \"user\"}}");
+    g_assert_nonnull(page);
+    g_assert_cmpstr(((struct Tweet *)g_ptr_array_index(page->tweets, 0))->content, ==, "Bare");
+    tweet_page_unref(page);
+    g_assert_null(parse_posted_tweet("{\"success\": true}"));
+
+    struct DirectMessage *msg = parse_sent_message("{\"message\": {\"id\": \"m1\", \"conversation_id\": \"c1\", \"sender_id\": \"u1\", \"content\": \"Hi\", \"username\": \"user\", \"name\": \"User\", \"created_at\": \"2023-10-27T10:00:00Z\"}}");
+    g_assert_nonnull(msg);
+    g_assert_cmpstr(msg->id, ==, "m1");
+    g_assert_cmpstr(msg->content, ==, "Hi");
+    free_message(msg);
+    g_assert_null(parse_sent_message("{\"success\": true}"));
 }
 
 static void test_session_persistence() {
@@ -231,38 +285,90 @@ static void test_parse_profile() {
     g_assert_cmpint(p->following_count, ==, 50);
     g_assert_cmpint(p->post_count, ==, 10);
 
-    g_free(p->name);
-    g_free(p->username);
-    g_free(p->bio);
-    g_free(p->avatar);
-    g_free(p);
+    free_user(p);
+}
+
+static void test_parse_profile_page() {
+    // Posts before the profile, a second profile object and unknown members
+    const char *json_input = "{\"posts\": ["
+        "{\"id\": \"1\", \"content\": \"First\", \"author\": {\"username\": \"owner\", \"avatar\": \"/api/uploads/owner.png\"}},"
+        "{\"id\": \"2\", \"content\": \"Second\", \"author\": {\"username\": \"owner\", \"avatar\": \"/api/uploads/owner.png\"}},"
+        "{\"id\": \"3\", \"content\": \"Third\", \"author\": {\"username\": \"other\", \"avatar\": null}}],"
+        "\"profile\": {\"name\": \"Stale\", \"username\": \"stale\"},"
+        "\"extra\": {\"nested\": [1, 2, {\"a\": null}]},"
+        "\"profile\": {\"post_count\": 3, \"name\": \"Owner\", \"username\": \"owner\", \"avatar\": \"/api/uploads/owner.png\", \"bio\": null}}";
+    struct Profile *p = NULL;
+    struct TweetPage *page = parse_profile_page(json_input, &p);
+
+    g_assert_nonnull(p);
+    g_assert_cmpstr(p->name, ==, "Owner");
+    g_assert_cmpstr(p->username, ==, "owner");
+    g_assert_cmpstr(p->avatar, ==, "/api/uploads/owner.png");
+    g_assert_null(p->bio);
+    g_assert_cmpint(p->post_count, ==, 3);
+    g_assert_cmpint(p->follower_count, ==, 0);
+
+    g_assert_nonnull(page);
+    g_assert_cmpuint(page->tweets->len, ==, 3);
+    struct Tweet *first = g_ptr_array_index(page->tweets, 0);
+    struct Tweet *second = g_ptr_array_index(page->tweets, 1);
+    struct Tweet *third = g_ptr_array_index(page->tweets, 2);
+    g_assert_cmpstr(first->id, ==, "1");
+    g_assert_cmpstr(third->content, ==, "Third");
+    // Interned, so the prefetch can dedupe avatars by pointer
+    g_assert_true(first->author_avatar == second->author_avatar);
+    g_assert_null(third->author_avatar);
+
+    free_user(p);
+    tweet_page_unref(page);
+
+    // A profile without posts still yields an empty page
+    page = parse_profile_page("{\"profile\": {\"username\": \"quiet\"}}", &p);
+    g_assert_nonnull(p);
+    g_assert_cmpstr(p->username, ==, "quiet");
+    g_assert_nonnull(page);
+    g_assert_cmpuint(page->tweets->len, ==, 0);
+    free_user(p);
+    tweet_page_unref(page);
+
+    page = parse_profile_page("{\"posts\": []}", &p);
+    g_assert_null(p);
+    tweet_page_unref(page);
+
+    g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Unable to parse json*");
+    page = parse_profile_page("{\"profile\": {\"username\": \"broken\"}, \"posts\": [", &p);
+    g_test_assert_expected_messages();
+    g_assert_null(page);
+    g_assert_null(p);
 }
 
 static void test_parse_profile_replies() {
     const char *json_input = "{\"replies\": [{\"id\": \"456\", \"content\": \"Test reply\", \"author\": {\"name\": \"Replier\", \"username\": \"replier\", \"avatar\": \"/api/uploads/reply.png\"}}]}";
-    GList *tweets = parse_profile_replies(json_input);
+    struct TweetPage *page = parse_profile_replies(json_input);
 
+    g_assert_nonnull(page);
+    GPtrArray *tweets = page->tweets;
     g_assert_nonnull(tweets);
-    g_assert_cmpint(g_list_length(tweets), ==, 1);
+    g_assert_cmpint(tweets->len, ==, 1);
 
-    struct Tweet *t = (struct Tweet *)tweets->data;
+    struct Tweet *t = (struct Tweet *)g_ptr_array_index(tweets, 0);
     g_assert_cmpstr(t->content, ==, "Test reply");
     g_assert_cmpstr(t->author_name, ==, "Replier");
     g_assert_cmpstr(t->author_username, ==, "replier");
     g_assert_cmpstr(t->author_avatar, ==, "/api/uploads/reply.png");
     g_assert_cmpstr(t->id, ==, "456");
 
-    free_tweets(tweets);
+    tweet_page_unref(page);
 }
 
 static void test_parse_users() {
     const char *json_input = "{\"users\": [{\"username\": \"testuser\", \"name\": \"Test User\", \"bio\": \"Test Bio\", \"avatar\": \"/api/uploads/user.png\", \"follower_count\": 123}]}";
-    GList *users = parse_users(json_input);
+    GPtrArray *users = parse_users(json_input);
 
     g_assert_nonnull(users);
-    g_assert_cmpint(g_list_length(users), ==, 1);
+    g_assert_cmpint(users->len, ==, 1);
 
-    struct Profile *u = (struct Profile *)users->data;
+    struct Profile *u = (struct Profile *)g_ptr_array_index(users, 0);
     g_assert_cmpstr(u->username, ==, "testuser");
     g_assert_cmpstr(u->name, ==, "Test User");
     g_assert_cmpstr(u->bio, ==, "Test Bio");
@@ -270,16 +376,26 @@ static void test_parse_users() {
     g_assert_cmpint(u->follower_count, ==, 123);
 
     free_users(users);
+
+    // An empty list is an empty array; a malformed response or a missing
+    // list is NULL, which free_users() accepts
+    users = parse_users("{\"users\": []}");
+    g_assert_nonnull(users);
+    g_assert_cmpint(users->len, ==, 0);
+    free_users(users);
+    g_assert_null(parse_users("{\"users\": ["));
+    g_assert_null(parse_users("{}"));
+    free_users(NULL);
 }
 
 static void test_parse_notifications() {
     const char *json_input = "{\"notifications\": [{\"id\": \"n1\", \"type\": \"like\", \"content\": \"liked your tweet\", \"related_id\": \"t1\", \"actor_id\": \"u1\", \"actor_username\": \"actor\", \"actor_name\": \"Actor Name\", \"actor_avatar\": \"/api/uploads/avatar.png\", \"read\": false, \"created_at\": \"2023-10-27T10:00:00Z\"}]}";
-    GList *notifications = parse_notifications(json_input);
+    GPtrArray *notifications = parse_notifications(json_input);
 
     g_assert_nonnull(notifications);
-    g_assert_cmpint(g_list_length(notifications), ==, 1);
+    g_assert_cmpint(notifications->len, ==, 1);
 
-    struct Notification *n = (struct Notification *)notifications->data;
+    struct Notification *n = (struct Notification *)g_ptr_array_index(notifications, 0);
     g_assert_cmpstr(n->id, ==, "n1");
     g_assert_cmpstr(n->type, ==, "like");
     g_assert_cmpstr(n->content, ==, "liked your tweet");
@@ -296,12 +412,14 @@ static void test_parse_notifications() {
 
 static void test_parse_tweets_with_attachments() {
     const char *json_input = "{\"posts\": [{\"id\": \"123\", \"content\": \"Hello with media\", \"author\": {\"name\": \"Test User\", \"username\": \"testuser\", \"avatar\": \"/api/uploads/avatar.png\"}, \"attachments\": [{\"id\": \"a1\", \"file_url\": \"/api/uploads/image.jpg\", \"file_type\": \"image/jpeg\"}, {\"id\": \"v1\", \"file_url\": \"/api/uploads/video.mp4\", \"file_type\": \"video/mp4\"}]}]}";
-    GList *tweets = parse_tweets(json_input);
+    struct TweetPage *page = parse_tweets(json_input);
 
+    g_assert_nonnull(page);
+    GPtrArray *tweets = page->tweets;
     g_assert_nonnull(tweets);
-    g_assert_cmpint(g_list_length(tweets), ==, 1);
+    g_assert_cmpint(tweets->len, ==, 1);
 
-    struct Tweet *t = (struct Tweet *)tweets->data;
+    struct Tweet *t = (struct Tweet *)g_ptr_array_index(tweets, 0);
     g_assert_cmpstr(t->content, ==, "Hello with media");
     
     g_assert_nonnull(t->attachments);
@@ -317,17 +435,80 @@ static void test_parse_tweets_with_attachments() {
     g_assert_cmpstr(v1->file_url, ==, "/api/uploads/video.mp4");
     g_assert_cmpstr(v1->file_type, ==, "video/mp4");
 
-    free_tweets(tweets);
+    tweet_page_unref(page);
+}
+
+static void test_parse_tweets_streaming() {
+    // Members in unusual order, escapes, duplicates, every flag spelling and
+    // unknown nested values, which the streaming decoder has to skip
+    const char *json_input =
+        "{\"meta\": {\"cursor\": [1, {\"deep\": [true, null]}], \"text\": \"}]\"},"
+        " \"posts\": ["
+        "  {\"likes\": 3, \"author\": {\"avatar\": null, \"username\": \"esc\", \"name\": \"Caf\\u00e9 \\\"Bar\\\" \\ud83d\\ude00\"},"
+        "   \"content\": \"line\\nbreak\", \"id\": \"1\", \"content\": \"last wins\", \"liked\": true, \"liked_by_user\": 0,"
+        "   \"is_retweeted\": 1, \"user_bookmarked\": true, \"extra\": {\"nested\": [[], {}]}, \"retweets\": 2.9},"
+        "  \"not an object\","
+        "  {\"id\": \"2\", \"author\": {\"name\": \"B\", \"username\": \"b\"}, \"retweeted_by_user\": 1.5, \"retweeted\": true,"
+        "   \"fact_check\": {\"note\": \"n\", \"severity\": \"danger\"}, \"attachments\": [7, {\"id\": \"a\", \"file_url\": \"/u\", \"file_type\": \"image/png\"}]}"
+        " ]}";
+    struct TweetPage *page = parse_tweets(json_input);
+    g_assert_nonnull(page);
+    GPtrArray *tweets = page->tweets;
+
+    g_assert_cmpint(tweets->len, ==, 2);
+
+    struct Tweet *t = g_ptr_array_index(tweets, 0);
+    g_assert_cmpstr(t->id, ==, "1");
+    g_assert_cmpstr(t->content, ==, "last wins");
+    g_assert_cmpstr(t->author_name, ==, "Caf\xc3\xa9 \"Bar\" \xf0\x9f\x98\x80");
+    g_assert_cmpstr(t->author_username, ==, "esc");
+    g_assert_null(t->author_avatar);
+    g_assert_false(t->liked);       // liked_by_user wins over liked
+    g_assert_true(t->retweeted);
+    g_assert_true(t->bookmarked);
+    g_assert_cmpint(t->like_count, ==, 3);
+    g_assert_cmpint(t->retweet_count, ==, 2);
+    g_assert_null(t->attachments);
+
+    t = g_ptr_array_index(tweets, 1);
+    g_assert_cmpstr(t->id, ==, "2");
+    g_assert_false(t->retweeted);   // retweeted_by_user is not a boolean or integer
+    g_assert_cmpstr(t->note, ==, "n");
+    g_assert_cmpstr(t->note_severity, ==, "danger");
+    g_assert_cmpint(g_list_length(t->attachments), ==, 1);
+    g_assert_cmpstr(((struct Attachment *)t->attachments->data)->file_type, ==, "image/png");
+    tweet_page_unref(page);
+
+    // The replies endpoint uses the same decoder, and the single-post
+    // endpoints ignore the feed-only spellings
+    page = parse_profile_replies("{\"replies\": [{\"id\": \"r\", \"is_liked\": true}]}");
+    tweets = page->tweets;
+    g_assert_cmpint(tweets->len, ==, 1);
+    g_assert_true(((struct Tweet *)g_ptr_array_index(tweets, 0))->liked);
+    tweet_page_unref(page);
+
+    page = parse_posted_tweet("{\"id\": \"p\", \"is_liked\": true, \"author\": {\"username\": \"u\"}}");
+    g_assert_nonnull(page);
+    g_assert_false(((struct Tweet *)g_ptr_array_index(page->tweets, 0))->liked);
+    tweet_page_unref(page);
+
+    // A malformed page yields nothing rather than the posts before the error
+    g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Unable to parse json*");
+    g_assert_null(parse_tweets("{\"posts\": [{\"id\": \"1\"}, {\"id\": \"2\",}]}"));
+    g_test_assert_expected_messages();
+    g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Unable to parse json*");
+    g_assert_null(parse_tweets("{\"posts\": [{\"content\": \"bad \\x escape\"}]}"));
+    g_test_assert_expected_messages();
 }
 
 static void test_parse_conversations() {
     const char *json_input = "{\"conversations\": [{\"id\": \"c1\", \"type\": \"direct\", \"displayName\": \"Test User\", \"displayAvatar\": \"/avatar.png\", \"last_message_content\": \"Hello\", \"last_message_time\": \"2023-10-27T10:00:00Z\", \"unread_count\": 1}]}";
-    GList *convs = parse_conversations(json_input);
+    GPtrArray *convs = parse_conversations(json_input);
 
     g_assert_nonnull(convs);
-    g_assert_cmpint(g_list_length(convs), ==, 1);
+    g_assert_cmpint(convs->len, ==, 1);
 
-    struct Conversation *c = (struct Conversation *)convs->data;
+    struct Conversation *c = (struct Conversation *)g_ptr_array_index(convs, 0);
     g_assert_cmpstr(c->id, ==, "c1");
     g_assert_cmpstr(c->type, ==, "direct");
     g_assert_cmpstr(c->display_name, ==, "Test User");
@@ -340,12 +521,12 @@ static void test_parse_conversations() {
 
 static void test_parse_messages() {
     const char *json_input = "{\"messages\": [{\"id\": \"m1\", \"conversation_id\": \"c1\", \"sender_id\": \"u1\", \"content\": \"Hello\", \"username\": \"testuser\", \"name\": \"Test User\", \"avatar\": \"/avatar.png\", \"created_at\": \"2023-10-27T10:00:00Z\"}]}";
-    GList *msgs = parse_messages(json_input);
+    GPtrArray *msgs = parse_messages(json_input);
 
     g_assert_nonnull(msgs);
-    g_assert_cmpint(g_list_length(msgs), ==, 1);
+    g_assert_cmpint(msgs->len, ==, 1);
 
-    struct DirectMessage *m = (struct DirectMessage *)msgs->data;
+    struct DirectMessage *m = (struct DirectMessage *)g_ptr_array_index(msgs, 0);
     g_assert_cmpstr(m->id, ==, "m1");
     g_assert_cmpstr(m->content, ==, "Hello");
     g_assert_cmpstr(m->username, ==, "testuser");
@@ -359,21 +540,23 @@ static void test_parse_tweet_details() {
         "\"threadPosts\": [{\"id\": \"parent\", \"content\": \"Parent tweet\", \"author\": {\"name\": \"Parent\", \"username\": \"parent\"}}],"
         "\"replies\": [{\"id\": \"reply\", \"content\": \"Reply tweet\", \"author\": {\"name\": \"Replier\", \"username\": \"replier\"}}]"
     "}";
-    GList *tweets = parse_tweet_details(json_input);
+    struct TweetPage *page = parse_tweet_details(json_input);
 
+    g_assert_nonnull(page);
+    GPtrArray *tweets = page->tweets;
     g_assert_nonnull(tweets);
-    g_assert_cmpint(g_list_length(tweets), ==, 3);
+    g_assert_cmpint(tweets->len, ==, 3);
 
-    struct Tweet *t1 = (struct Tweet *)g_list_nth_data(tweets, 0);
+    struct Tweet *t1 = (struct Tweet *)g_ptr_array_index(tweets, 0);
     g_assert_cmpstr(t1->id, ==, "parent");
     
-    struct Tweet *t2 = (struct Tweet *)g_list_nth_data(tweets, 1);
+    struct Tweet *t2 = (struct Tweet *)g_ptr_array_index(tweets, 1);
     g_assert_cmpstr(t2->id, ==, "main");
     
-    struct Tweet *t3 = (struct Tweet *)g_list_nth_data(tweets, 2);
+    struct Tweet *t3 = (struct Tweet *)g_ptr_array_index(tweets, 2);
     g_assert_cmpstr(t3->id, ==, "reply");
 
-    free_tweets(tweets);
+    tweet_page_unref(page);
 }
 
 static void test_challenge_solver() {
@@ -401,6 +584,1194 @@ static void test_challenge_solver() {
     g_free(token);
 }
 
+static void test_challenge_solver_golden() {
+    // Nonces from the original sequential solver for a fixed token. The
+    // parallel solver must return exactly the smallest matching nonce.
+    const gint64 expected[] = { 115612, 109482, 81158, 87970 };
+    gchar *solutions_json = solve_challenge("{\"c\": 4, \"s\": 32, \"d\": 4}", "golden-token");
+    g_assert_nonnull(solutions_json);
+
+    JsonParser *parser = json_parser_new();
+    g_assert_true(json_parser_load_from_data(parser, solutions_json, -1, NULL));
+    JsonArray *array = json_node_get_array(json_parser_get_root(parser));
+    g_assert_cmpint(json_array_get_length(array), ==, G_N_ELEMENTS(expected));
+    for (guint i = 0; i < G_N_ELEMENTS(expected); i++) {
+        g_assert_cmpint(json_array_get_int_element(array, i), ==, expected[i]);
+    }
+
+    g_object_unref(parser);
+    g_free(solutions_json);
+}
+
+static void test_challenge_vectors() {
+    // Generated by an independent implementation of the Cap client; see
+    // docs/development.md. Any solver change must reproduce them exactly.
+    gchar *path = g_test_build_filename(G_TEST_DIST, "testdata", "challenge_vectors.json", NULL);
+    JsonParser *parser = json_parser_new();
+    GError *error = NULL;
+
+    g_assert_true(json_parser_load_from_file(parser, path, &error));
+    g_assert_no_error(error);
+
+    JsonArray *vectors = json_node_get_array(json_parser_get_root(parser));
+    g_assert_cmpuint(json_array_get_length(vectors), >, 0);
+
+    for (guint i = 0; i < json_array_get_length(vectors); i++) {
+        JsonObject *vector = json_array_get_object_element(vectors, i);
+        JsonArray *expected = json_object_get_array_member(vector, "solutions");
+        gchar *challenge_json = json_to_string(json_object_get_member(vector, "challenge"), FALSE);
+        gchar *solutions_json = solve_challenge(challenge_json, json_object_get_string_member(vector, "token"));
+        g_assert_nonnull(solutions_json);
+
+        JsonParser *result = json_parser_new();
+        g_assert_true(json_parser_load_from_data(result, solutions_json, -1, NULL));
+        JsonArray *actual = json_node_get_array(json_parser_get_root(result));
+        g_assert_cmpuint(json_array_get_length(actual), ==, json_array_get_length(expected));
+        for (guint j = 0; j < json_array_get_length(expected); j++) {
+            g_assert_cmpint(json_array_get_int_element(actual, j), ==, json_array_get_int_element(expected, j));
+        }
+
+        g_object_unref(result);
+        g_free(solutions_json);
+        g_free(challenge_json);
+    }
+
+    g_object_unref(parser);
+    g_free(path);
+}
+
+static gboolean may_need_challenge(const gchar *body, long response_code) {
+    struct MemoryStruct chunk;
+    memory_struct_init(&chunk);
+    memory_struct_append(&chunk, body, strlen(body));
+    gboolean result = network_response_may_need_challenge(&chunk, response_code);
+    memory_struct_release(&chunk);
+    return result;
+}
+
+static void test_network_challenge_prescan() {
+    g_assert_true(may_need_challenge(" {\"challenge\": {\"c\": 1, \"s\": 32, \"d\": 4}, \"token\": \"t\"}", 200));
+    g_assert_true(may_need_challenge("{\"error\": \"Rate limit exceeded\"}", 429));
+
+    // Feeds may mention the word but are arrays or lack a token
+    g_assert_false(may_need_challenge("[{\"content\": \"\\\"challenge\\\" accepted\", \"token\": 1}]", 200));
+    g_assert_false(may_need_challenge("{\"posts\": [], \"challenge\": null}", 200));
+    g_assert_false(may_need_challenge("", 200));
+
+    // Too large to be a challenge, even if it looks like one
+    GString *large = g_string_new("{\"challenge\": {}, \"token\": \"t\", \"pad\": \"");
+    while (large->len <= CHALLENGE_MAX_BODY_BYTES) {
+        g_string_append(large, "xxxxxxxxxxxxxxxx");
+    }
+    g_string_append(large, "\"}");
+    g_assert_false(may_need_challenge(large->str, 200));
+    g_string_free(large, TRUE);
+}
+
+static void test_cap_tokens_pool() {
+    guint64 ready_before = 0, ready = 0, solved_inline = 0;
+    cap_tokens_get_stats(&ready_before, NULL);
+
+    // Expired tokens are skipped, so no solve (and no request) is needed
+    cap_tokens_add("expired-token", g_get_monotonic_time() - 1);
+    cap_tokens_add("fresh-token", g_get_monotonic_time() + 60 * G_USEC_PER_SEC);
+
+    gchar *token = cap_tokens_take();
+    g_assert_cmpstr(token, ==, "fresh-token");
+    g_free(token);
+
+    cap_tokens_get_stats(&ready, &solved_inline);
+    g_assert_cmpuint(ready, ==, ready_before + 1);
+    g_assert_cmpuint(solved_inline, ==, 0);
+
+    cap_tokens_clear();
+}
+
+static void test_interactions_toggle() {
+    struct InteractionData *data = interaction_data_new("1", INTERACTION_LIKE, FALSE);
+
+    // A double toggle before the send collapses into no request
+    interaction_toggle(data);
+    interaction_toggle(data);
+    g_assert_false(interaction_begin_request(data));
+
+    // Like then unlike queues two requests, which the outbox cancels out
+    interaction_toggle(data);
+    g_assert_true(interaction_begin_request(data));
+    g_assert_true(data->queued);
+    interaction_toggle(data);
+    g_assert_true(interaction_begin_request(data));
+    g_assert_cmpuint(data->pending, ==, 2);
+    interaction_finish_request(data, FALSE, -1);
+    interaction_finish_request(data, FALSE, -1);
+    g_assert_false(data->state);
+    g_assert_false(data->confirmed);
+
+    // A request that goes through flips the confirmed state
+    interaction_toggle(data);
+    g_assert_true(interaction_begin_request(data));
+    interaction_finish_request(data, TRUE, -1);
+    g_assert_true(data->confirmed);
+    g_assert_true(data->state);
+
+    // A rejected request rolls back
+    interaction_toggle(data);
+    g_assert_true(interaction_begin_request(data));
+    interaction_finish_request(data, FALSE, -1);
+    g_assert_true(data->state);
+    g_assert_false(interaction_begin_request(data));
+
+    // The state reported by the server wins
+    interaction_toggle(data);
+    g_assert_true(interaction_begin_request(data));
+    interaction_finish_request(data, TRUE, 1);
+    g_assert_true(data->state);
+    g_assert_cmpuint(data->pending, ==, 0);
+
+    g_assert_cmpstr(interaction_label(INTERACTION_BOOKMARK, TRUE), ==, "★ Saved");
+    interaction_data_free(data);
+}
+
+static guint outbox_test_discarded = 0;
+
+static void on_outbox_test_done(struct MemoryStruct *chunk, long response_code, gpointer user_data) {
+    (void)response_code;
+    (void)user_data;
+    if (!chunk) outbox_test_discarded++;
+}
+
+static void test_outbox_coalesce() {
+    // Nothing is sent while logged out, so the queue can be inspected
+    gchar *saved_token = g_auth_token;
+    g_auth_token = NULL;
+    outbox_test_discarded = 0;
+
+    outbox_enqueue("https://example.invalid/tweets/1/like", "POST", "{}", "like:1", OUTBOX_TOGGLE,
+                   on_outbox_test_done, NULL);
+    outbox_enqueue("https://example.invalid/tweets/", "POST", "{\"content\":\"queued\"}", NULL, OUTBOX_APPEND,
+                   on_outbox_test_done, NULL);
+    g_assert_cmpuint(outbox_get_pending_count(), ==, 2);
+
+    // Unlike cancels the queued like; both callers are told from the main loop
+    outbox_enqueue("https://example.invalid/tweets/1/like", "POST", "{}", "like:1", OUTBOX_TOGGLE,
+                   on_outbox_test_done, NULL);
+    g_assert_cmpuint(outbox_get_pending_count(), ==, 1);
+    g_assert_cmpuint(outbox_test_discarded, ==, 0);
+    while (g_main_context_iteration(NULL, FALSE));
+    g_assert_cmpuint(outbox_test_discarded, ==, 2);
+
+    // The journal holds what is left, once the burst of changes is written
+    outbox_flush();
+    gchar *path = get_config_file_path("outbox.json");
+    gchar *journal = NULL;
+    g_assert_true(g_file_get_contents(path, &journal, NULL, NULL));
+    g_assert_nonnull(strstr(journal, "queued"));
+    g_assert_null(strstr(journal, "like:1"));
+    g_free(journal);
+
+    outbox_clear();
+    while (g_main_context_iteration(NULL, FALSE));
+    g_assert_cmpuint(outbox_get_pending_count(), ==, 0);
+    g_assert_cmpuint(outbox_test_discarded, ==, 3);
+
+    outbox_flush();
+    g_assert_true(g_file_get_contents(path, &journal, NULL, NULL));
+    g_assert_null(strstr(journal, "queued"));
+    g_free(journal);
+    g_free(path);
+
+    g_auth_token = saved_token;
+}
+
+static gint executor_test_ran = 0;
+static guint executor_test_finished = 0;
+
+static void executor_test_task(gpointer data) {
+    (void)data;
+    g_atomic_int_inc(&executor_test_ran);
+}
+
+static void on_executor_test_done(gpointer data) {
+    (void)data;
+    executor_test_finished++;
+}
+
+static void test_executor_lanes() {
+    struct ExecutorStats before, stats;
+    executor_get_stats(EXECUTOR_LANE_CPU, &before);
+    g_assert_cmpuint(before.workers, ==, MAX(1, g_get_num_processors()));
+    executor_test_ran = 0;
+    executor_test_finished = 0;
+
+    // A burst much larger than the lane queues up on its bounded workers
+    for (int i = 0; i < 200; i++) {
+        executor_submit_full(EXECUTOR_LANE_CPU, executor_test_task, on_executor_test_done, NULL);
+    }
+    executor_submit(EXECUTOR_LANE_IO, executor_test_task, NULL);
+
+    // Completion callbacks only run from the main loop
+    while (executor_test_finished < 200) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    executor_shutdown();
+    g_assert_cmpint(g_atomic_int_get(&executor_test_ran), ==, 201);
+
+    executor_get_stats(EXECUTOR_LANE_CPU, &stats);
+    g_assert_cmpuint(stats.submitted - before.submitted, ==, 200);
+    g_assert_cmpuint(stats.completed - before.completed, ==, 200);
+    g_assert_cmpuint(stats.wait.count - before.wait.count, ==, 200);
+    g_assert_cmpuint(stats.run.count - before.run.count, ==, 200);
+    g_assert_cmpuint(stats.queued, ==, 0);
+    g_assert_cmpuint(stats.running, ==, 0);
+    g_assert_cmpuint(stats.max_queued, >=, 1);
+
+    executor_get_stats(EXECUTOR_LANE_IO, &stats);
+    g_assert_cmpuint(stats.workers, ==, EXECUTOR_IO_WORKERS);
+    g_assert_cmpuint(stats.completed, >=, 1);
+
+    // The shutdown above is process-wide. The next submit starts a new pool,
+    // so tests running after this one still have working lanes.
+    executor_submit_full(EXECUTOR_LANE_CPU, executor_test_task, on_executor_test_done, NULL);
+    executor_submit_full(EXECUTOR_LANE_IO, executor_test_task, on_executor_test_done, NULL);
+    while (executor_test_finished < 202) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    g_assert_cmpint(g_atomic_int_get(&executor_test_ran), ==, 203);
+}
+
+static void assert_sha256_matches_gchecksum(const gchar *data, gsize len) {
+    struct Sha256 ctx;
+    guint8 digest[SHA256_DIGEST_SIZE];
+    guint8 expected[SHA256_DIGEST_SIZE];
+    gsize expected_len = sizeof(expected);
+
+    // Feed in two pieces so a split across the block buffer is exercised
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, len / 3);
+    sha256_update(&ctx, data + len / 3, len - len / 3);
+    sha256_final(&ctx, digest);
+
+    GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA256);
+    g_checksum_update(checksum, (const guchar *)data, len);
+    g_checksum_get_digest(checksum, expected, &expected_len);
+    g_checksum_free(checksum);
+
+    g_assert_cmpmem(digest, sizeof(digest), expected, expected_len);
+}
+
+static void test_sha256_vectors() {
+    struct Sha256 ctx;
+    guint8 digest[SHA256_DIGEST_SIZE];
+    const guint8 abc[SHA256_DIGEST_SIZE] = {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+    };
+
+    sha256_init(&ctx);
+    sha256_update(&ctx, "abc", 3);
+    sha256_final(&ctx, digest);
+    g_assert_cmpmem(digest, sizeof(digest), abc, sizeof(abc));
+
+    // Every length around the one- and two-block padding boundaries
+    gchar data[200];
+    for (gsize i = 0; i < sizeof(data); i++) {
+        data[i] = (gchar)('a' + i % 26);
+    }
+    for (gsize len = 0; len <= sizeof(data); len++) {
+        assert_sha256_matches_gchecksum(data, len);
+    }
+}
+
+static void test_sha256_kernels() {
+    guint n_kernels;
+    const struct Sha256Kernel *kernels = sha256_get_supported_kernels(&n_kernels);
+    guint8 blocks[SHA256_MAX_LANES][SHA256_BLOCK_SIZE];
+    const guint8 *block_ptrs[SHA256_MAX_LANES];
+    guint32 seed = 1;
+
+    g_assert_cmpuint(n_kernels, >=, 1);
+    g_assert_cmpstr(kernels[n_kernels - 1].name, ==, "scalar");
+    g_assert_nonnull(sha256_get_kernel());
+
+    // Every kernel the CPU supports must agree with the portable one
+    for (guint k = 0; k < n_kernels; k++) {
+        guint32 states[SHA256_MAX_LANES][8];
+        guint32 expected[SHA256_MAX_LANES][8];
+
+        for (guint j = 0; j < SHA256_MAX_LANES; j++) {
+            for (guint i = 0; i < SHA256_BLOCK_SIZE; i++) {
+                seed = seed * 1103515245 + 12345;
+                blocks[j][i] = (guint8)(seed >> 16);
+            }
+            for (guint i = 0; i < 8; i++) {
+                seed = seed * 1103515245 + 12345;
+                states[j][i] = expected[j][i] = seed;
+            }
+            block_ptrs[j] = blocks[j];
+        }
+
+        kernels[k].compress(states, block_ptrs);
+        for (guint j = 0; j < kernels[k].lanes; j++) {
+            sha256_compress(expected[j], blocks[j]);
+            g_assert_cmpmem(states[j], sizeof(states[j]), expected[j], sizeof(expected[j]));
+        }
+    }
+}
+
+static void test_challenge_pow_scan() {
+    // A 63-byte salt puts the nonce across the block boundary, and the scan
+    // passes 999 -> 1000 where the decimal nonce grows by a digit.
+    const gchar *salt = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijk";
+    gchar *input = g_strconcat(salt, "1000", NULL);
+    gchar *digest_hex = g_compute_checksum_for_string(G_CHECKSUM_SHA256, input, -1);
+    gchar *target_hex = g_strndup(digest_hex, 8);
+    guint64 nonce = 0;
+
+    g_assert_true(challenge_pow_scan(salt, target_hex, 990, 20, &nonce));
+    g_assert_cmpuint(nonce, ==, 1000);
+    g_assert_false(challenge_pow_scan(salt, target_hex, 0, 1000, &nonce));
+
+    g_free(target_hex);
+    g_free(digest_hex);
+    g_free(input);
+
+    // With a 52-byte tail, 999 still pads into one block but 1000 needs two,
+    // so a batch of SIMD lanes is split at the carry
+    const gchar *short_salt = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz";
+    input = g_strconcat(short_salt, "1001", NULL);
+    digest_hex = g_compute_checksum_for_string(G_CHECKSUM_SHA256, input, -1);
+    target_hex = g_strndup(digest_hex, 8);
+
+    g_assert_true(challenge_pow_scan(short_salt, target_hex, 995, 20, &nonce));
+    g_assert_cmpuint(nonce, ==, 1001);
+
+    g_free(target_hex);
+    g_free(digest_hex);
+    g_free(input);
+}
+
+static void test_challenge_pow_benchmark() {
+    if (!g_test_perf()) {
+        g_test_skip("Run with -m perf");
+        return;
+    }
+
+    // 32 zero bytes never match, so both loops scan the whole range
+    const gchar *salt = "0123456789abcdef0123456789abcdef";
+    const gchar *target_hex = "0000000000000000000000000000000000000000000000000000000000000000";
+    const guint64 iterations = 2000000;
+    guint64 nonce;
+
+    // What the solver did before: format, concatenate and hash from scratch
+    g_test_timer_start();
+    for (guint64 i = 0; i < iterations; i++) {
+        gchar *input = g_strdup_printf("%s%" G_GUINT64_FORMAT, salt, i);
+        gchar *hash = g_compute_checksum_for_string(G_CHECKSUM_SHA256, input, -1);
+        g_free(hash);
+        g_free(input);
+    }
+    gdouble baseline = g_test_timer_elapsed();
+
+    sha256_get_kernel();  // Keep the one-off calibration out of the timing
+    g_test_timer_start();
+    g_assert_false(challenge_pow_scan(salt, target_hex, 0, iterations, &nonce));
+    gdouble kernel = g_test_timer_elapsed();
+
+    g_test_message("GChecksum: %.0f hashes/s, %s kernel: %.0f hashes/s (%.1fx)",
+                   iterations / baseline, sha256_get_kernel()->name, iterations / kernel, baseline / kernel);
+    g_test_maximized_result(iterations / kernel, "%.0f hashes/s", iterations / kernel);
+}
+
+// Loopback HTTP/1.1 server for the network tests. Connections are served one
+// at a time on the server's own thread, so both blocking fetches on the test
+// thread and transfers driven by the main loop can use it. The request head
+// is read and passed to the handler, which writes the response.
+typedef void (*TestServerHandler)(GSocketConnection *connection, const gchar *request, gpointer user_data);
+
+struct TestServer {
+    GSocketListener *listener;
+    GCancellable *cancellable;
+    GThread *thread;
+    guint16 port;
+    gint requests;
+    TestServerHandler handler;
+    gpointer user_data;
+};
+
+static gpointer test_server_thread(gpointer data) {
+    struct TestServer *server = data;
+    GSocketConnection *connection;
+
+    while ((connection = g_socket_listener_accept(server->listener, NULL, server->cancellable, NULL))) {
+        GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+        GString *request = g_string_new(NULL);
+        gchar buffer[1024];
+        gssize n = 1;
+
+        while (!strstr(request->str, "\r\n\r\n") &&
+               (n = g_input_stream_read(in, buffer, sizeof(buffer), server->cancellable, NULL)) > 0) {
+            g_string_append_len(request, buffer, n);
+        }
+        if (n > 0) {
+            g_atomic_int_inc(&server->requests);
+            server->handler(connection, request->str, server->user_data);
+        }
+
+        g_string_free(request, TRUE);
+        g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+        g_object_unref(connection);
+    }
+    return NULL;
+}
+
+static struct TestServer* test_server_start(TestServerHandler handler, gpointer user_data) {
+    struct TestServer *server = g_new0(struct TestServer, 1);
+    GInetAddress *loopback = g_inet_address_new_loopback(G_SOCKET_FAMILY_IPV4);
+    GSocketAddress *address = g_inet_socket_address_new(loopback, 0);
+    GSocketAddress *bound = NULL;
+
+    server->listener = g_socket_listener_new();
+    server->cancellable = g_cancellable_new();
+    server->handler = handler;
+    server->user_data = user_data;
+    g_assert_true(g_socket_listener_add_address(server->listener, address, G_SOCKET_TYPE_STREAM,
+                                                G_SOCKET_PROTOCOL_TCP, NULL, &bound, NULL));
+    server->port = g_inet_socket_address_get_port(G_INET_SOCKET_ADDRESS(bound));
+    server->thread = g_thread_new("test-server", test_server_thread, server);
+
+    g_object_unref(bound);
+    g_object_unref(address);
+    g_object_unref(loopback);
+    return server;
+}
+
+static gchar* test_server_url(struct TestServer *server, const gchar *path) {
+    return g_strdup_printf("http://127.0.0.1:%u%s", server->port, path);
+}
+
+static void test_server_write(GSocketConnection *connection, const gchar *response) {
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+    g_output_stream_write_all(out, response, strlen(response), NULL, NULL, NULL);
+}
+
+static void test_server_stop(struct TestServer *server) {
+    g_cancellable_cancel(server->cancellable);
+    g_thread_join(server->thread);
+    g_socket_listener_close(server->listener);
+    g_object_unref(server->listener);
+    g_object_unref(server->cancellable);
+    g_free(server);
+}
+
+static void test_network_pool() {
+    guint64 hits_before = 0, misses_before = 0;
+    guint64 hits = 0, misses = 0;
+    network_get_pool_stats(&hits_before, &misses_before);
+
+    CURL *first = network_pool_acquire();
+    g_assert_nonnull(first);
+    network_pool_release(first);
+
+    // The released handle should be handed straight back out
+    CURL *second = network_pool_acquire();
+    g_assert_true(first == second);
+    network_pool_release(second);
+
+    network_get_pool_stats(&hits, &misses);
+    g_assert_cmpuint(hits - hits_before, ==, 1);
+    g_assert_cmpuint(misses - misses_before, <=, 1);
+}
+
+struct AsyncTestState {
+    GMainLoop *loop;
+    gboolean called;
+    gboolean got_body;
+};
+
+static void on_async_test_done(struct MemoryStruct *chunk, long response_code, gpointer user_data) {
+    struct AsyncTestState *state = user_data;
+    state->called = TRUE;
+    state->got_body = (chunk != NULL);
+    if (!chunk) {
+        g_assert_cmpint(response_code, ==, 0);
+    }
+    g_main_loop_quit(state->loop);
+}
+
+static gboolean on_async_test_timeout(gpointer user_data) {
+    struct AsyncTestState *state = user_data;
+    g_main_loop_quit(state->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void test_network_async_failure() {
+    struct AsyncTestState state = { g_main_loop_new(NULL, FALSE), FALSE, FALSE };
+
+    // Nothing listens on port 1, so the transfer fails without touching the network
+    g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL, "Async request to *failed*");
+    fetch_url_async("http://127.0.0.1:1/", NULL, "GET", on_async_test_done, &state);
+    g_assert_false(state.called); // Completion is always delivered from the main loop
+
+    guint timeout_id = g_timeout_add_seconds(10, on_async_test_timeout, &state);
+    g_main_loop_run(state.loop);
+    if (state.called) {
+        g_source_remove(timeout_id);
+    }
+
+    g_assert_true(state.called);
+    g_assert_false(state.got_body);
+    g_test_assert_expected_messages();
+    g_main_loop_unref(state.loop);
+}
+
+struct CoalesceTestState {
+    GMainLoop *loop;
+    int calls;
+};
+
+static void on_coalesce_test_done(struct MemoryStruct *chunk, long response_code, gpointer user_data) {
+    (void)chunk;
+    (void)response_code;
+    struct CoalesceTestState *state = user_data;
+    if (++state->calls == 2) {
+        g_main_loop_quit(state->loop);
+    }
+}
+
+static gboolean on_coalesce_test_timeout(gpointer user_data) {
+    struct CoalesceTestState *state = user_data;
+    g_main_loop_quit(state->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void test_network_async_coalesce() {
+    struct CoalesceTestState state = { g_main_loop_new(NULL, FALSE), 0 };
+    struct EndpointStats stats;
+    network_stats_reset();
+
+    // Both callers share one transfer, so the failure is only reported once
+    g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL, "Async request to *failed*");
+    fetch_url_async("http://127.0.0.1:1/avatar.png", NULL, "GET", on_coalesce_test_done, &state);
+    fetch_url_async("http://127.0.0.1:1/avatar.png", NULL, "GET", on_coalesce_test_done, &state);
+
+    guint timeout_id = g_timeout_add_seconds(10, on_coalesce_test_timeout, &state);
+    g_main_loop_run(state.loop);
+    if (state.calls == 2) {
+        g_source_remove(timeout_id);
+    }
+
+    g_assert_cmpint(state.calls, ==, 2);
+    g_assert_true(network_stats_get("127.0.0.1:1/*", &stats));
+    g_assert_cmpuint(stats.coalesced, ==, 1);
+    g_test_assert_expected_messages();
+    g_main_loop_unref(state.loop);
+    network_stats_reset();
+}
+
+static void on_cancel_test_done(struct MemoryStruct *chunk, long response_code, gpointer user_data) {
+    struct CoalesceTestState *state = user_data;
+    // Cancelled callers are still called once, but never see the body
+    g_assert_null(chunk);
+    g_assert_cmpint(response_code, ==, 0);
+    if (++state->calls == 2) {
+        g_main_loop_quit(state->loop);
+    }
+}
+
+static void test_network_async_cancel() {
+    const gchar *url = API_BASE_URL "/emojis";
+    struct CoalesceTestState state = { g_main_loop_new(NULL, FALSE), 0 };
+    GCancellable *cancellable = g_cancellable_new();
+
+    // A fresh cache entry keeps the network out of it
+    network_cache_clear();
+    network_cache_store(url, NULL, NULL, 60, "[]", 2);
+
+    g_cancellable_cancel(cancellable);
+    fetch_url_async_full(url, NULL, "GET", REQUEST_PRIORITY_FEED, cancellable, on_cancel_test_done, &state);
+    fetch_url_async_full(url, NULL, "GET", REQUEST_PRIORITY_FEED, cancellable, on_cancel_test_done, &state);
+    g_object_unref(cancellable);
+
+    guint timeout_id = g_timeout_add_seconds(10, on_coalesce_test_timeout, &state);
+    g_main_loop_run(state.loop);
+    if (state.calls == 2) {
+        g_source_remove(timeout_id);
+    }
+
+    g_assert_cmpint(state.calls, ==, 2);
+    g_main_loop_unref(state.loop);
+    network_cache_clear();
+}
+
+static void test_network_async_cancel_queued() {
+    struct AsyncTestState state = { g_main_loop_new(NULL, FALSE), FALSE, FALSE };
+    GCancellable *cancellable = g_cancellable_new();
+
+    // Cancelled before it was queued, so it is dropped without a transfer.
+    // The caller still finishes its own setup before the callback runs.
+    g_cancellable_cancel(cancellable);
+    fetch_url_async_full("http://127.0.0.1:1/queued", NULL, "GET", REQUEST_PRIORITY_FEED, cancellable,
+                         on_async_test_done, &state);
+    g_object_unref(cancellable);
+    g_assert_false(state.called);
+
+    guint timeout_id = g_timeout_add_seconds(10, on_async_test_timeout, &state);
+    g_main_loop_run(state.loop);
+    if (state.called) {
+        g_source_remove(timeout_id);
+    }
+
+    g_assert_true(state.called);
+    g_assert_false(state.got_body);
+    g_main_loop_unref(state.loop);
+}
+
+struct MidFlightTestState {
+    GMainLoop *loop;
+    GCancellable *cancellable;
+    gint started;       // Set by the server once the response is under way
+    gboolean called;
+    gboolean got_body;
+    long response_code;
+};
+
+// Sends the head and the start of a long body, then holds the connection
+// until the client hangs up
+static void serve_endless_body(GSocketConnection *connection, const gchar *request, gpointer user_data) {
+    struct MidFlightTestState *state = user_data;
+    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+    gchar buffer[256];
+    (void)request;
+
+    test_server_write(connection, "HTTP/1.1 200 OK\r\nContent-Length: 1000000\r\n\r\n{\"posts\": [");
+    g_atomic_int_set(&state->started, 1);
+    // Bounded, in case the transfer is never aborted
+    g_socket_set_timeout(g_socket_connection_get_socket(connection), 10);
+    while (g_input_stream_read(in, buffer, sizeof(buffer), NULL, NULL) > 0) {
+    }
+}
+
+static gboolean cancel_once_started(gpointer user_data) {
+    struct MidFlightTestState *state = user_data;
+    if (!g_atomic_int_get(&state->started)) {
+        return G_SOURCE_CONTINUE;
+    }
+    g_cancellable_cancel(state->cancellable);
+    return G_SOURCE_REMOVE;
+}
+
+static void on_mid_flight_test_done(struct MemoryStruct *chunk, long response_code, gpointer user_data) {
+    struct MidFlightTestState *state = user_data;
+    state->called = TRUE;
+    state->got_body = (chunk != NULL);
+    state->response_code = response_code;
+    g_main_loop_quit(state->loop);
+}
+
+static gboolean on_mid_flight_test_timeout(gpointer user_data) {
+    struct MidFlightTestState *state = user_data;
+    g_main_loop_quit(state->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void test_network_async_cancel_mid_flight() {
+    struct MidFlightTestState state = { g_main_loop_new(NULL, FALSE), g_cancellable_new(), 0, FALSE, FALSE, -1 };
+    struct TestServer *server = test_server_start(serve_endless_body, &state);
+    gchar *url = test_server_url(server, "/endless");
+    GPtrArray *held = g_ptr_array_new();
+    guint64 hits_before = 0, hits = 0, misses_before = 0, misses = 0;
+
+    // Empty the pool, so the transfer gets a handle of its own and a hit
+    // afterwards can only be that handle coming back
+    do {
+        network_get_pool_stats(NULL, &misses_before);
+        g_ptr_array_add(held, network_pool_acquire());
+        network_get_pool_stats(NULL, &misses);
+    } while (misses == misses_before);
+
+    fetch_url_async_full(url, NULL, "GET", REQUEST_PRIORITY_FEED, state.cancellable, on_mid_flight_test_done, &state);
+    guint poll_id = g_timeout_add(10, cancel_once_started, &state);
+    guint timeout_id = g_timeout_add_seconds(10, on_mid_flight_test_timeout, &state);
+    g_main_loop_run(state.loop);
+    if (state.called) {
+        g_source_remove(timeout_id);
+    }
+    if (!g_cancellable_is_cancelled(state.cancellable)) {
+        g_source_remove(poll_id);
+    }
+
+    // The progress callback aborted the transfer while the body was still
+    // arriving, and the caller only got the cancellation
+    g_assert_true(g_atomic_int_get(&state.started));
+    g_assert_true(state.called);
+    g_assert_false(state.got_body);
+    g_assert_cmpint(state.response_code, ==, 0);
+
+    network_get_pool_stats(&hits_before, NULL);
+    CURL *handle = network_pool_acquire();
+    network_get_pool_stats(&hits, NULL);
+    g_assert_cmpuint(hits, ==, hits_before + 1);
+    network_pool_release(handle);
+
+    for (guint i = 0; i < held->len; i++) {
+        network_pool_release(g_ptr_array_index(held, i));
+    }
+    g_ptr_array_unref(held);
+    g_free(url);
+    test_server_stop(server);
+    g_object_unref(state.cancellable);
+    g_main_loop_unref(state.loop);
+}
+
+struct PriorityTestState {
+    GMainLoop *loop;
+    int calls;
+    int expected;
+};
+
+static void on_priority_test_done(struct MemoryStruct *chunk, long response_code, gpointer user_data) {
+    (void)chunk;
+    (void)response_code;
+    struct PriorityTestState *state = user_data;
+    if (++state->calls == state->expected) {
+        g_main_loop_quit(state->loop);
+    }
+}
+
+static gboolean on_priority_test_timeout(gpointer user_data) {
+    struct PriorityTestState *state = user_data;
+    g_main_loop_quit(state->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void test_network_async_priority() {
+    struct PriorityTestState state = { g_main_loop_new(NULL, FALSE), 0, MAX_REQUESTS_PER_HOST + 1 };
+    gchar *last_url = NULL;
+
+    for (int i = 0; i < state.expected; i++) {
+        g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL, "Async request to *failed*");
+    }
+
+    // One more than the host may run at once: the last one has to queue
+    for (int i = 0; i < state.expected; i++) {
+        g_free(last_url);
+        last_url = g_strdup_printf("http://127.0.0.1:1/media/%d.png", i);
+        fetch_url_async_full(last_url, NULL, "GET", REQUEST_PRIORITY_PREFETCH, NULL, on_priority_test_done, &state);
+    }
+    g_assert_cmpuint(network_async_get_queued_count(), ==, 1);
+
+    // Interactive requests are never held back by the limit
+    network_async_set_priority(last_url, REQUEST_PRIORITY_INTERACTIVE);
+    g_assert_cmpuint(network_async_get_queued_count(), ==, 0);
+    g_free(last_url);
+
+    guint timeout_id = g_timeout_add_seconds(10, on_priority_test_timeout, &state);
+    g_main_loop_run(state.loop);
+    if (state.calls == state.expected) {
+        g_source_remove(timeout_id);
+    }
+
+    g_assert_cmpint(state.calls, ==, state.expected);
+    g_test_assert_expected_messages();
+    g_main_loop_unref(state.loop);
+}
+
+static void test_network_max_streams() {
+    guint original = network_async_get_max_streams();
+    g_assert_cmpuint(original, ==, MAX_CONCURRENT_STREAMS);
+
+    network_async_set_max_streams(8);
+    g_assert_cmpuint(network_async_get_max_streams(), ==, 8);
+
+    // Out of range values are clamped
+    network_async_set_max_streams(0);
+    g_assert_cmpuint(network_async_get_max_streams(), ==, 1);
+    network_async_set_max_streams(100000);
+    g_assert_cmpuint(network_async_get_max_streams(), ==, 256);
+
+    network_async_set_max_streams(original);
+}
+
+static void test_network_stats_normalize() {
+    const struct {
+        const gchar *url;
+        const gchar *endpoint;
+    } cases[] = {
+        {API_BASE_URL "/tweets/123/like", "/api/tweets/{id}/like"},
+        {API_BASE_URL "/tweets/", "/api/tweets/"},
+        {API_BASE_URL "/profile/alice/posts?before=99", "/api/profile/{id}/posts"},
+        {API_BASE_URL "/dm/conversations/abc/messages", "/api/dm/conversations/{id}/messages"},
+        {API_BASE_URL "/search/posts?q=hello", "/api/search/posts"},
+        {BASE_DOMAIN "/api/uploads/avatar.png", "/api/uploads/{file}"},
+        {"https://cdn.example.com/a/b.png", "cdn.example.com/*"},
+        {NULL, NULL}
+    };
+
+    for (int i = 0; cases[i].url != NULL; i++) {
+        gchar *endpoint = network_stats_normalize_endpoint(cases[i].url);
+        g_assert_cmpstr(endpoint, ==, cases[i].endpoint);
+        g_free(endpoint);
+    }
+}
+
+static void test_network_stats_record() {
+    struct EndpointStats stats;
+    network_stats_reset();
+    g_assert_false(network_stats_get("/api/tweets/{id}/like", &stats));
+
+    network_stats_record_transfer(API_BASE_URL "/tweets/1/like", 100, 400);
+    network_stats_record_transfer(API_BASE_URL "/tweets/2/like", 50, 200);
+
+    g_assert_true(network_stats_get("/api/tweets/{id}/like", &stats));
+    g_assert_cmpuint(stats.requests, ==, 2);
+    g_assert_cmpuint(stats.wire_bytes, ==, 150);
+    g_assert_cmpuint(stats.decoded_bytes, ==, 600);
+    network_stats_reset();
+}
+
+static void test_network_stats_timings() {
+    struct EndpointStats stats;
+    guint64 phase_us[NETWORK_PHASE_COUNT] = { 0 };
+    network_stats_reset();
+
+    // 0.5 ms lands in bucket 0, 3 ms in [2, 4) ms, 40 ms in [32, 64) ms
+    phase_us[NETWORK_PHASE_DNS] = 500;
+    phase_us[NETWORK_PHASE_TOTAL] = 3000;
+    network_stats_record_timings(API_BASE_URL "/tweets/1/like", 10, phase_us, TRUE);
+    phase_us[NETWORK_PHASE_TOTAL] = 40000;
+    network_stats_record_timings(API_BASE_URL "/tweets/2/like", 10, phase_us, FALSE);
+
+    g_assert_true(network_stats_get("/api/tweets/{id}/like", &stats));
+    g_assert_cmpuint(stats.sent_bytes, ==, 20);
+    // Handshake phases only count for new connections
+    g_assert_cmpuint(stats.phases[NETWORK_PHASE_DNS].count, ==, 1);
+    g_assert_cmpuint(stats.phases[NETWORK_PHASE_DNS].buckets[0], ==, 1);
+    g_assert_cmpuint(stats.phases[NETWORK_PHASE_TOTAL].count, ==, 2);
+    g_assert_cmpuint(stats.phases[NETWORK_PHASE_TOTAL].buckets[2], ==, 1);
+    g_assert_cmpuint(stats.phases[NETWORK_PHASE_TOTAL].buckets[6], ==, 1);
+    g_assert_cmpuint(network_stats_histogram_percentile(&stats.phases[NETWORK_PHASE_TOTAL], 0.5), ==, 4000);
+    g_assert_cmpuint(network_stats_histogram_percentile(&stats.phases[NETWORK_PHASE_TOTAL], 0.95), ==, 40000);
+
+    gchar *json = network_stats_to_json();
+    JsonParser *parser = json_parser_new();
+    g_assert_true(json_parser_load_from_data(parser, json, -1, NULL));
+    JsonObject *root = json_node_get_object(json_parser_get_root(parser));
+    JsonArray *endpoints = json_object_get_array_member(root, "endpoints");
+    g_assert_cmpuint(json_array_get_length(endpoints), ==, 1);
+    JsonObject *endpoint = json_array_get_object_element(endpoints, 0);
+    g_assert_cmpstr(json_object_get_string_member(endpoint, "endpoint"), ==, "/api/tweets/{id}/like");
+    JsonObject *phases = json_object_get_object_member(endpoint, "phases");
+    g_assert_cmpint(json_object_get_int_member(json_object_get_object_member(phases, "total"), "count"), ==, 2);
+    g_object_unref(parser);
+    g_free(json);
+    network_stats_reset();
+}
+
+static void test_memory_pool_reuse() {
+    struct MemoryStruct chunk;
+    guint64 allocations = 0, reuses = 0, reuses_before = 0;
+    memory_struct_init(&chunk);
+
+    // Grow well past the smallest size class and check nothing is lost
+    for (int i = 0; i < 1000; i++) {
+        g_assert_true(memory_struct_append(&chunk, "0123456789", 10));
+    }
+    g_assert_cmpuint(chunk.size, ==, 10000);
+    g_assert_cmpuint(chunk.capacity, >, chunk.size);
+    g_assert_cmpint(chunk.memory[chunk.size], ==, '\0');
+    g_assert_true(strncmp(chunk.memory + 9990, "0123456789", 10) == 0);
+
+    size_t capacity = chunk.capacity;
+    memory_struct_release(&chunk);
+    g_assert_null(chunk.memory);
+
+    // A buffer of the same class comes back from the pool
+    memory_pool_get_stats(&allocations, &reuses_before);
+    g_assert_true(memory_struct_reserve(&chunk, capacity - 1));
+    memory_pool_get_stats(&allocations, &reuses);
+    g_assert_cmpuint(reuses, ==, reuses_before + 1);
+    g_assert_cmpuint(chunk.size, ==, 0);
+    g_assert_cmpstr(chunk.memory, ==, "");
+
+    memory_struct_release(&chunk);
+    memory_pool_trim();
+}
+
+static void test_memory_arena() {
+    struct MemoryArena arena;
+    guint64 allocations = 0, allocations_before = 0, reuses = 0, reuses_before = 0;
+    memory_arena_init(&arena);
+
+    // Small allocations are aligned, zeroed and packed into a few blocks
+    memory_pool_get_stats(&allocations_before, NULL);
+    struct Tweet *tweets[500];
+    for (int i = 0; i < 500; i++) {
+        tweets[i] = memory_arena_alloc(&arena, sizeof(struct Tweet));
+        g_assert_cmpuint(GPOINTER_TO_SIZE(tweets[i]) % 8, ==, 0);
+        g_assert_null(tweets[i]->content);
+        tweets[i]->content = memory_arena_strdup(&arena, "0123456789");
+    }
+    memory_pool_get_stats(&allocations, NULL);
+    g_assert_cmpuint(allocations - allocations_before, <, 10);
+    g_assert_cmpstr(tweets[0]->content, ==, "0123456789");
+    g_assert_cmpstr(tweets[499]->content, ==, "0123456789");
+
+    // Larger than any block so far: it gets its own
+    gchar *big = memory_arena_alloc(&arena, 1024 * 1024);
+    big[1024 * 1024 - 1] = 'x';
+    g_assert_cmpstr(memory_arena_strndup(&arena, "abcdef", 3), ==, "abc");
+    g_assert_null(memory_arena_strdup(&arena, NULL));
+
+    // Releasing hands the blocks back to the pool for the next arena
+    memory_arena_release(&arena);
+    g_assert_null(arena.block);
+    memory_pool_get_stats(NULL, &reuses_before);
+    memory_arena_alloc(&arena, 16);
+    memory_pool_get_stats(NULL, &reuses);
+    g_assert_cmpuint(reuses, ==, reuses_before + 1);
+
+    memory_arena_release(&arena);
+    memory_arena_release(&arena);
+    memory_pool_trim();
+}
+
+#define INTERN_THREAD_NAMES 200
+
+static gpointer intern_names_thread(gpointer data) {
+    const gchar **interned = data;
+    for (int i = 0; i < INTERN_THREAD_NAMES; i++) {
+        gchar *name = g_strdup_printf("intern-thread-user%d", i);
+        interned[i] = string_intern(name);
+        g_free(name);
+    }
+    return NULL;
+}
+
+static void test_string_intern() {
+    struct StringInternStats before, after;
+    string_intern_get_stats(&before);
+
+    // Equal strings from different buffers share one copy
+    gchar *copy = g_strdup("intern-alice");
+    const gchar *alice = string_intern("intern-alice");
+    g_assert_true(string_intern(copy) == alice);
+    g_assert_true(alice != copy);
+    g_assert_cmpstr(alice, ==, "intern-alice");
+    g_assert_true(string_intern_len("intern-alice and more", 12) == alice);
+    g_assert_true(string_intern("intern-bob") != alice);
+    g_assert_null(string_intern(NULL));
+    g_free(copy);
+
+    string_intern_get_stats(&after);
+    g_assert_cmpuint(after.strings - before.strings, ==, 2);
+    g_assert_cmpuint(after.lookups - before.lookups, ==, 4);
+    g_assert_cmpuint(after.hits - before.hits, ==, 2);
+
+    // Threads racing on the same names all get the same pointers
+    const gchar *interned[4][INTERN_THREAD_NAMES];
+    GThread *threads[4];
+    for (int t = 0; t < 4; t++) {
+        threads[t] = g_thread_new("intern", intern_names_thread, interned[t]);
+    }
+    for (int t = 0; t < 4; t++) {
+        g_thread_join(threads[t]);
+    }
+    for (int i = 0; i < INTERN_THREAD_NAMES; i++) {
+        for (int t = 1; t < 4; t++) {
+            g_assert_true(interned[t][i] == interned[0][i]);
+        }
+    }
+
+    // Authors of separate pages point at the same strings
+    const char *json_input = "{\"posts\": [{\"id\": \"1\", \"author\": {\"name\": \"Intern\", \"username\": \"intern\", \"avatar\": \"/a.png\"}}]}";
+    struct TweetPage *first = parse_tweets(json_input);
+    struct TweetPage *second = parse_tweets(json_input);
+    struct Tweet *a = g_ptr_array_index(first->tweets, 0);
+    struct Tweet *b = g_ptr_array_index(second->tweets, 0);
+    g_assert_true(a->author_username == b->author_username);
+    g_assert_true(a->author_name == b->author_name);
+    g_assert_true(a->author_avatar == string_intern("/a.png"));
+    tweet_page_unref(first);
+    tweet_page_unref(second);
+}
+
+static void test_network_cache_max_age() {
+    gboolean no_store = FALSE;
+    g_assert_cmpint(network_cache_parse_max_age("public, max-age=300", &no_store), ==, 300);
+    g_assert_false(no_store);
+    g_assert_cmpint(network_cache_parse_max_age("max-age=300, no-cache", &no_store), ==, 0);
+    g_assert_cmpint(network_cache_parse_max_age("no-store", &no_store), ==, 0);
+    g_assert_true(no_store);
+    g_assert_cmpint(network_cache_parse_max_age(NULL, &no_store), ==, 0);
+    g_assert_false(no_store);
+
+    g_assert_true(network_cache_is_cacheable_request(NULL, "GET"));
+    g_assert_false(network_cache_is_cacheable_request(NULL, "DELETE"));
+    g_assert_false(network_cache_is_cacheable_request("{}", "GET"));
+}
+
+static void test_network_cache_revalidate() {
+    const gchar *url = API_BASE_URL "/tweets/1";
+    struct MemoryStruct chunk;
+    gchar *etag = NULL, *last_modified = NULL;
+    gchar *saved_token = g_auth_token;
+
+    network_cache_clear();
+    memory_struct_init(&chunk);
+    g_auth_token = NULL;
+
+    // Without a validator or a max-age there is nothing to revalidate with
+    network_cache_store(url, NULL, NULL, 0, "{}", 2);
+    g_assert_false(network_cache_get_validators(url, &etag, &last_modified));
+
+    network_cache_store(url, "\"abc\"", NULL, 0, "{\"id\":1}", 8);
+    g_assert_true(network_cache_get_validators(url, &etag, &last_modified));
+    g_assert_cmpstr(etag, ==, "\"abc\"");
+    g_assert_null(last_modified);
+    g_free(etag);
+
+    // Stale entries are never served without asking the server
+    g_assert_false(network_cache_lookup_fresh(url, &chunk));
+    g_assert_true(network_cache_revalidated(url, 60, &chunk));
+    g_assert_cmpstr(chunk.memory, ==, "{\"id\":1}");
+    g_assert_true(network_cache_lookup_fresh(url, &chunk));
+    g_assert_cmpuint(chunk.size, ==, 8);
+
+    // A different user must not see this response
+    g_auth_token = "other-token";
+    g_assert_false(network_cache_lookup_fresh(url, &chunk));
+    g_auth_token = saved_token;
+
+    memory_struct_release(&chunk);
+    network_cache_clear();
+}
+
+// Answers a conditional request with a 304, but evicts the cache entry first,
+// as if another response had pushed it out while the request was in flight
+static void serve_evicted_not_modified(GSocketConnection *connection, const gchar *request, gpointer user_data) {
+    gint *conditional_requests = user_data;
+
+    if (strstr(request, "If-None-Match:")) {
+        g_atomic_int_inc(conditional_requests);
+        network_cache_clear();
+        test_server_write(connection, "HTTP/1.1 304 Not Modified\r\nConnection: close\r\n\r\n");
+    } else {
+        test_server_write(connection, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                      "ETag: \"v2\"\r\nContent-Length: 8\r\nConnection: close\r\n\r\n{\"id\":2}");
+    }
+}
+
+struct EvictedTestState {
+    GMainLoop *loop;
+    gchar *body;
+    long response_code;
+};
+
+static void on_evicted_test_done(struct MemoryStruct *chunk, long response_code, gpointer user_data) {
+    struct EvictedTestState *state = user_data;
+    state->body = chunk ? g_strndup(chunk->memory, chunk->size) : NULL;
+    state->response_code = response_code;
+    g_main_loop_quit(state->loop);
+}
+
+static gboolean on_evicted_test_timeout(gpointer user_data) {
+    struct EvictedTestState *state = user_data;
+    g_main_loop_quit(state->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void test_network_cache_evicted() {
+    gint conditional_requests = 0;
+    struct TestServer *server = test_server_start(serve_evicted_not_modified, &conditional_requests);
+    gchar *url = test_server_url(server, "/tweets/1");
+    struct EvictedTestState state = { g_main_loop_new(NULL, FALSE), NULL, 0 };
+    struct MemoryStruct chunk;
+    long response_code = 0;
+    gchar *saved_token = g_auth_token;
+
+    g_auth_token = NULL;
+    memory_struct_init(&chunk);
+
+    // The 304 has no cached body to go with it, so the request is repeated
+    // without validators instead of handing out an empty 304
+    network_cache_clear();
+    network_cache_store(url, "\"v1\"", NULL, 0, "{\"id\":1}", 8);
+    g_assert_true(fetch_url_internal(url, &chunk, NULL, "GET", &response_code));
+    g_assert_cmpint(response_code, ==, 200);
+    g_assert_cmpstr(chunk.memory, ==, "{\"id\":2}");
+    g_assert_cmpint(g_atomic_int_get(&server->requests), ==, 2);
+    g_assert_cmpint(g_atomic_int_get(&conditional_requests), ==, 1);
+
+    // Same for the async engine
+    network_cache_clear();
+    network_cache_store(url, "\"v1\"", NULL, 0, "{\"id\":1}", 8);
+    fetch_url_async_full(url, NULL, "GET", REQUEST_PRIORITY_FEED, NULL, on_evicted_test_done, &state);
+    guint timeout_id = g_timeout_add_seconds(10, on_evicted_test_timeout, &state);
+    g_main_loop_run(state.loop);
+    if (state.body) {
+        g_source_remove(timeout_id);
+    }
+
+    g_assert_cmpint(state.response_code, ==, 200);
+    g_assert_cmpstr(state.body, ==, "{\"id\":2}");
+    g_assert_cmpint(g_atomic_int_get(&server->requests), ==, 4);
+    g_assert_cmpint(g_atomic_int_get(&conditional_requests), ==, 2);
+
+    g_auth_token = saved_token;
+    g_free(state.body);
+    g_main_loop_unref(state.loop);
+    memory_struct_release(&chunk);
+    g_free(url);
+    test_server_stop(server);
+    network_cache_clear();
+}
+
+static void serve_unavailable(GSocketConnection *connection, const gchar *request, gpointer user_data) {
+    (void)request;
+    (void)user_data;
+    test_server_write(connection, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+}
+
+static void test_outbox_give_up() {
+    struct TestServer *server = test_server_start(serve_unavailable, NULL);
+    gchar *url = test_server_url(server, "/tweets/");
+    gchar *path = get_config_file_path("outbox.json");
+    gchar *saved_token = g_auth_token;
+    gchar *journal = NULL;
+
+    // Left over from an earlier run, and queued long enough ago that the
+    // first refusal is the last one
+    gchar *old_journal = g_strdup_printf("[{\"url\": \"%s\", \"method\": \"POST\", \"body\": \"{}\", "
+                                         "\"coalesce\": 0, \"attempts\": 0, \"queued_at\": %" G_GINT64_FORMAT "}]",
+                                         url, g_get_real_time() - (gint64)2 * OUTBOX_MAX_AGE_SECONDS * G_USEC_PER_SEC);
+    g_assert_true(g_file_set_contents(path, old_journal, -1, NULL));
+
+    g_auth_token = "outbox-test-token";
+    g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Outbox: giving up on*");
+    outbox_init();
+    g_assert_cmpuint(outbox_get_pending_count(), ==, 1);
+
+    gint64 deadline = g_get_monotonic_time() + 10 * G_USEC_PER_SEC;
+    while (outbox_get_pending_count() > 0 && g_get_monotonic_time() < deadline) {
+        g_main_context_iteration(NULL, FALSE);
+    }
+    g_test_assert_expected_messages();
+
+    // Dropped after one try instead of blocking the queue
+    g_assert_cmpuint(outbox_get_pending_count(), ==, 0);
+    g_assert_cmpint(g_atomic_int_get(&server->requests), ==, 1);
+    outbox_flush();
+    g_assert_true(g_file_get_contents(path, &journal, NULL, NULL));
+    g_assert_null(strstr(journal, "/tweets/"));
+
+    g_auth_token = saved_token;
+    g_free(journal);
+    g_free(old_journal);
+    g_free(path);
+    g_free(url);
+    test_server_stop(server);
+}
+
 static void test_integration_login() {
     const gchar *username = g_getenv("USERNAME");
     const gchar *password = g_getenv("PASSWORD");
@@ -438,17 +1809,49 @@ int main(int argc, char** argv) {
     g_test_add_func("/parsetweets/note_danger", test_parse_tweets_with_danger_note);
     g_test_add_func("/parsetweets/note_info", test_parse_tweets_with_info_note);
     g_test_add_func("/parsetweets/attachments", test_parse_tweets_with_attachments);
+    g_test_add_func("/parsetweets/streaming", test_parse_tweets_streaming);
     g_test_add_func("/parselogin/basic", test_parse_login_response);
     g_test_add_func("/constructpayload/basic", test_construct_tweet_payload);
     g_test_add_func("/session/persistence", test_session_persistence);
     g_test_add_func("/parseprofile/basic", test_parse_profile);
     g_test_add_func("/parseprofile/replies", test_parse_profile_replies);
+    g_test_add_func("/parseprofile/page", test_parse_profile_page);
     g_test_add_func("/parseusers/basic", test_parse_users);
     g_test_add_func("/parsenotifications/basic", test_parse_notifications);
     g_test_add_func("/parseconversations/basic", test_parse_conversations);
     g_test_add_func("/parsemessages/basic", test_parse_messages);
+    g_test_add_func("/parsemessages/created", test_parse_created_objects);
     g_test_add_func("/parsetweetdetails/basic", test_parse_tweet_details);
     g_test_add_func("/challenge/solver", test_challenge_solver);
+    g_test_add_func("/challenge/golden", test_challenge_solver_golden);
+    g_test_add_func("/challenge/vectors", test_challenge_vectors);
+    g_test_add_func("/challenge/pow_scan", test_challenge_pow_scan);
+    g_test_add_func("/challenge/benchmark", test_challenge_pow_benchmark);
+    g_test_add_func("/sha256/vectors", test_sha256_vectors);
+    g_test_add_func("/sha256/kernels", test_sha256_kernels);
+    g_test_add_func("/network/pool", test_network_pool);
+    g_test_add_func("/network/async_failure", test_network_async_failure);
+    g_test_add_func("/network/async_coalesce", test_network_async_coalesce);
+    g_test_add_func("/network/async_cancel", test_network_async_cancel);
+    g_test_add_func("/network/async_cancel_queued", test_network_async_cancel_queued);
+    g_test_add_func("/network/async_cancel_mid_flight", test_network_async_cancel_mid_flight);
+    g_test_add_func("/network/async_priority", test_network_async_priority);
+    g_test_add_func("/network/max_streams", test_network_max_streams);
+    g_test_add_func("/network/challenge_prescan", test_network_challenge_prescan);
+    g_test_add_func("/networkstats/normalize", test_network_stats_normalize);
+    g_test_add_func("/networkstats/record", test_network_stats_record);
+    g_test_add_func("/networkstats/timings", test_network_stats_timings);
+    g_test_add_func("/memorypool/reuse", test_memory_pool_reuse);
+    g_test_add_func("/memorypool/arena", test_memory_arena);
+    g_test_add_func("/stringintern/basic", test_string_intern);
+    g_test_add_func("/networkcache/max_age", test_network_cache_max_age);
+    g_test_add_func("/networkcache/revalidate", test_network_cache_revalidate);
+    g_test_add_func("/networkcache/evicted", test_network_cache_evicted);
+    g_test_add_func("/captokens/pool", test_cap_tokens_pool);
+    g_test_add_func("/interactions/toggle", test_interactions_toggle);
+    g_test_add_func("/outbox/coalesce", test_outbox_coalesce);
+    g_test_add_func("/outbox/give_up", test_outbox_give_up);
+    g_test_add_func("/executor/lanes", test_executor_lanes);
     
     int result = g_test_run();
     